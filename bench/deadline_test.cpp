@@ -0,0 +1,166 @@
+// deadline_test.cpp
+// Host check of deadline-driven scheduling: EventManager with a SimulatedDeadline on the
+// simulated clock in bench/native. The loop sleeps exactly as long as the timer was armed,
+// so it verifies the armed delays, that each event is delivered on its first wake-up, and
+// that schedule changes cut a wait short. Exits non-zero when a check fails.
+// Build: g++ -O2 -std=gnu++17 -Ibench/native -Iinclude bench/deadline_test.cpp src/EventManager.cpp
+//        src/TimeService.cpp src/SoftClock.cpp src/ScheduleImage.cpp src/LabelTable.cpp
+//        src/EventDispatcher.cpp src/DeadlineTimer.cpp -o deadline_test
+#include <Arduino.h>
+#include <RTClib.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "CivilTime.h"
+#include "DeadlineTimer.h"
+#include "EventManager.h"
+#include "TimeService.h"
+
+namespace {
+
+constexpr uint32_t StartEpoch = CivilTime::toEpoch(2024, 7, 20, 6, 0, 0);
+
+RTC_DS3231 rtc;
+TimeService timeService(rtc);
+EventManager eventManager(timeService);
+SimulatedDeadline deadline;
+
+struct Delivery {
+    TimeCode timeCode;
+    uint64_t atMs;
+};
+
+std::vector<Delivery> deliveries;
+int failures = 0;
+
+void recordDelivery(const ScheduledEvent& event, void*) {
+    deliveries.push_back(Delivery{event.timeCode, timeService.nowMs()});
+}
+
+void expect(bool condition, const char* what) {
+    if (condition) return;
+    std::fprintf(stderr, "FAIL: %s\n", what);
+    ++failures;
+}
+
+// One pass of the dispatch loop
+void pass() {
+    timeService.update();
+    eventManager.update();
+}
+
+// Sleeps until the armed deadline, as waitForNextEvent() does on the device. Returns the
+// sleep in ms, or -1 when waitForNextEvent() returned at once because the schedule changed.
+int64_t sleepUntilDeadline() {
+    uint32_t waits = deadline.getWaitCount();
+    eventManager.waitForNextEvent(0xFFFFFFFF);
+    if (deadline.getWaitCount() == waits) return -1;
+    uint32_t ms = deadline.isArmed() ? deadline.getRemainingMs() : 0;
+    NativeClock::advanceMs(ms);
+    deadline.advance(ms);
+    return ms;
+}
+
+bool addAt(TimeCode timeCode, uint8_t scenario) {
+    CivilTime when = CivilTime::fromEpoch(timeCode);
+    return eventManager.addEvent(when.year, when.month, when.day, when.hour, when.minute, when.second, scenario, 1);
+}
+
+uint64_t msOf(TimeCode timeCode) {
+    return static_cast<uint64_t>(timeCode) * 1000;
+}
+
+void testArmsForNextEvent() {
+    TimeCode now = timeService.now();
+    expect(addAt(now + 90, 1), "event accepted");
+    pass();
+    expect(deadline.isArmed(), "timer armed for a scheduled event");
+    expect(deadline.getRemainingMs() == 90000, "timer armed for the delay to the event");
+
+    uint32_t armed = deadline.getArmCount();
+    expect(sleepUntilDeadline() == 90000, "loop sleeps until the event");
+    pass();
+    expect(deliveries.size() == 1 && deliveries[0].timeCode == now + 90, "event delivered on the wake-up");
+    expect(!deliveries.empty() && deliveries[0].atMs == msOf(now + 90), "event delivered on its second");
+    expect(deadline.getArmCount() == armed && !deadline.isArmed(), "empty schedule disarms the timer");
+    expect(sleepUntilDeadline() == 0, "nothing scheduled: the loop waits without a deadline");
+}
+
+void testEditShortensWait() {
+    deliveries.clear();
+    TimeCode now = timeService.now();
+    addAt(now + 600, 2);
+    expect(sleepUntilDeadline() == -1, "schedule change skips the wait");
+    pass();
+    expect(deadline.getRemainingMs() == 600000, "timer armed ten minutes out");
+
+    // Part of the way through the wait, an earlier event is added from another task
+    NativeClock::advanceMs(1000);
+    deadline.advance(1000);
+    addAt(now + 30, 3);
+    expect(sleepUntilDeadline() == -1, "earlier event cuts the wait short");
+    pass();
+    expect(deadline.getRemainingMs() == 29000, "timer re-armed for the earlier event");
+
+    expect(sleepUntilDeadline() == 29000, "loop sleeps until the earlier event");
+    pass();
+    expect(deliveries.size() == 1 && deliveries[0].timeCode == now + 30, "earlier event delivered first");
+    expect(deadline.getRemainingMs() == 570000, "timer re-armed for the remaining event");
+    sleepUntilDeadline();
+    pass();
+    expect(deliveries.size() == 2 && deliveries[1].timeCode == now + 600, "remaining event delivered");
+}
+
+void testLongAndPreciseDelays() {
+    deliveries.clear();
+    TimeCode now = timeService.now();
+    addAt(now + 3 * 3600, 4);
+    pass();
+    expect(deadline.getRemainingMs() == 3600000, "long waits are capped at an hour");
+
+    eventManager.addEventAfter(250, 5, 1, "Amber");
+    pass();
+    expect(deadline.getRemainingMs() == 250, "millisecond event arms a sub-second delay");
+    sleepUntilDeadline();
+    pass();
+    expect(deliveries.size() == 1 && deliveries[0].atMs == msOf(now) + 250,
+           "millisecond event delivered on its millisecond");
+
+    uint32_t wakeUps = 0;
+    while (deliveries.size() < 2 && wakeUps < 10) {
+        sleepUntilDeadline();
+        pass();
+        ++wakeUps;
+    }
+    expect(wakeUps == 3, "three-hour wait takes three wake-ups");
+    expect(deliveries.size() == 2 && deliveries[1].atMs == msOf(now + 3 * 3600), "far event delivered on its second");
+}
+
+}  // namespace
+
+int main() {
+    NativeClock::nowUs = 0;
+    rtc.adjust(DateTime(StartEpoch));
+    timeService.begin();
+    // Lock onto the RTC's seconds edge, then start every test on a whole second
+    for (int i = 0; i < 150; i++) {
+        NativeClock::advanceMs(SoftClock::EdgePollMs);
+        timeService.update();
+    }
+    NativeClock::advanceMs(timeService.msUntilNextSecond());
+
+    eventManager.begin();
+    eventManager.setDeadlineTimer(&deadline);
+    eventManager.getDispatcher().subscribe(recordDelivery, nullptr, EventFilter::all(), "test");
+
+    testArmsForNextEvent();
+    testEditShortensWait();
+    testLongAndPreciseDelays();
+
+    if (failures != 0) {
+        std::fprintf(stderr, "%d deadline checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("deadline checks passed\n");
+    return EXIT_SUCCESS;
+}
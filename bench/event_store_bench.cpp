@@ -0,0 +1,157 @@
+// event_store_bench.cpp
+// Host-side comparison of EventStore against the std::set<Event> schedule it replaced.
+// Build: g++ -O2 -std=gnu++17 -Iinclude bench/event_store_bench.cpp src/LabelTable.cpp -o event_store_bench
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "EventStore.h"
+
+namespace {
+
+// Mirrors the previous EventManager::Event: a heap-owning description in a tree node.
+struct SetEvent {
+    uint64_t timeCode;
+    uint8_t scenario;
+    uint8_t cycle;
+    std::string description;
+    bool isDaily;
+
+    bool operator<(const SetEvent& other) const {
+        return timeCode < other.timeCode;
+    }
+};
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+struct Result {
+    double insertUs;
+    double batchUs;  // Same events through insertBatch
+
+    double removeUs;
+    double drainUs;
+};
+
+std::vector<TimeCode> makeTimeCodes(size_t n, bool shuffled) {
+    std::vector<TimeCode> codes(n);
+    for (size_t i = 0; i < n; i++) {
+        codes[i] = ScheduledEvent::encodeTime(2024, 7, 20, 0, 0, 0) + i * 7;
+    }
+    if (shuffled) {
+        std::mt19937 rng(1234);
+        std::shuffle(codes.begin(), codes.end(), rng);
+    }
+    return codes;
+}
+
+Result runSet(const std::vector<TimeCode>& codes, const std::vector<TimeCode>& removals) {
+    std::set<SetEvent> events;
+    Result result = {};
+
+    auto start = Clock::now();
+    for (TimeCode code : codes) {
+        events.insert(SetEvent{code, 1, 1, "Morning Rush Hour", false});
+    }
+    result.insertUs = elapsedUs(start);
+
+    start = Clock::now();
+    for (TimeCode code : removals) {
+        for (auto it = events.begin(); it != events.end(); ++it) {
+            if (it->timeCode == code) {
+                events.erase(it);
+                break;
+            }
+        }
+    }
+    result.removeUs = elapsedUs(start);
+
+    start = Clock::now();
+    volatile uint8_t sink = 0;
+    while (!events.empty()) {
+        SetEvent due = *events.begin();
+        sink = sink + due.scenario;
+        events.erase(events.begin());
+    }
+    result.drainUs = elapsedUs(start);
+    return result;
+}
+
+template <size_t Capacity>
+Result runStore(const std::vector<TimeCode>& codes, const std::vector<TimeCode>& removals) {
+    static EventStore<Capacity> events;
+    Result result;
+
+    ScheduledEvent event;
+    event.scenario = 1;
+    event.cycle = 1;
+    event.rule = ScheduledEvent::NoRule;
+    event.setDescription("Morning Rush Hour");
+
+    events.clear();
+    auto start = Clock::now();
+    events.insertBatch(codes.size(), [&](size_t i) {
+        event.timeCode = codes[i];
+        return &event;
+    }, [](size_t, typename EventStore<Capacity>::BatchReject) {}, [](size_t, const ScheduledEvent&) {});
+    result.batchUs = elapsedUs(start);
+
+    events.clear();
+    start = Clock::now();
+    for (TimeCode code : codes) {
+        event.timeCode = code;
+        events.insert(event);
+    }
+    result.insertUs = elapsedUs(start);
+
+    start = Clock::now();
+    for (TimeCode code : removals) {
+        events.erase(code);
+    }
+    result.removeUs = elapsedUs(start);
+
+    start = Clock::now();
+    volatile uint8_t sink = 0;
+    while (const ScheduledEvent* due = events.peek()) {
+        ScheduledEvent copy = *due;
+        sink = sink + copy.scenario;
+        events.popFront();
+    }
+    result.drainUs = elapsedUs(start);
+    return result;
+}
+
+template <size_t Capacity>
+void benchSize(bool shuffled) {
+    std::vector<TimeCode> codes = makeTimeCodes(Capacity, shuffled);
+    std::vector<TimeCode> removals(codes.begin(), codes.begin() + std::max<size_t>(1, Capacity / 10));
+
+    Result set = runSet(codes, removals);
+    Result store = runStore<Capacity>(codes, removals);
+
+    printf("%-6zu %-9s %-10s %12.1f %12s %12.1f %12.1f\n", Capacity, shuffled ? "shuffled" : "ordered",
+           "std::set", set.insertUs, "-", set.removeUs, set.drainUs);
+    printf("%-6zu %-9s %-10s %12.1f %12.1f %12.1f %12.1f\n", Capacity, shuffled ? "shuffled" : "ordered",
+           "EventStore", store.insertUs, store.batchUs, store.removeUs, store.drainUs);
+}
+
+} // namespace
+
+int main() {
+    printf("sizeof(ScheduledEvent) = %zu bytes\n", sizeof(ScheduledEvent));
+    printf("%-6s %-9s %-10s %12s %12s %12s %12s\n", "events", "order", "store", "insert us", "batch us", "remove us",
+           "drain us");
+    benchSize<10>(false);
+    benchSize<10>(true);
+    benchSize<1000>(false);
+    benchSize<1000>(true);
+    benchSize<50000>(false);
+    benchSize<50000>(true);
+    return 0;
+}
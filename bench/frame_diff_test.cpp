@@ -0,0 +1,176 @@
+// frame_diff_test.cpp
+// Randomized host check of FrameDiff against a model of the panel. Each frame is a random
+// edit of the previous one (scattered bytes, runs, whole pages, full noise, nothing); the
+// windows returned by diff() are sent to the model byte by byte in 127-byte data chunks,
+// as OLEDManager::sendWindow() does. The model must then match the frame, the windows must
+// stay on the panel, and cost() must equal the bytes the chunked transfer puts on the wire
+// and never exceed a full frame. Exits non-zero when a check fails.
+// Build: g++ -O2 -std=gnu++17 -Iinclude bench/frame_diff_test.cpp src/FrameDiff.cpp -o frame_diff_test
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include "FrameDiff.h"
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, const char* what) {
+    if (condition) return;
+    std::fprintf(stderr, "FAIL: %s\n", what);
+    ++failures;
+}
+
+struct Panel {
+    uint8_t width;
+    uint8_t pages;
+    uint8_t ram[FRAME_DIFF_MAX_BYTES];
+    uint32_t largestChunk;
+
+    // Sends one window's data the way OLEDManager::sendWindow() does; returns the wire bytes
+    uint32_t send(const FlushWindow& window, const uint8_t* frame) {
+        uint32_t wire = FrameDiff::CommandBytes;
+        uint32_t inChunk = FrameDiff::ChunkBytes;
+        for (uint8_t page = window.firstPage; page <= window.lastPage; page++) {
+            for (uint8_t column = window.firstColumn; column <= window.lastColumn; column++) {
+                if (inChunk == FrameDiff::ChunkBytes) {
+                    wire += FrameDiff::ChunkOverhead;
+                    inChunk = 0;
+                }
+                ram[page * width + column] = frame[page * width + column];
+                ++inChunk;
+                ++wire;
+                if (inChunk > largestChunk) largestChunk = inChunk;
+            }
+        }
+        return wire;
+    }
+};
+
+bool onPanel(const FlushWindow& window, uint8_t width, uint8_t pages) {
+    return window.firstPage <= window.lastPage && window.lastPage < pages && window.firstColumn <= window.lastColumn &&
+           window.lastColumn < width;
+}
+
+// A random edit of the frame, from nothing to a full repaint
+void mutate(uint8_t* frame, uint8_t width, uint8_t pages, std::mt19937& rng) {
+    size_t bytes = static_cast<size_t>(width) * pages;
+    std::uniform_int_distribution<uint32_t> any(0, 0xFFFFFFFF);
+    switch (any(rng) % 6) {
+    case 0:  // Nothing changed
+        break;
+    case 1:  // A few scattered bytes, e.g. blinking markers
+        for (uint32_t i = any(rng) % 8 + 1; i > 0; i--) frame[any(rng) % bytes] ^= static_cast<uint8_t>(any(rng) | 1);
+        break;
+    case 2: {  // Runs on a few pages, e.g. redrawn digits
+        for (uint32_t i = any(rng) % 4 + 1; i > 0; i--) {
+            uint8_t page = static_cast<uint8_t>(any(rng) % pages);
+            uint8_t start = static_cast<uint8_t>(any(rng) % width);
+            uint8_t length = static_cast<uint8_t>(any(rng) % (width - start) + 1);
+            for (uint8_t c = start; c < start + length; c++) frame[page * width + c] = static_cast<uint8_t>(any(rng));
+        }
+        break;
+    }
+    case 3: {  // Whole pages
+        for (uint32_t i = any(rng) % pages + 1; i > 0; i--) {
+            uint8_t page = static_cast<uint8_t>(any(rng) % pages);
+            for (uint8_t c = 0; c < width; c++) frame[page * width + c] = static_cast<uint8_t>(any(rng));
+        }
+        break;
+    }
+    case 4:  // Dense scatter: more runs than there are windows
+        for (uint32_t i = 0; i < bytes / 4; i++) frame[any(rng) % bytes] ^= static_cast<uint8_t>(any(rng) | 1);
+        break;
+    default:  // Full noise
+        for (size_t i = 0; i < bytes; i++) frame[i] = static_cast<uint8_t>(any(rng));
+        break;
+    }
+}
+
+void checkPanel(uint8_t width, uint8_t height, uint32_t seed) {
+    std::mt19937 rng(seed);
+    FrameDiff diff(width, height);
+    uint8_t pages = static_cast<uint8_t>((height + 7) / 8);
+    size_t bytes = static_cast<size_t>(width) * pages;
+    const FlushWindow fullWindow = {0, static_cast<uint8_t>(pages - 1), 0, static_cast<uint8_t>(width - 1)};
+
+    static Panel panel;
+    panel.width = width;
+    panel.pages = pages;
+    panel.largestChunk = 0;
+    memset(panel.ram, 0xA5, sizeof(panel.ram));  // Unknown content at power-up
+
+    uint8_t frame[FRAME_DIFF_MAX_BYTES] = {};
+    FlushWindow windows[FRAME_DIFF_WINDOW_CAPACITY];
+    bool covered = true, bounded = true, singlePage = true, costed = true, cheaper = true, quiet = true;
+    bool invalidated = true;
+    uint32_t partial = 0;
+    for (uint32_t round = 0; round < 20000; round++) {
+        uint8_t previous[FRAME_DIFF_MAX_BYTES];
+        memcpy(previous, frame, bytes);
+        mutate(frame, width, pages, rng);
+        bool changed = memcmp(previous, frame, bytes) != 0;
+        bool invalidate = round % 997 == 0 && round > 0;
+        if (invalidate) diff.invalidate();
+
+        uint8_t count = diff.diff(frame, windows);
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            const FlushWindow& window = windows[i];
+            if (!onPanel(window, width, pages)) {
+                bounded = false;
+                continue;
+            }
+            bool full = memcmp(&window, &fullWindow, sizeof(window)) == 0;
+            if (window.firstPage != window.lastPage && !full) singlePage = false;
+            uint32_t wire = panel.send(window, frame);
+            if (wire != FrameDiff::cost(window)) costed = false;
+            total += wire;
+        }
+        covered &= memcmp(panel.ram, frame, bytes) == 0;
+        cheaper &= total <= diff.fullFrameCost();
+        if (round == 0 || invalidate) {
+            invalidated &= count == 1 && memcmp(&windows[0], &fullWindow, sizeof(fullWindow)) == 0;
+        } else if (!changed) {
+            quiet &= count == 0;
+        }
+        if (count > 1) ++partial;
+    }
+
+    char what[96];
+    std::snprintf(what, sizeof(what), "%ux%u: windows cover every changed byte", width, height);
+    expect(covered, what);
+    std::snprintf(what, sizeof(what), "%ux%u: windows stay on the panel", width, height);
+    expect(bounded, what);
+    std::snprintf(what, sizeof(what), "%ux%u: only the full window spans pages", width, height);
+    expect(singlePage, what);
+    std::snprintf(what, sizeof(what), "%ux%u: cost() matches the chunked transfer", width, height);
+    expect(costed, what);
+    std::snprintf(what, sizeof(what), "%ux%u: no data chunk over 127 bytes", width, height);
+    expect(panel.largestChunk <= FrameDiff::ChunkBytes, what);
+    std::snprintf(what, sizeof(what), "%ux%u: a flush never costs more than a full frame", width, height);
+    expect(cheaper, what);
+    std::snprintf(what, sizeof(what), "%ux%u: unchanged frames send nothing", width, height);
+    expect(quiet, what);
+    std::snprintf(what, sizeof(what), "%ux%u: unknown panel content sends the full frame", width, height);
+    expect(invalidated, what);
+    std::snprintf(what, sizeof(what), "%ux%u: partial flushes are exercised", width, height);
+    expect(partial > 1000, what);
+}
+
+}  // namespace
+
+int main() {
+    checkPanel(128, 64, 1);
+    checkPanel(128, 32, 2);
+    checkPanel(96, 16, 3);
+    checkPanel(64, 48, 4);
+
+    if (failures != 0) {
+        std::fprintf(stderr, "%d frame diff checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("frame diff checks passed\n");
+    return EXIT_SUCCESS;
+}
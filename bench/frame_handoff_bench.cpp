@@ -0,0 +1,90 @@
+// frame_handoff_bench.cpp
+// Host-side model of the dual-core split: a scheduler thread publishes 1 KB SSD1306 frames
+// through FrameHandoff while a render thread flushes them at I2C speed.
+// Build: g++ -O2 -std=gnu++17 -pthread -Iinclude bench/frame_handoff_bench.cpp -o frame_handoff_bench
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "FrameHandoff.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Frame {
+    uint64_t publishedNs;
+    uint32_t serial;
+    uint8_t pixels[128 * 64 / 8];
+};
+
+uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(p * (values.size() - 1))];
+}
+
+// flushUs models the render side: ~25 ms for a full frame at 400 kHz I2C, 0 for a spinning reader
+void run(const char* label, uint32_t frames, uint32_t publishIntervalUs, uint32_t flushUs) {
+    static FrameHandoff<Frame> handoff;
+    std::atomic<bool> done(false);
+    std::vector<double> publishNs;
+    std::vector<double> latencyUs;
+    uint32_t rendered = 0;
+    uint32_t torn = 0;
+    publishNs.reserve(frames);
+
+    std::thread render([&] {
+        uint32_t lastSerial = 0;
+        for (;;) {
+            bool finished = done.load(std::memory_order_acquire);
+            if (!handoff.acquire()) {
+                if (finished) break;
+                std::this_thread::yield();
+                continue;
+            }
+            const Frame& frame = handoff.front();
+            latencyUs.push_back((nowNs() - frame.publishedNs) / 1000.0);
+            if (frame.serial <= lastSerial || frame.pixels[0] != frame.pixels[sizeof(frame.pixels) - 1]) ++torn;
+            lastSerial = frame.serial;
+            ++rendered;
+            if (flushUs) std::this_thread::sleep_for(std::chrono::microseconds(flushUs));
+        }
+    });
+
+    auto start = Clock::now();
+    for (uint32_t serial = 1; serial <= frames; ++serial) {
+        uint64_t begin = nowNs();
+        Frame& frame = handoff.back();
+        memset(frame.pixels, static_cast<uint8_t>(serial), sizeof(frame.pixels));
+        frame.serial = serial;
+        frame.publishedNs = nowNs();
+        handoff.publish();
+        publishNs.push_back(static_cast<double>(nowNs() - begin));
+        if (publishIntervalUs) std::this_thread::sleep_for(std::chrono::microseconds(publishIntervalUs));
+    }
+    done.store(true, std::memory_order_release);
+    render.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    printf("%-14s %8u %8u %10.0f %10.0f %12.1f %12.1f %6u\n", label, frames, rendered, frames / seconds,
+           percentile(publishNs, 0.99), percentile(latencyUs, 0.5), percentile(latencyUs, 0.99), torn);
+}
+
+} // namespace
+
+int main() {
+    printf("%-14s %8s %8s %10s %10s %12s %12s %6s\n", "case", "frames", "rendered", "publish/s",
+           "p99 pub ns", "p50 lat us", "p99 lat us", "torn");
+    run("spin reader", 200000, 0, 0);
+    run("i2c flush", 2000, 1000, 25000);
+    run("1 Hz clock", 5, 1000000, 25000);
+    return 0;
+}
@@ -0,0 +1,255 @@
+// journal_test.cpp
+// Host check of ScheduleJournal over MemoryJournalStorage, with the same NOR write rules
+// as the flash partition. Journals edits and deliveries, checks that the callbacks only
+// queue them, tears the last record as a reset mid-write would, and replays into a fresh
+// EventManager. Also rolls the ring through several snapshots and overflows the queue.
+// Exits non-zero when a check fails.
+// Build: g++ -O2 -std=gnu++17 -Ibench/native -Iinclude bench/journal_test.cpp src/ScheduleJournal.cpp
+//        src/EventManager.cpp src/TimeService.cpp src/SoftClock.cpp src/ScheduleImage.cpp
+//        src/LabelTable.cpp src/EventDispatcher.cpp src/DeadlineTimer.cpp -o journal_test
+#include <Arduino.h>
+#include <RTClib.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "CivilTime.h"
+#include "EventManager.h"
+#include "ScheduleJournal.h"
+#include "TimeService.h"
+
+namespace {
+
+constexpr uint32_t StartEpoch = CivilTime::toEpoch(2024, 7, 20, 6, 0, 0);
+constexpr uint32_t FlashSize = 16 * JOURNAL_SECTOR_SIZE;
+
+RTC_DS3231 rtc;
+TimeService timeService(rtc);
+EventManager live(timeService);
+EventManager restored(timeService);
+uint8_t flash[FlashSize];
+MemoryJournalStorage storage(flash, FlashSize);
+int failures = 0;
+
+void expect(bool condition, const char* what) {
+    if (condition) return;
+    std::fprintf(stderr, "FAIL: %s\n", what);
+    ++failures;
+}
+
+using Entry = std::tuple<TimeCode, uint8_t, uint8_t, std::string>;
+
+// Every overlay event, recurring occurrences included, sorted by time
+std::vector<Entry> contents(const EventManager& manager) {
+    std::vector<Entry> entries;
+    for (uint16_t scenario = 0; scenario < 256; scenario++) {
+        for (const ScheduledEvent& event : manager.scenarioEvents(static_cast<uint8_t>(scenario))) {
+            entries.emplace_back(event.timeCode, event.scenario, event.cycle, event.description());
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+
+bool addAt(EventManager& manager, TimeCode timeCode, uint8_t scenario, uint8_t cycle, const char* description) {
+    CivilTime when = CivilTime::fromEpoch(timeCode);
+    return manager.addEvent(when.year, when.month, when.day, when.hour, when.minute, when.second, scenario, cycle,
+                            description);
+}
+
+// Replays the storage into the restored manager, as a restart would
+bool restart(ScheduleJournal::Stats* stats = nullptr) {
+    restored.clearEvents();
+    for (uint8_t id = 0; id < EVENT_RULE_CAPACITY; id++) restored.removeRule(id);
+    ScheduleJournal journal(restored, storage);
+    if (!journal.begin()) return false;
+    auto start = std::chrono::steady_clock::now();
+    bool replayed = journal.replay();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (stats != nullptr) {
+        *stats = journal.getStats();
+        stats->replayUs = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    }
+    return replayed;
+}
+
+void testTornRecord() {
+    memset(flash, 0xFF, sizeof(flash));
+    static ScheduleJournal journal(live, storage);  // Stays subscribed to the dispatcher
+    expect(journal.begin(), "blank storage is accepted");
+    expect(journal.attach(live.getDispatcher()), "journal attaches");
+    journal.flush();
+    expect(journal.hasSnapshot(), "attach writes the first snapshot");
+
+    TimeCode now = timeService.now();
+    for (uint32_t i = 0; i < 40; i++) {
+        addAt(live, now + 10 + i * 30, static_cast<uint8_t>(1 + i % 3), static_cast<uint8_t>(i % 2),
+              i % 2 ? "Main street" : "Side street");
+    }
+    live.addRule(RecurrenceRule::onWeekdays(RecurrenceRule::Weekdays, 7, 30, 0), 4, 1, "Weekday Rush");
+    int removed = live.addRule(RecurrenceRule::daily(22, 0, 0), 5, 0, "Night");
+    live.removeRule(static_cast<uint8_t>(removed));
+    live.removeEvent(now + 10 + 5 * 30);
+    live.rescheduleScenario(3, 7);
+
+    // Callbacks only queue: nothing reaches the flash until the writer runs
+    uint32_t written = journal.getStats().bytesWritten;
+    NativeClock::advanceMs(100 * 1000);
+    timeService.update();
+    live.update();
+    expect(journal.getStats().bytesWritten == written, "edits and deliveries write nothing from the callbacks");
+    expect(journal.getQueued() > 40, "edits wait in the queue");
+    journal.flush();
+    expect(journal.getQueued() == 0 && journal.getStats().bytesWritten > written, "flush writes the queue");
+
+    std::vector<Entry> expected = contents(live);
+    uint8_t scenario = live.getCurrentScenario();
+    uint8_t cycle = live.getCurrentCycle();
+
+    // The last record is torn: half of its bytes never got programmed
+    uint8_t before[FlashSize];
+    memcpy(before, flash, sizeof(flash));
+    addAt(live, now + 5000, 6, 1, "Lost in the reset");
+    journal.flush();
+    uint32_t first = FlashSize, last = 0;
+    for (uint32_t i = 0; i < FlashSize; i++) {
+        if (flash[i] == before[i]) continue;
+        if (first == FlashSize) first = i;
+        last = i;
+    }
+    expect(first < last, "last edit was written as one record");
+    for (uint32_t i = (first + last) / 2; i <= last; i++) flash[i] = 0xFF;
+
+    expect(restart(), "torn log replays");
+    expect(contents(restored) == expected, "replay restores everything before the torn record");
+    expect(restored.getCurrentScenario() == scenario && restored.getCurrentCycle() == cycle,
+           "replay resumes the running scenario");
+    bool delivered = false;
+    for (const Entry& entry : contents(restored)) delivered |= std::get<0>(entry) <= now + 100;
+    expect(!delivered, "events delivered before the restart are not restored");
+
+    // The journal carries on after the torn record, and the next restart sees that
+    static ScheduleJournal resumed(restored, storage);
+    resumed.begin();
+    resumed.replay();
+    resumed.attach(restored.getDispatcher());
+    addAt(restored, now + 6000, 7, 0, "After the restart");
+    resumed.flush();
+    expected = contents(restored);
+    restored.setEditHandler(nullptr, nullptr);
+    expect(restart(), "log written after a torn record replays");
+    expect(contents(restored) == expected, "edits after the restart are kept, the torn one is not");
+    live.setEditHandler(nullptr, nullptr);
+}
+
+void testCompactionAndOverflow() {
+    memset(flash, 0xFF, sizeof(flash));
+    live.clearEvents();
+    static ScheduleJournal journal(live, storage);  // Stays subscribed to the dispatcher
+    journal.begin();
+    journal.attach(live.getDispatcher());
+    journal.flush();
+
+    // Enough churn to go round the ring several times
+    TimeCode now = timeService.now();
+    for (uint32_t i = 0; i < 200; i++) addAt(live, now + 1000 + i, static_cast<uint8_t>(i % 8), 0, "Standing");
+    for (uint32_t i = 0; i < 6000; i++) {
+        addAt(live, now + 100000 + i % 50, 9, 0, "Churn");
+        live.removeEvent(now + 100000 + (i + 25) % 50);
+        journal.flush();
+    }
+    expect(journal.getStats().compactions >= 4, "the ring is compacted as it fills");
+    expect(journal.getStats().failures == 0, "compaction keeps up with the log");
+    expect(restart(), "compacted log replays");
+    expect(contents(restored) == contents(live), "replay after compaction matches");
+
+    // More edits than the queue holds before the writer runs
+    for (uint32_t i = 0; i < JOURNAL_QUEUE_CAPACITY + 20; i++) {
+        live.removeEvent(now + 1000 + i % 200);
+        addAt(live, now + 1000 + i % 200, static_cast<uint8_t>(i % 8), 1, "Rewritten");
+    }
+    expect(journal.getStats().queueOverflows > 0, "a full queue drops records");
+    journal.flush();
+    addAt(live, now + 200000, 10, 0, "Next edit");  // Queues the snapshot that makes the log whole
+    journal.flush();
+    expect(restart(), "log replays after an overflow");
+    expect(contents(restored) == contents(live), "snapshot after an overflow restores the state");
+    live.setEditHandler(nullptr, nullptr);
+}
+
+void testReplayTime() {
+    memset(flash, 0xFF, sizeof(flash));
+    live.clearEvents();
+    static ScheduleJournal journal(live, storage);  // Stays subscribed to the dispatcher
+    journal.begin();
+    journal.attach(live.getDispatcher());
+    TimeCode now = timeService.now();
+    for (uint32_t i = 0; i < EVENT_MANAGER_CAPACITY - 16; i++) {
+        addAt(live, now + 1000 + i * 60, static_cast<uint8_t>(i % 16), 0, "Full schedule");
+        if (i % 64 == 63) journal.flush();
+    }
+    journal.flush();
+    ScheduleJournal::Stats stats;
+    expect(restart(&stats), "full schedule replays");
+    expect(contents(restored) == contents(live), "full schedule restored");
+    std::printf("replayed %u records in %u us (host)\n", static_cast<unsigned>(stats.replayedRecords),
+                static_cast<unsigned>(stats.replayUs));
+    live.setEditHandler(nullptr, nullptr);
+}
+
+// A batch reports one edit per stored entry: duplicates of stored events and out-of-range
+// specs that map onto a stored time report nothing
+void testBatchEdits() {
+    live.clearEvents();
+    static std::vector<TimeCode> added;
+    live.setEditHandler([](const EventManager::ScheduleEdit& edit, void*) {
+        if (edit.kind == EventManager::EditKind::EventAdded) added.push_back(edit.timeCode);
+    }, nullptr);
+    live.addEvent(2024, 8, 1, 9, 0, 0, 1, 0, "Stored");
+    live.addEvent(2024, 8, 2, 0, 0, 0, 1, 0, "Midnight");
+    added.clear();
+
+    static const EventManager::EventSpec batch[] = {
+        {2024, 8, 1, 9, 0, 0, 1, 0, "Duplicate"},
+        {2024, 8, 1, 24, 0, 0, 1, 0, "Hour out of range"},  // Would encode as 2 Aug 00:00
+        {2024, 8, 1, 10, 0, 0, 2, 1, "New"},
+        {2024, 8, 1, 10, 0, 0, 2, 1, "New again"},
+        {2024, 8, 1, 11, 0, 0, 3, 0, "Also new"},
+    };
+    EventManager::BatchReport report = live.addEvents(batch);
+    expect(report.accepted == 2 && report.rejected == 3, "batch stores the two new entries");
+    expect(added.size() == 2 && added[0] == CivilTime::toEpoch(2024, 8, 1, 10, 0, 0) &&
+               added[1] == CivilTime::toEpoch(2024, 8, 1, 11, 0, 0),
+           "batch reports exactly the stored entries");
+    live.setEditHandler(nullptr, nullptr);
+}
+
+}  // namespace
+
+int main() {
+    NativeClock::nowUs = 0;
+    rtc.adjust(DateTime(StartEpoch));
+    timeService.begin();
+    for (int i = 0; i < 150; i++) {
+        NativeClock::advanceMs(SoftClock::EdgePollMs);
+        timeService.update();
+    }
+    live.begin();
+    restored.begin();
+
+    testTornRecord();
+    testCompactionAndOverflow();
+    testReplayTime();
+    testBatchEdits();
+
+    if (failures != 0) {
+        std::fprintf(stderr, "%d journal checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("journal checks passed\n");
+    return EXIT_SUCCESS;
+}
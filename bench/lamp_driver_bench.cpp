@@ -0,0 +1,104 @@
+// lamp_driver_bench.cpp
+// Host comparison of LampDriver's single masked write against per-pin writes in the style
+// of digitalWrite, on MockPort: time per state change and intermediate lamp states exposed.
+// Build: g++ -O2 -std=gnu++17 -Iinclude bench/lamp_driver_bench.cpp src/LampDriver.cpp -o lamp_driver_bench
+#include <chrono>
+#include <cstdio>
+#include "LampDriver.h"
+
+namespace {
+
+enum Lamp : uint8_t { MainRed, MainAmber, MainGreen, SideRed, SideAmber, SideGreen, LampCount };
+enum SignalState : uint8_t { AllRed, MainGo, MainClear, SideGo, SideClear, StateCount };
+
+constexpr uint32_t bit(Lamp lamp) { return 1UL << lamp; }
+
+constexpr uint32_t LampMask = (1UL << LampCount) - 1;
+constexpr uint32_t Patterns[StateCount] = {
+    bit(MainRed) | bit(SideRed),     bit(MainGreen) | bit(SideRed), bit(MainAmber) | bit(SideRed),
+    bit(SideGreen) | bit(MainRed),   bit(SideAmber) | bit(MainRed),
+};
+constexpr uint8_t Sequence[] = {MainGo, MainClear, AllRed, SideGo, SideClear, AllRed};
+constexpr uint32_t MainMoving = bit(MainGreen) | bit(MainAmber);
+constexpr uint32_t SideMoving = bit(SideGreen) | bit(SideAmber);
+
+using Clock = std::chrono::steady_clock;
+
+// Counts port states that match neither the old nor the new pattern
+class WatchedPort : public MockPort {
+public:
+    uint32_t target = 0;
+    uint32_t previous = 0;
+    uint32_t intermediate = 0;
+    uint32_t conflicting = 0;
+
+    void write(uint32_t setMask, uint32_t clearMask) override {
+        MockPort::write(setMask, clearMask);
+        uint32_t lit = getLevels();
+        if (lit != target && lit != previous) ++intermediate;
+        if ((lit & MainMoving) && (lit & SideMoving)) ++conflicting;
+    }
+};
+
+void runPerPin(WatchedPort& port, uint32_t switches) {
+    for (uint32_t i = 0; i < switches; i++) {
+        uint32_t next = Patterns[Sequence[i % sizeof(Sequence)]];
+        port.previous = port.target;
+        port.target = next;
+        for (uint8_t pin = 0; pin < LampCount; pin++) {  // One call per pin, as digitalWrite would
+            if (next & (1UL << pin)) {
+                port.write(1UL << pin, 0);
+            } else {
+                port.write(0, 1UL << pin);
+            }
+        }
+    }
+}
+
+void runDriver(WatchedPort& port, LampDriver& driver, uint32_t switches) {
+    for (uint32_t i = 0; i < switches; i++) {
+        uint8_t state = Sequence[i % sizeof(Sequence)];
+        port.previous = port.target;
+        port.target = Patterns[state];
+        driver.apply(state);
+    }
+}
+
+double nsPerSwitch(Clock::time_point start, uint32_t switches) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / switches;
+}
+
+} // namespace
+
+int main() {
+    const uint32_t switches = 1000000;
+
+    WatchedPort perPinPort;
+    auto start = Clock::now();
+    runPerPin(perPinPort, switches);
+    double perPinNs = nsPerSwitch(start, switches);
+
+    WatchedPort driverPort;
+    LampDriver driver(driverPort, LampMask);
+    driver.addConflict(MainMoving, SideMoving);
+    for (uint8_t state = 0; state < StateCount; state++) driver.setStatePattern(state, Patterns[state]);
+    start = Clock::now();
+    runDriver(driverPort, driver, switches);
+    double driverNs = nsPerSwitch(start, switches);
+
+    printf("%-12s %14s %14s %14s %14s\n", "driver", "ns/switch", "writes", "intermediate", "conflicting");
+    printf("%-12s %14.1f %14u %14u %14u\n", "per-pin", perPinNs, perPinPort.getWrites(), perPinPort.intermediate,
+           perPinPort.conflicting);
+    printf("%-12s %14.1f %14u %14u %14u\n", "LampDriver", driverNs, driverPort.getWrites(), driverPort.intermediate,
+           driverPort.conflicting);
+
+    // Monitor: a side green stuck on during main green must latch the fail-safe pattern
+    driver.setFailSafePattern(bit(MainRed) | bit(SideRed));
+    driver.apply(MainGo);
+    driverPort.setStuck(bit(SideGreen), 0);
+    bool passed = driver.check();
+    printf("stuck side green: check %s, faulted %s, commanded 0x%02x, refused pattern %s\n",
+           passed ? "passed" : "failed", driver.isFaulted() ? "yes" : "no", static_cast<unsigned>(driver.getCommanded()),
+           driver.setStatePattern(0, bit(MainGreen) | bit(SideGreen)) ? "no" : "yes");
+    return 0;
+}
@@ -0,0 +1,120 @@
+// life_bench.cpp
+// Host comparison of LifeGrid against the cell-by-cell game of life it replaces (neighbours
+// counted with nested loops and modulo wrapping), in generations per second. Every grid is
+// also checked against the reference generation by generation, including sizes that are
+// not a whole number of words.
+// Build: g++ -O2 -std=gnu++17 -DLIFE_GRID_MAX_WIDTH=512 -DLIFE_GRID_MAX_HEIGHT=512 -Iinclude
+//        bench/life_bench.cpp src/LifeGrid.cpp src/PackedFrame.cpp -o life_bench
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "LifeGrid.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+class ReferenceLife {
+public:
+    ReferenceLife(int width, int height) : width(width), height(height), grid(width * height), next(width * height) {}
+
+    void load(const LifeGrid& life) {
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++) grid[y * width + x] = life.get(x, y);
+    }
+
+    bool matches(const LifeGrid& life) const {
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                if (grid[y * width + x] != life.get(x, y)) return false;
+        return true;
+    }
+
+    void step() {
+        for (int x = 0; x < width; x++) {
+            for (int y = 0; y < height; y++) {
+                int neighbors = 0;
+                for (int dx = -1; dx <= 1; dx++) {
+                    for (int dy = -1; dy <= 1; dy++) {
+                        if (dx == 0 && dy == 0) continue;
+                        int nx = (x + dx + width) % width;
+                        int ny = (y + dy + height) % height;
+                        if (grid[ny * width + nx]) neighbors++;
+                    }
+                }
+                bool alive = grid[y * width + x];
+                next[y * width + x] = alive ? (neighbors == 2 || neighbors == 3) : neighbors == 3;
+            }
+        }
+        grid.swap(next);
+    }
+
+private:
+    int width;
+    int height;
+    std::vector<char> grid;
+    std::vector<char> next;
+};
+
+double generationsPerSecond(Clock::time_point start, uint32_t generations) {
+    return generations / std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void run(uint16_t width, uint16_t height, uint32_t generations) {
+    static LifeGrid life(0, 0);
+    life = LifeGrid(width, height);
+    FastRandom rng(width * 1000003UL + height);
+    life.randomize(57, rng);
+    ReferenceLife reference(width, height);
+    reference.load(life);
+
+    uint32_t checked = generations < 200 ? generations : 200;
+    uint32_t mismatch = 0;
+    for (uint32_t g = 1; g <= checked && mismatch == 0; g++) {
+        life.step();
+        reference.step();
+        if (!reference.matches(life)) mismatch = g;
+    }
+
+    auto start = Clock::now();
+    for (uint32_t g = 0; g < generations / 10; g++) reference.step();
+    double referenceRate = generationsPerSecond(start, generations / 10);
+
+    start = Clock::now();
+    for (uint32_t g = 0; g < generations; g++) life.step();
+    double packedRate = generationsPerSecond(start, generations);
+
+    char size[16];
+    snprintf(size, sizeof(size), "%ux%u", width, height);
+    printf("%-10s %12.0f %12.0f %9.1fx %10u %9s\n", size, referenceRate, packedRate, packedRate / referenceRate,
+           life.population(), mismatch ? "DIFFERS" : "same");
+    if (mismatch) printf("  first mismatch at generation %u\n", mismatch);
+}
+
+} // namespace
+
+int main() {
+    printf("%-10s %12s %12s %10s %10s %9s\n", "grid", "ref gen/s", "packed gen/s", "speedup", "population", "output");
+    run(128, 64, 20000);
+    run(100, 37, 20000);
+    run(64, 64, 20000);
+    run(200, 150, 5000);
+    run(512, 512, 1000);
+
+    // Drawing a generation into a 128x64 page-major frame
+    LifeGrid life(128, 64);
+    FastRandom rng;
+    life.randomize(57, rng);
+    static uint8_t frame[128 * 64 / 8];
+    PackedFrame packed(frame, 128, 64);
+    const uint32_t draws = 100000;
+    auto start = Clock::now();
+    for (uint32_t i = 0; i < draws; i++) packed.fromRowMajor(life.getBits(), life.getRowBytes());
+    double drawUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / draws;
+    bool drawn = true;
+    for (uint16_t y = 0; y < 64; y++)
+        for (uint16_t x = 0; x < 128; x++)
+            if (((frame[(y / 8) * 128 + x] >> (y & 7)) & 1) != life.get(x, y)) drawn = false;
+    printf("blit 128x64 to the framebuffer: %.2f us, %s\n", drawUs, drawn ? "same" : "DIFFERS");
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Arduino.h
+// Host stand-in for the parts of the Arduino core used by the scheduler, for the native
+// PlatformIO env and the host benchmarks. Time is virtual: millis() and micros() only move
+// when NativeClock is advanced, so runs are deterministic. Serial writes to stderr,
+// keeping stdout free for benchmark output.
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace NativeClock {
+inline uint64_t nowUs = 0;
+
+inline void advanceUs(uint64_t us) { nowUs += us; }
+inline void advanceMs(uint32_t ms) { nowUs += static_cast<uint64_t>(ms) * 1000; }
+}
+
+inline unsigned long millis() { return static_cast<unsigned long>(NativeClock::nowUs / 1000); }
+inline unsigned long micros() { return static_cast<unsigned long>(NativeClock::nowUs); }
+inline void delay(unsigned long ms) { NativeClock::advanceMs(ms); }
+inline void delayMicroseconds(unsigned int us) { NativeClock::advanceUs(us); }
+
+class __FlashStringHelper;
+#define F(text) (reinterpret_cast<const __FlashStringHelper*>(text))
+
+// Minimal Arduino String over std::string
+class String {
+public:
+    String(const char* text = "") : value(text ? text : "") {}
+    String(const __FlashStringHelper* text) : value(reinterpret_cast<const char*>(text)) {}
+    explicit String(long number) : value(std::to_string(number)) {}
+
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return static_cast<unsigned int>(value.size()); }
+    bool concat(const char* text) {
+        value += text;
+        return true;
+    }
+    String& operator+=(const char* text) {
+        value += text;
+        return *this;
+    }
+    String& operator+=(const String& other) {
+        value += other.value;
+        return *this;
+    }
+    bool operator==(const String& other) const { return value == other.value; }
+    bool operator!=(const String& other) const { return value != other.value; }
+    char operator[](unsigned int index) const { return index < value.size() ? value[index] : '\0'; }
+
+private:
+    std::string value;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        for (size_t i = 0; i < size; i++) write(buffer[i]);
+        return size;
+    }
+    virtual int availableForWrite() { return 0; }
+
+    size_t print(const char* text) { return write(reinterpret_cast<const uint8_t*>(text), strlen(text)); }
+    size_t print(const __FlashStringHelper* text) { return print(reinterpret_cast<const char*>(text)); }
+    size_t print(const String& text) { return print(text.c_str()); }
+    size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+    size_t print(long number) { return printf("%ld", number); }
+    size_t print(int number) { return print(static_cast<long>(number)); }
+    size_t print(unsigned long number) { return printf("%lu", number); }
+    size_t print(unsigned int number) { return print(static_cast<unsigned long>(number)); }
+    size_t print(double number, int digits = 2) { return printf("%.*f", digits, number); }
+
+    template <typename T>
+    size_t println(T value) { return print(value) + println(); }
+    size_t println() { return print("\r\n"); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (length < 0) return 0;
+        return write(reinterpret_cast<const uint8_t*>(buffer),
+                     static_cast<size_t>(length) < sizeof(buffer) ? length : sizeof(buffer) - 1);
+    }
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    void flush() { fflush(stderr); }
+    size_t write(uint8_t c) override { return fputc(c, stderr) == EOF ? 0 : 1; }
+    using Print::write;
+    int availableForWrite() override { return 128; }
+};
+
+inline HardwareSerial Serial;
+
+#endif // NATIVE_ARDUINO_H
@@ -0,0 +1,63 @@
+// RTClib.h
+// Host stand-in for RTClib's DateTime and RTC_DS3231. The mock RTC counts whole seconds
+// of NativeClock time from the last adjust(), so it ticks with millis(). setDriftPpm()
+// makes it run fast (positive) or slow against NativeClock, as a real crystal pair does.
+#ifndef NATIVE_RTCLIB_H
+#define NATIVE_RTCLIB_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "CivilTime.h"
+
+class DateTime {
+public:
+    DateTime(uint32_t t = 0) : t(t) {}
+    DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t minute = 0, uint8_t second = 0)
+        : t(CivilTime::toEpoch(year, month, day, hour, minute, second)) {}
+
+    uint16_t year() const { return CivilTime::fromEpoch(t).year; }
+    uint8_t month() const { return CivilTime::fromEpoch(t).month; }
+    uint8_t day() const { return CivilTime::fromEpoch(t).day; }
+    uint8_t hour() const { return CivilTime::fromEpoch(t).hour; }
+    uint8_t minute() const { return CivilTime::fromEpoch(t).minute; }
+    uint8_t second() const { return CivilTime::fromEpoch(t).second; }
+    uint8_t dayOfTheWeek() const { return static_cast<uint8_t>(CivilTime::dayOfWeek(t)); }
+    uint32_t unixtime() const { return t; }
+
+private:
+    uint32_t t;
+};
+
+class RTC_DS3231 {
+public:
+    RTC_DS3231() : baseUs(0), usAtAdjust(0), driftPpm(0) {}
+    bool begin(TwoWire* = &Wire) { return true; }
+    bool lostPower() { return false; }
+
+    void adjust(const DateTime& dt) {
+        baseUs = static_cast<uint64_t>(dt.unixtime()) * 1000000;
+        usAtAdjust = NativeClock::nowUs;
+    }
+
+    // RTC microseconds gained per second of NativeClock time, from now on
+    void setDriftPpm(int32_t ppm) {
+        baseUs = preciseUs();
+        usAtAdjust = NativeClock::nowUs;
+        driftPpm = ppm;
+    }
+
+    DateTime now() { return DateTime(static_cast<uint32_t>(preciseUs() / 1000000)); }
+
+    // The RTC's own time below the second it reports, for checking a clock against it
+    uint64_t preciseUs() const {
+        int64_t elapsed = static_cast<int64_t>(NativeClock::nowUs - usAtAdjust);
+        return baseUs + elapsed + elapsed * driftPpm / 1000000;
+    }
+
+private:
+    uint64_t baseUs;
+    uint64_t usAtAdjust;
+    int32_t driftPpm;
+};
+
+#endif // NATIVE_RTCLIB_H
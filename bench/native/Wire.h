@@ -0,0 +1,13 @@
+// Wire.h
+// Host stand-in for the Arduino I2C bus; nothing is attached.
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+class TwoWire {
+public:
+    bool begin() { return true; }
+};
+
+inline TwoWire Wire;
+
+#endif // NATIVE_WIRE_H
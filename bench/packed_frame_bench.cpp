@@ -0,0 +1,148 @@
+// packed_frame_bench.cpp
+// Host comparison of the PackedFrame kernels against the per-pixel loops they replace, on a
+// 128x64 page-major frame. The reference draws through a copy of Adafruit_SSD1306::drawPixel
+// (bounds check, rotation switch, colour switch); deterministic kernels are checked for
+// identical output.
+// Build: g++ -O2 -std=gnu++17 -Iinclude bench/packed_frame_bench.cpp src/PackedFrame.cpp -o packed_frame_bench
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "PackedFrame.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int16_t Width = 128;
+constexpr int16_t Height = 64;
+constexpr size_t FrameBytes = Width * Height / 8;
+
+uint8_t reference[FrameBytes];
+uint8_t packed[FrameBytes];
+uint8_t samples[Height][Width];
+uint8_t rowMajor[FrameBytes];
+volatile uint8_t rotation = 0;  // Read per pixel, as the library does
+volatile uint8_t sink;
+
+enum Colour : uint8_t { Black, White, Inverse };
+
+void drawPixel(int16_t x, int16_t y, uint8_t colour) {
+    if (x < 0 || x >= Width || y < 0 || y >= Height) return;
+    switch (rotation) {
+        case 1: { int16_t t = x; x = Width - y - 1; y = t; } break;
+        case 2: x = Width - x - 1; y = Height - y - 1; break;
+        case 3: { int16_t t = x; x = y; y = Height - t - 1; } break;
+    }
+    switch (colour) {
+        case White: reference[x + (y / 8) * Width] |= (1 << (y & 7)); break;
+        case Black: reference[x + (y / 8) * Width] &= ~(1 << (y & 7)); break;
+        case Inverse: reference[x + (y / 8) * Width] ^= (1 << (y & 7)); break;
+    }
+}
+
+template <typename Body>
+double usPerCall(uint32_t calls, Body body) {
+    auto start = Clock::now();
+    for (uint32_t i = 0; i < calls; i++) body();
+    sink = reference[0] ^ packed[0];
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / calls;
+}
+
+void report(const char* kernel, double perPixelUs, double packedUs, const char* check) {
+    printf("%-18s %12.2f %12.2f %9.1fx %8s\n", kernel, perPixelUs, packedUs, perPixelUs / packedUs, check);
+}
+
+const char* same() {
+    return memcmp(reference, packed, FrameBytes) == 0 ? "same" : "DIFFERS";
+}
+
+} // namespace
+
+int main() {
+    const uint32_t calls = 2000;
+    PackedFrame frame(packed, Width, Height);
+    FastRandom rng(12345);
+
+    for (int y = 0; y < Height; y++) {
+        for (int x = 0; x < Width; x++) samples[y][x] = static_cast<uint8_t>(rng.next());
+    }
+    for (size_t i = 0; i < FrameBytes; i++) rowMajor[i] = static_cast<uint8_t>(rng.next());
+
+    printf("%-18s %12s %12s %10s %8s\n", "kernel", "pixel us", "packed us", "speedup", "output");
+
+    double pixel = usPerCall(calls, [&] {
+        for (int16_t y = 0; y < Height; y++)
+            for (int16_t x = 0; x < Width; x++)
+                if (rng.next() & 1) drawPixel(x, y, White);
+    });
+    double fast = usPerCall(calls, [&] { frame.random(PackedFrame::Op::Set, 128, rng); });
+    report("noise 50%", pixel, fast, "random");
+
+    pixel = usPerCall(calls, [&] {
+        for (int16_t y = 0; y < Height; y++)
+            for (int16_t x = 0; x < Width; x++)
+                if ((rng.next() & 0xFF) < 40) drawPixel(x, y, White);
+    });
+    fast = usPerCall(calls, [&] { frame.random(PackedFrame::Op::Set, 40, rng); });
+    report("random fill 16%", pixel, fast, "random");
+
+    pixel = usPerCall(calls, [&] {
+        for (size_t i = 0; i < FrameBytes; i++) reference[i] &= rng.next() % 0xFF;  // As fadeOut did
+    });
+    fast = usPerCall(calls, [&] { frame.random(PackedFrame::Op::And, 128, rng); });
+    report("fade AND", pixel, fast, "random");
+
+    // rowMajor doubles as a page-major mask here
+    memset(reference, 0, FrameBytes);
+    memset(packed, 0, FrameBytes);
+    pixel = usPerCall(calls, [&] {
+        for (int16_t y = 0; y < Height; y++)
+            for (int16_t x = 0; x < Width; x++)
+                if ((rowMajor[x + (y / 8) * Width] >> (y & 7)) & 1) drawPixel(x, y, Inverse);
+    });
+    fast = usPerCall(calls, [&] { frame.combine(PackedFrame::Op::Xor, rowMajor); });
+    report("XOR mask", pixel, fast, same());
+
+    pixel = usPerCall(calls, [&] {
+        for (int16_t y = 0; y < Height; y++)
+            for (int16_t x = 0; x < Width; x++) drawPixel(x, y, samples[y][x] > 127 ? White : Black);
+    });
+    fast = usPerCall(calls, [&] {
+        for (uint8_t y = 0; y < Height; y++) frame.thresholdRow(y, samples[y], 127);
+    });
+    report("threshold", pixel, fast, same());
+
+    pixel = usPerCall(calls, [&] {
+        for (int16_t y = 0; y < Height; y++)
+            for (int16_t x = 0; x < Width; x++)
+                drawPixel(x, y, (rowMajor[(y * Width + x) >> 3] >> (x & 7)) & 1 ? White : Black);
+    });
+    fast = usPerCall(calls, [&] { frame.fromRowMajor(rowMajor); });
+    report("row-major blit", pixel, fast, same());
+
+    pixel = usPerCall(calls, [&] {
+        for (int16_t y = 0; y < Height; y += 2)
+            for (int16_t x = 0; x < Width; x++) drawPixel(x, y, White);
+    });
+    fast = usPerCall(calls, [&] {
+        for (int16_t y = 0; y < Height; y += 2) frame.hSpan(0, Width - 1, y, true);
+    });
+    report("row spans", pixel, fast, same());
+
+    pixel = usPerCall(calls, [&] {
+        for (int16_t x = 0; x < Width; x += 2)
+            for (int16_t y = 3; y < Height - 3; y++) drawPixel(x, y, Black);
+    });
+    fast = usPerCall(calls, [&] {
+        for (int16_t x = 0; x < Width; x += 2) frame.vSpan(x, 3, Height - 4, false);
+    });
+    report("column spans", pixel, fast, same());
+
+    pixel = usPerCall(calls, [&] {
+        for (int16_t y = 0; y < Height; y++)
+            for (int16_t x = 0; x < Width; x++) drawPixel(x, y, Black);
+    });
+    fast = usPerCall(calls, [&] { frame.clear(); });
+    report("clear", pixel, fast, same());
+    return 0;
+}
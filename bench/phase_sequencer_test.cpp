@@ -0,0 +1,195 @@
+// phase_sequencer_test.cpp
+// Host check of PhaseSequencer on a simulated microsecond clock, driven the way PhaseTimer
+// drives it: run() is called at each returned phase end plus some timer latency. Checks
+// the phase timestamps against the plan, plan switches at cycle boundaries, and that two
+// controllers sharing a reference stay in step across a switch. Exits non-zero on failure.
+// Build: g++ -O2 -std=gnu++17 -Iinclude bench/phase_sequencer_test.cpp src/PhaseSequencer.cpp
+//        src/LabelTable.cpp -o phase_sequencer_test
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "PhaseSequencer.h"
+
+namespace {
+
+constexpr uint64_t SecondUs = 1000000;
+
+const Phase PeakPhases[] = {{PhaseSequencer::ticks(40000), 1}, {PhaseSequencer::ticks(4000), 2},
+                            {PhaseSequencer::ticks(2000), 3},  {PhaseSequencer::ticks(20000), 4},
+                            {PhaseSequencer::ticks(4000), 5},  {PhaseSequencer::ticks(2000), 3}};
+const Phase OffPeakPhases[] = {{PhaseSequencer::ticks(25000), 1}, {PhaseSequencer::ticks(3000), 2},
+                               {PhaseSequencer::ticks(2000), 3},  {PhaseSequencer::ticks(15000), 4},
+                               {PhaseSequencer::ticks(3000), 5},  {PhaseSequencer::ticks(2000), 3}};
+
+const CyclePlan Peak = {PeakPhases, 6, PhaseSequencer::ticks(7000)};        // 72 s cycle
+const CyclePlan OffPeak = {OffPeakPhases, 6, PhaseSequencer::ticks(11000)};  // 50 s cycle
+
+int failures = 0;
+
+void expect(bool condition, const char* what) {
+    if (condition) return;
+    std::fprintf(stderr, "FAIL: %s\n", what);
+    ++failures;
+}
+
+struct Controller {
+    PhaseSequencer sequencer;
+    std::vector<PhaseSequencer::PhaseChange> changes;
+    uint64_t dueUs = 0;
+
+    static void record(const PhaseSequencer::PhaseChange& change, void* context) {
+        static_cast<Controller*>(context)->changes.push_back(change);
+    }
+
+    void begin(uint64_t nowUs, int64_t referenceUs) {
+        sequencer.setPlan(0, 0, &OffPeak);
+        sequencer.setPlan(1, 0, &Peak);
+        sequencer.setHandler(record, this);
+        sequencer.select(0, 0);
+        sequencer.start(nowUs, referenceUs);
+        dueUs = sequencer.run(nowUs);
+    }
+
+    // Runs every timer callback due up to untilUs, each late by up to 2 ms
+    void runUntil(uint64_t untilUs, std::mt19937& rng) {
+        std::uniform_int_distribution<uint32_t> latencyUs(0, 2000);
+        while (dueUs <= untilUs) dueUs = sequencer.run(dueUs + latencyUs(rng));
+    }
+
+    // Start of every cycle (phase 0 entries) of the given plan, from the given change on
+    std::vector<uint64_t> cycleStarts(uint8_t scenario, size_t from = 0) const {
+        std::vector<uint64_t> starts;
+        for (size_t i = from; i < changes.size(); i++) {
+            if (changes[i].phase == 0 && changes[i].scenario == scenario) starts.push_back(changes[i].plannedUs);
+        }
+        return starts;
+    }
+};
+
+uint64_t lengthUs(const CyclePlan& plan) {
+    return static_cast<uint64_t>(plan.cycleTicks()) * PhaseSequencer::TickUs;
+}
+
+bool onGrid(uint64_t atUs, int64_t referenceUs, const CyclePlan& plan) {
+    int64_t since = static_cast<int64_t>(atUs) - referenceUs - static_cast<int64_t>(plan.offset) * PhaseSequencer::TickUs;
+    int64_t length = static_cast<int64_t>(lengthUs(plan));
+    return (since % length + length) % length == 0;
+}
+
+// Every phase starts where the previous one planned to end, whatever the timer latency
+bool contiguous(const std::vector<PhaseSequencer::PhaseChange>& changes, size_t from, size_t to) {
+    for (size_t i = from + 1; i < to; i++) {
+        const PhaseSequencer::PhaseChange& previous = changes[i - 1];
+        const CyclePlan& plan = previous.scenario == 1 ? Peak : OffPeak;
+        if (changes[i].plannedUs != previous.plannedUs + plan.phases[previous.phase].duration * PhaseSequencer::TickUs) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testStartOnGrid() {
+    std::mt19937 rng(1);
+    const int64_t referenceUs = -3600 * static_cast<int64_t>(SecondUs);  // Midnight an hour before boot
+    Controller controller;
+    controller.begin(5 * SecondUs, referenceUs);
+    controller.runUntil(600 * SecondUs, rng);
+
+    std::vector<uint64_t> starts = controller.cycleStarts(0);
+    bool aligned = !starts.empty();
+    for (uint64_t start : starts) aligned &= onGrid(start, referenceUs, OffPeak);
+    expect(aligned, "cycles start at reference + offset + k * length");
+    expect(contiguous(controller.changes, 1, controller.changes.size()), "timer latency never shifts a phase");
+    expect(starts.size() >= 11, "ten minutes run about twelve 50 s cycles");
+}
+
+void testStartBeforeZero() {
+    std::mt19937 rng(4);
+    Controller controller;
+    controller.begin(1 * SecondUs, 0);  // 10 s into the fourth off-peak phase, which began before zero
+    controller.runUntil(300 * SecondUs, rng);
+
+    expect(controller.changes.size() > 2 && controller.changes[0].phase == 3, "boot enters the phase in progress");
+    expect(contiguous(controller.changes, 0, controller.changes.size()),
+           "the phase in progress is reported from its real start");
+}
+
+void testPlanSwitch() {
+    std::mt19937 rng(2);
+    const int64_t referenceUs = 0;
+    Controller controller;
+    controller.begin(1 * SecondUs, referenceUs);
+    controller.runUntil(120 * SecondUs, rng);
+
+    size_t before = controller.changes.size();
+    controller.sequencer.select(1, 0);
+    controller.runUntil(900 * SecondUs, rng);
+
+    // The switch happens at the first off-peak cycle boundary after the request
+    size_t first = before;
+    while (first < controller.changes.size() && controller.changes[first].scenario != 1) ++first;
+    expect(first < controller.changes.size(), "new plan is entered");
+    if (first == controller.changes.size()) return;
+    const PhaseSequencer::PhaseChange& entry = controller.changes[first];
+    expect(entry.phase == 0 && onGrid(entry.plannedUs, referenceUs, OffPeak),
+           "new plan enters at its first phase on an old-plan cycle boundary");
+
+    // Its first phase is held until the peak grid, then every cycle follows the grid
+    const PhaseSequencer::PhaseChange& second = controller.changes[first + 1];
+    uint64_t heldUs = second.plannedUs - entry.plannedUs;
+    uint64_t firstPhaseUs = PeakPhases[0].duration * PhaseSequencer::TickUs;
+    expect(heldUs >= firstPhaseUs && heldUs < firstPhaseUs + lengthUs(Peak), "first phase held, never cut short");
+    expect(onGrid(second.plannedUs - firstPhaseUs, referenceUs, Peak), "held phase ends on the new plan's grid");
+
+    std::vector<uint64_t> starts = controller.cycleStarts(1, first + 1);
+    bool aligned = starts.size() >= 9;
+    for (uint64_t start : starts) aligned &= onGrid(start, referenceUs, Peak);
+    expect(aligned, "later cycles of the new plan start on its grid");
+    expect(contiguous(controller.changes, first + 1, controller.changes.size()), "new plan runs phase after phase");
+}
+
+void testControllersStayCoordinated() {
+    std::mt19937 rng(3);
+    const int64_t referenceUs = 0;
+    Controller a, b;
+    a.begin(2 * SecondUs, referenceUs);
+    b.begin(37 * SecondUs, referenceUs);  // Booted later
+    a.runUntil(200 * SecondUs, rng);
+    b.runUntil(200 * SecondUs, rng);
+
+    // The switch reaches the controllers in different cycles
+    a.sequencer.select(1, 0);
+    a.runUntil(260 * SecondUs, rng);
+    b.runUntil(260 * SecondUs, rng);
+    b.sequencer.select(1, 0);
+    a.runUntil(1200 * SecondUs, rng);
+    b.runUntil(1200 * SecondUs, rng);
+
+    std::vector<uint64_t> startsA = a.cycleStarts(1);
+    std::vector<uint64_t> startsB = b.cycleStarts(1);
+    // Drop each controller's entry into the plan; from then on the cycles must coincide
+    startsA.erase(startsA.begin());
+    startsB.erase(startsB.begin());
+    while (!startsA.empty() && !startsB.empty() && startsA.front() < startsB.front()) startsA.erase(startsA.begin());
+    size_t common = startsA.size() < startsB.size() ? startsA.size() : startsB.size();
+    bool same = common >= 5;
+    for (size_t i = 0; i < common; i++) same &= startsA[i] == startsB[i];
+    expect(same, "controllers that switched in different cycles run the new plan in step");
+}
+
+}  // namespace
+
+int main() {
+    testStartOnGrid();
+    testStartBeforeZero();
+    testPlanSwitch();
+    testControllersStayCoordinated();
+
+    if (failures != 0) {
+        std::fprintf(stderr, "%d phase sequencer checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("phase sequencer checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,182 @@
+// recurrence_test.cpp
+// Host check of recurring events driven through EventManager on the simulated clock in
+// bench/native: weekday and weekend rules, a date range running out, and occurrences that
+// collide with one-shot events. Exits non-zero on the first failed expectation.
+// Build: g++ -O2 -std=gnu++17 -Ibench/native -Iinclude bench/recurrence_test.cpp src/EventManager.cpp
+//        src/TimeService.cpp src/SoftClock.cpp src/ScheduleImage.cpp src/LabelTable.cpp
+//        src/EventDispatcher.cpp src/DeadlineTimer.cpp -o recurrence_test
+#include <Arduino.h>
+#include <RTClib.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "CivilTime.h"
+#include "EventManager.h"
+#include "TimeService.h"
+
+namespace {
+
+RTC_DS3231 rtc;
+TimeService timeService(rtc);
+EventManager eventManager(timeService);
+
+struct Delivery {
+    TimeCode timeCode;
+    uint8_t scenario;
+};
+
+std::vector<Delivery> deliveries;
+uint32_t rulesRemoved = 0;
+int failures = 0;
+
+void recordDelivery(const ScheduledEvent& event, void*) {
+    deliveries.push_back(Delivery{event.timeCode, event.scenario});
+}
+
+void recordEdit(const EventManager::ScheduleEdit& edit, void*) {
+    if (edit.kind == EventManager::EditKind::RuleRemoved) ++rulesRemoved;
+}
+
+void expect(bool condition, const char* what) {
+    if (condition) return;
+    std::fprintf(stderr, "FAIL: %s\n", what);
+    ++failures;
+}
+
+// Restarts the clocks at `epoch` with an empty schedule, leaving the SoftClock locked
+void resetAt(uint32_t epoch) {
+    NativeClock::nowUs = 0;
+    rtc.adjust(DateTime(epoch));
+    timeService.begin();
+    for (int i = 0; i < 150; i++) {
+        NativeClock::advanceMs(SoftClock::EdgePollMs);
+        timeService.update();
+    }
+    eventManager.clearEvents();
+    deliveries.clear();
+    rulesRemoved = 0;
+}
+
+// Steps the simulated clock one second at a time, so every delivery is on time
+void runFor(uint32_t seconds) {
+    for (uint32_t i = 0; i < seconds; i++) {
+        NativeClock::advanceMs(1000);
+        timeService.update();
+        eventManager.update();
+    }
+}
+
+uint8_t weekdayOf(TimeCode timeCode) {
+    return static_cast<uint8_t>((timeCode / CivilTime::SecondsPerDay + 4) % 7);  // 0 = Sunday
+}
+
+bool allAt(uint8_t hour, uint8_t minute, uint8_t scenario) {
+    for (const Delivery& delivery : deliveries) {
+        if (delivery.scenario != scenario) continue;
+        if (delivery.timeCode % CivilTime::SecondsPerDay != hour * 3600UL + minute * 60UL) return false;
+    }
+    return true;
+}
+
+size_t countFor(uint8_t scenario) {
+    size_t count = 0;
+    for (const Delivery& delivery : deliveries) count += delivery.scenario == scenario;
+    return count;
+}
+
+void testWeekdays() {
+    resetAt(CivilTime::toEpoch(2024, 7, 19, 6, 0, 0));  // Friday
+    int id = eventManager.addRule(RecurrenceRule::onWeekdays(RecurrenceRule::Weekdays, 7, 0, 0), 1, 1, "Rush");
+    expect(id >= 0, "weekday rule accepted");
+    runFor(14 * CivilTime::SecondsPerDay);
+
+    // Fri 19, Mon 22 - Fri 26, Mon 29 - Thu 1 Aug
+    expect(deliveries.size() == 10, "weekday rule fires on the ten weekdays of two weeks");
+    for (const Delivery& delivery : deliveries) {
+        uint8_t weekday = weekdayOf(delivery.timeCode);
+        expect(weekday >= 1 && weekday <= 5, "weekday rule never fires on a weekend");
+    }
+    expect(allAt(7, 0, 1), "weekday rule fires at 07:00");
+    expect(eventManager.getRule(static_cast<uint8_t>(id)) != nullptr, "unbounded rule stays registered");
+}
+
+void testWeekend() {
+    resetAt(CivilTime::toEpoch(2024, 7, 19, 6, 0, 0));
+    eventManager.addRule(RecurrenceRule::onWeekdays(RecurrenceRule::Weekend, 9, 30, 0), 2, 1, "Weekend");
+    runFor(14 * CivilTime::SecondsPerDay);
+
+    expect(deliveries.size() == 4, "weekend rule fires on the four weekend days of two weeks");
+    for (const Delivery& delivery : deliveries) {
+        uint8_t weekday = weekdayOf(delivery.timeCode);
+        expect(weekday == 0 || weekday == 6, "weekend rule only fires on Saturday and Sunday");
+    }
+    expect(allAt(9, 30, 2), "weekend rule fires at 09:30");
+}
+
+void testDateRange() {
+    resetAt(CivilTime::toEpoch(2024, 7, 19, 6, 0, 0));
+    int id = eventManager.addRule(RecurrenceRule::daily(12, 0, 0).between(2024, 7, 21, 2024, 7, 23), 3, 1, "Fair");
+    expect(id >= 0, "date-range rule accepted");
+    eventManager.setEditHandler(recordEdit, nullptr);
+    runFor(7 * CivilTime::SecondsPerDay);
+    eventManager.setEditHandler(nullptr, nullptr);
+
+    expect(deliveries.size() == 3, "date-range rule fires once per day of its range");
+    expect(!deliveries.empty() && deliveries.front().timeCode == CivilTime::toEpoch(2024, 7, 21, 12, 0, 0),
+           "date-range rule starts on its first day");
+    expect(!deliveries.empty() && deliveries.back().timeCode == CivilTime::toEpoch(2024, 7, 23, 12, 0, 0),
+           "date-range rule ends on its last day");
+    expect(eventManager.getRule(static_cast<uint8_t>(id)) == nullptr, "exhausted rule is released");
+    expect(rulesRemoved == 1, "exhausted rule is reported as removed");
+
+    expect(eventManager.addRule(RecurrenceRule::daily(12, 0, 0).between(2024, 7, 1, 2024, 7, 2), 3, 1) < 0,
+           "rule whose range is already over is rejected");
+}
+
+void testCollisions() {
+    resetAt(CivilTime::toEpoch(2024, 7, 19, 6, 0, 0));
+    // One-shot events take 07:00 on the eight days after the rule's first occurrence,
+    // more than one pass skips, so the rule has to wait for a later pass
+    for (uint8_t day = 20; day <= 27; day++) {
+        expect(eventManager.addEvent(2024, 7, day, 7, 0, 0, 5, 1, "Closure"), "one-shot event accepted");
+    }
+    int id = eventManager.addRule(RecurrenceRule::daily(7, 0, 0), 4, 1, "Daily");
+    expect(id >= 0, "daily rule accepted");
+    eventManager.setEditHandler(recordEdit, nullptr);
+    runFor(11 * CivilTime::SecondsPerDay);
+    eventManager.setEditHandler(nullptr, nullptr);
+
+    expect(countFor(5) == 8, "every one-shot event fires");
+    expect(countFor(4) == 3, "daily rule fires on the 19th, 28th and 29th");
+    expect(eventManager.getRule(static_cast<uint8_t>(id)) != nullptr, "blocked rule is kept");
+    expect(rulesRemoved == 0, "blocked rule is not reported as removed");
+    bool ordered = true;
+    for (size_t i = 1; i < deliveries.size(); i++) ordered &= deliveries[i - 1].timeCode < deliveries[i].timeCode;
+    expect(ordered && deliveries.size() == 11, "one delivery per day, in order");
+
+    // A one-shot event on the rule's next second moves only that occurrence
+    deliveries.clear();
+    TimeCode next = CivilTime::toEpoch(2024, 7, 30, 7, 0, 0);
+    expect(!eventManager.addEvent(2024, 7, 30, 7, 0, 0, 5, 1), "second taken by the rule is refused");
+    expect(eventManager.removeEvent(next), "rule occurrence can be removed");
+    expect(eventManager.getRule(static_cast<uint8_t>(id)) == nullptr, "removing the occurrence ends the rule");
+}
+
+}  // namespace
+
+int main() {
+    eventManager.begin();
+    eventManager.getDispatcher().subscribe(recordDelivery, nullptr, EventFilter::all(), "test");
+
+    testWeekdays();
+    testWeekend();
+    testDateRange();
+    testCollisions();
+
+    if (failures != 0) {
+        std::fprintf(stderr, "%d recurrence checks failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("recurrence checks passed\n");
+    return EXIT_SUCCESS;
+}
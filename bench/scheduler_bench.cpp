@@ -0,0 +1,367 @@
+// scheduler_bench.cpp
+// Host benchmark of the EventManager hot paths against the native Arduino/RTClib stand-ins
+// in bench/native. Prints one JSON document to stdout so results can be compared per commit.
+// Build: pio run -e native && .pio/build/native/program [commit] > scheduler.json
+//    or: g++ -O2 -std=gnu++17 -DEVENT_MANAGER_CAPACITY=65000 -Ibench/native -Iinclude bench/scheduler_bench.cpp
+//        src/EventManager.cpp src/TimeService.cpp src/SoftClock.cpp src/ScheduleImage.cpp src/LabelTable.cpp
+//        src/EventDispatcher.cpp src/DeadlineTimer.cpp -o scheduler_bench
+#include <Arduino.h>
+#include <RTClib.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "CivilTime.h"
+#include "EventManager.h"
+#include "ScheduleImage.h"
+#include "TimeService.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t StartEpoch = CivilTime::toEpoch(2024, 7, 20, 6, 0, 0);
+constexpr uint8_t Scenarios = 8;
+constexpr size_t Sizes[] = {10, 100, 1000, 10000, 50000, 100000};
+constexpr size_t MinOps = 100000;  // Small sizes are repeated until this many operations were timed
+
+const char* const Labels[Scenarios] = {"Morning Rush Hour", "School Zone", "Midday", "Evening Rush Hour",
+                                       "Night",             "Event Traffic", "Maintenance", "Weekend Plan"};
+
+RTC_DS3231 rtc;
+TimeService timeService(rtc);
+EventManager eventManager(timeService);
+uint32_t delivered = 0;
+
+struct Result {
+    const char* name;
+    const char* source;
+    size_t events;
+    uint64_t ops;
+    double totalUs;
+};
+
+std::vector<Result> results;
+
+class Stopwatch {
+public:
+    void start() { began = Clock::now(); }
+    void stop() { totalUs += std::chrono::duration<double, std::micro>(Clock::now() - began).count(); }
+    double totalUs = 0;
+
+private:
+    Clock::time_point began;
+};
+
+void record(const char* name, const char* source, size_t events, uint64_t ops, double totalUs) {
+    results.push_back(Result{name, source, events, ops, totalUs});
+}
+
+size_t repeatsFor(size_t n) {
+    return std::max<size_t>(1, MinOps / n);
+}
+
+void countDelivered(const ScheduledEvent&, void*) {
+    ++delivered;
+}
+
+// Restarts the clocks at `epoch` and empties the scheduler, leaving the SoftClock locked
+void resetAt(uint32_t epoch) {
+    NativeClock::nowUs = 0;
+    rtc.adjust(DateTime(epoch));
+    timeService.begin();
+    for (int i = 0; i < 150; i++) {
+        NativeClock::advanceMs(SoftClock::EdgePollMs);
+        timeService.update();
+    }
+    eventManager.clearEvents();
+    for (uint8_t s = 0; s < Scenarios; s++) {
+        eventManager.setCatchUpPolicy(s, EventManager::CatchUpPolicy::Latest);
+    }
+}
+
+// After an outage ending 16 s past the last of n events 16 s apart, the default policy
+// delivers the three events still inside the 60 s catch-up window plus the latest missed one
+void checkCoalesced(const char* source, size_t n, size_t repeats) {
+    size_t expected = (n < 4 ? n : 4) * repeats;
+    if (delivered != expected) {
+        fprintf(stderr, "catch-up from %s delivered %u events, expected %zu\n", source, delivered, expected);
+    }
+}
+
+// n distinct times, `spacing` seconds apart from `first`, in random order
+std::vector<TimeCode> makeTimes(size_t n, TimeCode first, uint32_t spacing) {
+    std::vector<TimeCode> times(n);
+    for (size_t i = 0; i < n; i++) {
+        times[i] = first + static_cast<TimeCode>(i) * spacing;
+    }
+    std::mt19937 rng(1234);
+    std::shuffle(times.begin(), times.end(), rng);
+    return times;
+}
+
+std::vector<EventManager::EventSpec> makeSpecs(const std::vector<TimeCode>& times, TimeCode first) {
+    std::vector<EventManager::EventSpec> specs(times.size());
+    for (size_t i = 0; i < times.size(); i++) {
+        CivilTime when = CivilTime::fromEpoch(times[i]);
+        uint8_t scenario = static_cast<uint8_t>(((times[i] - first) / 16) % Scenarios);
+        specs[i] = EventManager::EventSpec{when.year, when.month, when.day, when.hour, when.minute, when.second,
+                                           scenario, 1, Labels[scenario]};
+    }
+    return specs;
+}
+
+bool fill(const std::vector<EventManager::EventSpec>& specs) {
+    return eventManager.addEvents(specs.data(), specs.size()).accepted == specs.size();
+}
+
+bool scheduleEmpty() {
+    EventManager::EventRange next = eventManager.nextN(1);
+    return !(next.begin() != next.end());
+}
+
+// Calls update() once per virtual second until nothing is left; returns the number of calls
+uint64_t drain(Stopwatch& watch) {
+    uint64_t calls = 0;
+    while (!scheduleEmpty()) {
+        NativeClock::advanceMs(1000);
+        watch.start();
+        timeService.update();
+        eventManager.update();
+        watch.stop();
+        ++calls;
+    }
+    return calls;
+}
+
+void benchStore(size_t n) {
+    const size_t repeats = repeatsFor(n);
+    // 16 s apart, scenario = (offset / 16) % 8: shifting a scenario by a second never collides
+    std::vector<TimeCode> times = makeTimes(n, StartEpoch + 3600, 16);
+    std::vector<EventManager::EventSpec> specs = makeSpecs(times, StartEpoch + 3600);
+    std::vector<TimeCode> removals = makeTimes(n, StartEpoch + 3600, 16);
+    std::reverse(removals.begin(), removals.end());
+
+    Stopwatch add, batch, remove, find;
+    uint64_t found = 0;
+    for (size_t r = 0; r < repeats; r++) {
+        resetAt(StartEpoch);
+        add.start();
+        for (const EventManager::EventSpec& spec : specs) {
+            eventManager.addEvent(spec.year, spec.month, spec.day, spec.hour, spec.minute, spec.second,
+                                  spec.scenario, spec.cycle, spec.description);
+        }
+        add.stop();
+
+        find.start();
+        for (TimeCode t : removals) {
+            ScheduledEvent event;
+            found += eventManager.findEvent(t, event);
+        }
+        find.stop();
+
+        remove.start();
+        for (TimeCode t : removals) {
+            eventManager.removeEvent(t);
+        }
+        remove.stop();
+
+        resetAt(StartEpoch);
+        batch.start();
+        fill(specs);
+        batch.stop();
+    }
+    if (found != n * repeats) fprintf(stderr, "findEvent missed %zu events\n", static_cast<size_t>(n * repeats - found));
+    record("addEvent", "store", n, n * repeats, add.totalUs);
+    record("addEvents", "store", n, n * repeats, batch.totalUs);
+    record("findEvent", "store", n, n * repeats, find.totalUs);
+    record("removeEvent", "store", n, n * repeats, remove.totalUs);
+
+    // Churn: every scenario is moved forward and back a second in turn
+    Stopwatch churn;
+    uint64_t moved = 0;
+    const size_t rounds = std::max<size_t>(2, repeats);
+    resetAt(StartEpoch);
+    fill(specs);
+    churn.start();
+    for (size_t r = 0; r < rounds; r++) {
+        for (uint8_t s = 0; s < Scenarios; s++) {
+            moved += eventManager.rescheduleScenario(s, (r & 1) ? -1 : 1);
+        }
+    }
+    churn.stop();
+    record("rescheduleScenario", "store", n, moved, churn.totalUs);
+
+    // update() with n due events, every one delivered
+    Stopwatch update;
+    delivered = 0;
+    for (size_t r = 0; r < repeats; r++) {
+        resetAt(StartEpoch);
+        fill(specs);
+        for (uint8_t s = 0; s < Scenarios; s++) {
+            eventManager.setCatchUpPolicy(s, EventManager::CatchUpPolicy::FireAll);
+        }
+        NativeClock::advanceMs((3600 + 16 * n) * 1000);
+        drain(update);
+    }
+    if (delivered != n * repeats) {
+        fprintf(stderr, "update() delivered %u of %zu events\n", delivered, n * repeats);
+    }
+    record("update.fireAll", "store", n, delivered, update.totalUs);
+
+    // The same backlog after an outage, coalesced by the default policy
+    Stopwatch recover;
+    uint64_t calls = 0;
+    delivered = 0;
+    for (size_t r = 0; r < repeats; r++) {
+        resetAt(StartEpoch);
+        fill(specs);
+        NativeClock::advanceMs((3600 + 16 * n) * 1000);
+        calls += drain(recover);
+    }
+    checkCoalesced("store", n, repeats);
+    record("update.catchUp", "store", n, calls, recover.totalUs);
+}
+
+// In-memory image equivalent to what tools/schedule_tool builds
+std::vector<uint32_t> buildImage(const std::vector<TimeCode>& sortedTimes) {
+    std::vector<char> strings(1, '\0');
+    uint16_t offsets[Scenarios];
+    for (uint8_t s = 0; s < Scenarios; s++) {
+        offsets[s] = static_cast<uint16_t>(strings.size());
+        strings.insert(strings.end(), Labels[s], Labels[s] + strlen(Labels[s]) + 1);
+    }
+    while (strings.size() % 4) strings.push_back('\0');
+
+    ImageHeader header = {};
+    header.magic = ScheduleImage::Magic;
+    header.version = ScheduleImage::Version;
+    header.headerSize = sizeof(ImageHeader);
+    header.eventCount = static_cast<uint32_t>(sortedTimes.size());
+    header.stringsOffset = static_cast<uint32_t>(sizeof(ImageHeader) + sortedTimes.size() * sizeof(ImageEvent));
+    header.stringsSize = static_cast<uint32_t>(strings.size());
+
+    std::vector<uint32_t> storage((header.stringsOffset + header.stringsSize) / 4);
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(storage.data());
+    ImageEvent* events = reinterpret_cast<ImageEvent*>(bytes + sizeof(ImageHeader));
+    for (size_t i = 0; i < sortedTimes.size(); i++) {
+        uint8_t scenario = static_cast<uint8_t>(((sortedTimes[i] - sortedTimes.front()) / 16) % Scenarios);
+        events[i] = ImageEvent{sortedTimes[i], scenario, 1, offsets[scenario]};
+    }
+    memcpy(bytes + header.stringsOffset, strings.data(), strings.size());
+
+    header.payloadCrc = ScheduleImage::crc32(bytes + sizeof(ImageHeader), storage.size() * 4 - sizeof(ImageHeader));
+    header.headerCrc = ScheduleImage::crc32(&header, offsetof(ImageHeader, headerCrc));
+    memcpy(bytes, &header, sizeof(header));
+    return storage;
+}
+
+void benchImage(size_t n) {
+    const size_t repeats = repeatsFor(n);
+    std::vector<TimeCode> times = makeTimes(n, StartEpoch + 3600, 16);
+    std::sort(times.begin(), times.end());
+    std::vector<uint32_t> storage = buildImage(times);
+    const size_t size = storage.size() * sizeof(uint32_t);
+
+    ScheduleImage image;
+    Stopwatch load, verify, query;
+    uint64_t viewed = 0;
+    for (size_t r = 0; r < repeats; r++) {
+        resetAt(StartEpoch + 1800 + static_cast<uint32_t>(8 * n));  // Boot half-way through the schedule
+        load.start();
+        bool ok = image.open(storage.data(), size) == ScheduleImage::Status::Ok && eventManager.loadImage(image);
+        load.stop();
+        if (!ok) {
+            fprintf(stderr, "image with %zu events did not load\n", n);
+            return;
+        }
+
+        verify.start();
+        ScheduleImage::Status status = image.verify();
+        verify.stop();
+        if (status != ScheduleImage::Status::Ok) fprintf(stderr, "verify: %s\n", ScheduleImage::statusName(status));
+
+        query.start();
+        for (const EventManager::EventView& view : eventManager.nextN(16)) {
+            viewed += view.description[0] != '\0';
+        }
+        query.stop();
+    }
+    record("loadImage", "image", n, repeats, load.totalUs);
+    record("verify", "image", n, repeats, verify.totalUs);
+    record("nextN.16", "image", n, viewed, query.totalUs);
+
+    // Image events are whole seconds, whatever the caller's record held before
+    EventManager::Event found;
+    found.millisecond = 250;
+    if (!eventManager.findEvent(times.back(), found) || found.millisecond != 0) {
+        fprintf(stderr, "findEvent kept a stale millisecond on an image event\n");
+    }
+
+    Stopwatch update;
+    delivered = 0;
+    for (size_t r = 0; r < repeats; r++) {
+        resetAt(StartEpoch);
+        image.open(storage.data(), size);
+        eventManager.loadImage(image);
+        for (uint8_t s = 0; s < Scenarios; s++) {
+            eventManager.setCatchUpPolicy(s, EventManager::CatchUpPolicy::FireAll);
+        }
+        NativeClock::advanceMs((3600 + 16 * n) * 1000);
+        drain(update);
+    }
+    if (delivered != n * repeats) {
+        fprintf(stderr, "update() delivered %u of %zu image events\n", delivered, n * repeats);
+    }
+    record("update.fireAll", "image", n, delivered, update.totalUs);
+
+    Stopwatch recover;
+    uint64_t calls = 0;
+    delivered = 0;
+    for (size_t r = 0; r < repeats; r++) {
+        resetAt(StartEpoch);
+        image.open(storage.data(), size);
+        eventManager.loadImage(image);
+        NativeClock::advanceMs((3600 + 16 * n) * 1000);
+        calls += drain(recover);
+    }
+    checkCoalesced("image", n, repeats);
+    record("update.catchUp", "image", n, calls, recover.totalUs);
+    eventManager.clearEvents();
+}
+
+void printJson(const char* commit) {
+    printf("{\n  \"suite\": \"scheduler\",\n  \"commit\": \"%s\",\n", commit);
+    printf("  \"capacity\": %d,\n", EVENT_MANAGER_CAPACITY);
+    printf("  \"memory\": {\"event_bytes\": %zu, \"store_bytes_per_event\": %.2f, \"image_bytes_per_event\": %zu, "
+           "\"label_table_bytes\": %zu, \"event_manager_bytes\": %zu},\n",
+           sizeof(ScheduledEvent), static_cast<double>(sizeof(EventManager::Schedule)) / EVENT_MANAGER_CAPACITY,
+           sizeof(ImageEvent), sizeof(LabelTable), sizeof(EventManager));
+    printf("  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        printf("    {\"name\": \"%s\", \"source\": \"%s\", \"events\": %zu, \"ops\": %llu, \"total_us\": %.1f, "
+               "\"ns_per_op\": %.1f}%s\n",
+               result.name, result.source, result.events, static_cast<unsigned long long>(result.ops),
+               result.totalUs, result.ops ? result.totalUs * 1000.0 / result.ops : 0.0,
+               i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* commit = argc > 1 ? argv[1] : getenv("GIT_COMMIT");
+    eventManager.getDispatcher().subscribe(countDelivered, nullptr, EventFilter::all(), "bench");
+
+    for (size_t n : Sizes) {
+        if (n <= EVENT_MANAGER_CAPACITY) benchStore(n);
+        benchImage(n);
+    }
+    printJson(commit ? commit : "unknown");
+    return 0;
+}
@@ -0,0 +1,123 @@
+// soft_clock_test.cpp
+// Host simulation of TimeService/SoftClock against the mock DS3231 in bench/native with
+// injected crystal drift. Runs four simulated hours per drift rate with an uneven loop
+// period, and checks the error against the RTC's own time, that secondTicked() reports
+// every second exactly once, and that each discipline pass finds the seconds edge in a
+// handful of RTC reads. Exits non-zero when a check fails.
+// Build: g++ -O2 -std=gnu++17 -Ibench/native -Iinclude bench/soft_clock_test.cpp src/TimeService.cpp
+//        src/SoftClock.cpp -o soft_clock_test
+#include <Arduino.h>
+#include <RTClib.h>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include "CivilTime.h"
+#include "TimeService.h"
+
+namespace {
+
+constexpr uint32_t StartEpoch = CivilTime::toEpoch(2024, 7, 20, 6, 0, 0);
+constexpr uint64_t RunUs = 4ULL * 3600 * 1000000;
+constexpr uint64_t SettleUs = 2ULL * TIME_SERVICE_DISCIPLINE_MS * 1000;  // Two discipline passes to learn the drift
+constexpr int32_t DriftRates[] = {-150, -20, 0, 20, 150};
+constexpr int64_t MaxSettledErrorMs = 15;
+constexpr int64_t MaxErrorMs = 150;  // Before the first drift estimate: 10 minutes at 150 ppm plus edge uncertainty
+constexpr uint32_t MaxReadsPerPass = 10;         // Seek start, the lead polls and the edge itself
+constexpr uint32_t MaxReadsPerUnmeasuredPass = 30;  // Extra lead of up to 2 x 200 ppm while the drift is unknown
+
+struct Run {
+    int64_t maxErrorMs;
+    int64_t maxSettledErrorMs;
+    uint32_t ticks;
+    uint32_t skipped;
+    uint32_t repeated;
+    int32_t driftPpm;
+    uint32_t rtcReads;
+    uint32_t maxReadsPerPass;  // After the drift is measured
+    uint32_t firstPassReads;
+};
+
+int64_t magnitude(int64_t value) {
+    return value < 0 ? -value : value;
+}
+
+Run simulate(int32_t driftPpm) {
+    NativeClock::nowUs = 0;
+    RTC_DS3231 rtc;
+    rtc.adjust(DateTime(StartEpoch));
+    NativeClock::advanceUs(437000);  // Start off the RTC's second boundary
+    rtc.setDriftPpm(driftPpm);
+
+    TimeService timeService(rtc);
+    timeService.begin();
+    std::mt19937 rng(static_cast<uint32_t>(driftPpm + 1000));
+    std::uniform_int_distribution<uint32_t> loopUs(200, 4000);
+
+    Run run{};
+    bool ticking = false;
+    TimeCode lastTick = 0;
+    // Discipline passes run about one interval after the first lock, early in the run;
+    // counting reads per interval-long window gives the reads of one pass
+    const uint64_t windowUs = static_cast<uint64_t>(TIME_SERVICE_DISCIPLINE_MS) * 1000;
+    uint64_t windowEndUs = windowUs;
+    uint32_t windowStartReads = 0;
+    uint32_t window = 0;
+    while (NativeClock::nowUs < RunUs) {
+        NativeClock::advanceUs(loopUs(rng));
+        timeService.update();
+
+        if (NativeClock::nowUs >= windowEndUs) {
+            uint32_t reads = timeService.getRtcReads() - windowStartReads;
+            if (window == 1) run.firstPassReads = reads;
+            if (window >= 2 && reads > run.maxReadsPerPass) run.maxReadsPerPass = reads;
+            windowStartReads = timeService.getRtcReads();
+            windowEndUs += windowUs;
+            ++window;
+        }
+
+        // Error against the RTC is only meaningful once the first seconds edge was found
+        if (timeService.getRtcReads() > 2) {
+            int64_t error = magnitude(static_cast<int64_t>(timeService.nowMs()) -
+                                      static_cast<int64_t>(rtc.preciseUs() / 1000));
+            if (error > run.maxErrorMs) run.maxErrorMs = error;
+            if (NativeClock::nowUs >= SettleUs && error > run.maxSettledErrorMs) run.maxSettledErrorMs = error;
+        }
+
+        if (!timeService.secondTicked()) continue;
+        TimeCode second = timeService.now();
+        if (ticking) {
+            if (second == lastTick) ++run.repeated;
+            if (second > lastTick + 1) run.skipped += second - lastTick - 1;
+            if (second < lastTick) ++run.repeated;
+        }
+        ticking = true;
+        lastTick = second;
+        ++run.ticks;
+    }
+    run.driftPpm = timeService.getDriftPpm();
+    run.rtcReads = timeService.getRtcReads();
+    return run;
+}
+
+}  // namespace
+
+int main() {
+    int failures = 0;
+    for (int32_t drift : DriftRates) {
+        Run run = simulate(drift);
+        std::printf("drift %+4d ppm: estimate %+4d ppm, max error %3lld ms, settled %2lld ms, "
+                    "%u ticks, %u skipped, %u repeated, %u RTC reads (%u first pass, max %u per pass)\n",
+                    static_cast<int>(drift), static_cast<int>(-run.driftPpm), static_cast<long long>(run.maxErrorMs),
+                    static_cast<long long>(run.maxSettledErrorMs), run.ticks, run.skipped, run.repeated,
+                    run.rtcReads, run.firstPassReads, run.maxReadsPerPass);
+
+        bool ok = run.skipped == 0 && run.repeated == 0 && run.maxErrorMs <= MaxErrorMs &&
+                  run.maxSettledErrorMs <= MaxSettledErrorMs && run.firstPassReads <= MaxReadsPerUnmeasuredPass &&
+                  run.maxReadsPerPass <= MaxReadsPerPass;
+        if (!ok) {
+            std::fprintf(stderr, "FAIL: drift %+d ppm\n", static_cast<int>(drift));
+            ++failures;
+        }
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,74 @@
+// CivilTime.h
+#ifndef CIVIL_TIME_H
+#define CIVIL_TIME_H
+
+#include <cstdint>
+
+// Calendar fields <-> seconds since 1970-01-01 using integer-only arithmetic
+// (Howard Hinnant's days_from_civil / civil_from_days). Valid for 1970..2105.
+struct CivilTime {
+    static constexpr uint32_t SecondsPerDay = 86400;
+
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+
+    static constexpr int32_t daysFromCivil(int32_t y, uint32_t m, uint32_t d) {
+        y -= m <= 2;
+        const int32_t era = (y >= 0 ? y : y - 399) / 400;
+        const uint32_t yoe = static_cast<uint32_t>(y - era * 400);
+        const uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int32_t>(doe) - 719468;
+    }
+
+    static constexpr CivilTime fromDays(int32_t days) {
+        days += 719468;
+        const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+        const uint32_t doe = static_cast<uint32_t>(days - era * 146097);
+        const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const uint32_t mp = (5 * doy + 2) / 153;
+        const uint32_t d = doy - (153 * mp + 2) / 5 + 1;
+        const uint32_t m = mp < 10 ? mp + 3 : mp - 9;
+        const int32_t y = static_cast<int32_t>(yoe) + era * 400 + (m <= 2);
+        return CivilTime{static_cast<uint16_t>(y), static_cast<uint8_t>(m), static_cast<uint8_t>(d), 0, 0, 0};
+    }
+
+    static constexpr CivilTime fromEpoch(uint32_t seconds) {
+        CivilTime t = fromDays(static_cast<int32_t>(seconds / SecondsPerDay));
+        uint32_t secondOfDay = seconds % SecondsPerDay;
+        t.hour = secondOfDay / 3600;
+        t.minute = (secondOfDay / 60) % 60;
+        t.second = secondOfDay % 60;
+        return t;
+    }
+
+    static constexpr uint32_t toEpoch(uint16_t year, uint8_t month, uint8_t day,
+                                      uint8_t hour, uint8_t minute, uint8_t second) {
+        return static_cast<uint32_t>(daysFromCivil(year, month, day)) * SecondsPerDay +
+               hour * 3600UL + minute * 60UL + second;
+    }
+
+    constexpr uint32_t toEpoch() const {
+        return toEpoch(year, month, day, hour, minute, second);
+    }
+
+    // 0 = Sunday, matching DateTime::dayOfTheWeek().
+    static constexpr uint8_t dayOfWeek(uint32_t seconds) {
+        return static_cast<uint8_t>((seconds / SecondsPerDay + 4) % 7);
+    }
+
+    static constexpr uint32_t startOfDay(uint32_t seconds) {
+        return seconds - seconds % SecondsPerDay;
+    }
+};
+
+static_assert(CivilTime::toEpoch(2000, 1, 1, 0, 0, 0) == 946684800UL, "CivilTime epoch mismatch");
+static_assert(CivilTime::fromEpoch(951782400UL).day == 29, "CivilTime leap day mismatch");
+static_assert(CivilTime::dayOfWeek(946684800UL) == 6, "2000-01-01 was a Saturday");
+
+#endif // CIVIL_TIME_H
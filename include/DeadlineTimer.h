@@ -0,0 +1,130 @@
+// DeadlineTimer.h
+#ifndef DEADLINE_TIMER_H
+#define DEADLINE_TIMER_H
+
+#include <cstdint>
+
+// One-shot wake-up source for deadline-driven scheduling. EventManager arms it with the
+// delay to the next event; the implementation signals when that delay has elapsed and
+// may block the waiting task until then so the core stays idle.
+class DeadlineTimer {
+public:
+    virtual ~DeadlineTimer() {}
+    virtual bool begin() { return true; }
+    virtual void arm(uint32_t delayMs) = 0;
+    virtual void disarm() = 0;
+
+    // Blocks the caller until the deadline fires or maxWaitMs elapses. The default does not block.
+    virtual void wait(uint32_t maxWaitMs) { (void)maxWaitMs; }
+
+    bool hasFired() const { return fired; }
+
+    bool consumeFired() {
+        if (!fired) return false;
+        fired = false;
+        return true;
+    }
+
+protected:
+    DeadlineTimer() : fired(false) {}
+    void signal() { fired = true; }
+
+private:
+    volatile bool fired;
+};
+
+// Host stand-in driven by simulated time. wait() only counts calls; the simulation
+// moves its clock by getRemainingMs() and calls advance() in place of sleeping.
+class SimulatedDeadline : public DeadlineTimer {
+public:
+    SimulatedDeadline() : armed(false), remainingMs(0), armCount(0), waitCount(0) {}
+
+    void arm(uint32_t delayMs) override {
+        armed = true;
+        remainingMs = delayMs;
+        ++armCount;
+    }
+
+    void disarm() override { armed = false; }
+
+    void wait(uint32_t maxWaitMs) override {
+        (void)maxWaitMs;
+        ++waitCount;
+    }
+
+    void advance(uint32_t ms) {
+        if (!armed) return;
+        if (ms >= remainingMs) {
+            armed = false;
+            remainingMs = 0;
+            signal();
+        } else {
+            remainingMs -= ms;
+        }
+    }
+
+    bool isArmed() const { return armed; }
+    uint32_t getRemainingMs() const { return remainingMs; }
+    uint32_t getArmCount() const { return armCount; }
+    uint32_t getWaitCount() const { return waitCount; }
+
+private:
+    bool armed;
+    uint32_t remainingMs;
+    uint32_t armCount;
+    uint32_t waitCount;
+};
+
+#if defined(ESP32)
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "RTClib.h"
+
+class TimeService;
+
+// Wakes the task that called begin() via a FreeRTOS task notification.
+class NotifyingDeadline : public DeadlineTimer {
+public:
+    bool begin() override;
+    void wait(uint32_t maxWaitMs) override;
+
+protected:
+    NotifyingDeadline() : task(nullptr) {}
+    void notify();
+    void notifyFromISR();
+
+private:
+    TaskHandle_t task;
+};
+
+// Microsecond-resolution one-shot esp_timer.
+class EspTimerDeadline : public NotifyingDeadline {
+public:
+    EspTimerDeadline() : timer(nullptr) {}
+    bool begin() override;
+    void arm(uint32_t delayMs) override;
+    void disarm() override;
+
+private:
+    esp_timer_handle_t timer;
+    static void onTimer(void* arg);
+};
+
+// DS3231 alarm 1 matched on date and time, reported through the INT/SQW pin.
+// One-second resolution, but fires on the RTC's own second edge and survives CPU light sleep.
+class Ds3231AlarmDeadline : public NotifyingDeadline {
+public:
+    Ds3231AlarmDeadline(RTC_DS3231& rtc, TimeService& clock, uint8_t interruptPin);
+    bool begin() override;
+    void arm(uint32_t delayMs) override;
+    void disarm() override;
+
+private:
+    RTC_DS3231& rtc;
+    TimeService& clock;
+    uint8_t interruptPin;
+    static void IRAM_ATTR onAlarm(void* arg);
+};
+#endif // ESP32
+
+#endif // DEADLINE_TIMER_H
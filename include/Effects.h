@@ -0,0 +1,443 @@
+// Effects.h
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <Adafruit_SSD1306.h>
+#include <Adafruit_GFX.h>
+#include "FixedMath.h"
+#include "PackedFrame.h"
+#include "LifeGrid.h"
+
+#ifndef EFFECT_QUEUE_CAPACITY
+#define EFFECT_QUEUE_CAPACITY 16
+#endif
+
+// One display animation as a resumable state machine. start() sets it up and each
+// tick() draws at most one frame into the framebuffer, only when it is due, and returns
+// at once. The waits that used to be delay() calls are the time to the next frame.
+class Effect {
+public:
+    static constexpr uint32_t Stop = 0xFFFFFFFF;  // From render(): the effect is over
+
+    explicit Effect(Adafruit_SSD1306& display);
+    virtual ~Effect() {}
+
+    void start(uint32_t nowMs);
+    void cancel() { running = false; }
+    bool tick(uint32_t nowMs);  // True when a frame was drawn
+    bool isRunning() const { return running; }
+    uint32_t getNextFrameMs() const { return nextFrameMs; }
+
+protected:
+    Adafruit_SSD1306& display;
+    const int16_t width;
+    const int16_t height;
+
+    virtual void reset() {}
+    PackedFrame packedFrame() { return PackedFrame(display.getBuffer(), width, height); }
+    // Draws frame n of the run. Returns the milliseconds until the next frame, or Stop,
+    // without drawing, once the effect is over.
+    virtual uint32_t render(uint32_t frame, uint32_t elapsedMs) = 0;
+
+private:
+    uint32_t frame;
+    uint32_t startMs;
+    uint32_t nextFrameMs;
+    bool running;
+};
+
+// Plays queued effects one after another, one frame per tick(). The caller flushes the
+// display after a tick() that drew and may sleep for msUntilNextFrame() in between, so
+// rendering interleaves with whatever else the task does.
+class FrameScheduler {
+public:
+    static constexpr uint32_t Idle = 0xFFFFFFFF;
+
+    FrameScheduler();
+    bool play(Effect& effect);
+    void stop();
+    bool tick(uint32_t nowMs);
+    uint32_t msUntilNextFrame(uint32_t nowMs) const;  // Idle when nothing is queued
+    bool isBusy() const { return current != nullptr || count > 0; }
+    uint32_t getFramesDrawn() const { return framesDrawn; }
+
+private:
+    Effect* queue[EFFECT_QUEUE_CAPACITY];
+    uint8_t head;
+    uint8_t count;
+    Effect* current;
+    uint32_t framesDrawn;
+};
+
+class FlickerEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+};
+
+// Random pixels for durationMs, a new pattern every frameMs; with blankMs, every other
+// frame is blank for that long.
+class TvNoiseEffect : public Effect {
+public:
+    TvNoiseEffect(Adafruit_SSD1306& display, uint32_t durationMs, uint16_t frameMs, uint16_t blankMs = 0)
+        : Effect(display), durationMs(durationMs), frameMs(frameMs), blankMs(blankMs) {}
+
+protected:
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    uint32_t durationMs;
+    uint16_t frameMs;
+    uint16_t blankMs;
+    FastRandom rng;
+
+    void reset() override;
+};
+
+class FadeOutEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    FastRandom rng;
+};
+
+class ScanLinesEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+};
+
+// Horizontal lines filling the screen from the top, every other row
+class SweepEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+};
+
+class GeometricShapesEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+};
+
+class TextEmergenceEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    int16_t x = 0;
+    int16_t y = 0;
+};
+
+class MatrixEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    static const int NumDrops = 10;
+    int drops[NumDrops];
+};
+
+class SpiralEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    float angle = 0;
+    float radius = 0;
+};
+
+class BounceEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    int x = 0;
+    int y = 0;
+    int dx = 2;
+    int dy = 2;
+};
+
+class WaveEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+};
+
+// Stars drifting left, or falling down when vertical
+class StarfieldEffect : public Effect {
+public:
+    StarfieldEffect(Adafruit_SSD1306& display, bool vertical) : Effect(display), vertical(vertical) {}
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    static const int NumStars = 50;
+    bool vertical;
+    int starX[NumStars];
+    int starY[NumStars];
+    int starSpeed[NumStars];
+};
+
+// Mandelbrot or Julia set, drawn four columns per frame
+class FractalEffect : public Effect {
+public:
+    FractalEffect(Adafruit_SSD1306& display, bool julia) : Effect(display), julia(julia) {}
+
+protected:
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    bool julia;
+
+    static bool escapes(float x, float y, float cx, float cy, int maxIterations);
+};
+
+class LSystemTreeEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    void drawTree(int x, int y, Angle angle, int depth);
+};
+
+// Sum of three sine fields, thresholded; fixed point throughout, for panels up to 128x64
+class PlasmaEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+};
+
+class ParticleSystemEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    static const int NumParticles = 50;
+    float particles[NumParticles][4];  // x, y, dx, dy
+};
+
+// Wrapping Conway's life, one generation per frame
+class GameOfLifeEffect : public Effect {
+public:
+    explicit GameOfLifeEffect(Adafruit_SSD1306& display) : Effect(display), life(width, height) {}
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    LifeGrid life;
+    FastRandom rng;
+};
+
+class VortexEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    struct Particle {
+        Fixed16 x, y;
+        Fixed16 vx, vy;
+        Fixed16 life;
+    };
+
+    static const int NumParticles = 100;
+    Particle particles[NumParticles];
+
+    void respawn(Particle& p);
+};
+
+class RainEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    struct Raindrop {
+        int x, y;
+        int speed;
+        int size;
+    };
+
+    struct Ripple {
+        int x, y;
+        int size;
+        int life;
+    };
+
+    static const int NumRaindrops = 15;
+    static const int MaxRipples = 10;
+    Raindrop raindrops[NumRaindrops];
+    Ripple ripples[MaxRipples];
+    int rippleCount = 0;
+};
+
+class DynamicWaveEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    static const int NumWaves = 3;
+    Fixed16 amplitudes[NumWaves];  // This frame's, including the slow modulation
+
+    int waveAt(int x, int32_t time) const;
+};
+
+class CyberGridEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    struct EnergyLine {
+        int x, y;
+        int length;
+        int speed;
+        bool vertical;
+    };
+
+    static const int GridSize = 16;
+    static const int NumEnergyLines = 5;
+    EnergyLine energyLines[NumEnergyLines];
+};
+
+// Stars flying towards the viewer
+class WarpStarfieldEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    static const int NumStars = 100;
+    int stars[NumStars][3];  // x, y, brightness
+    float z = 0;
+};
+
+class ParticleExplosionEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    struct Particle {
+        int x, y;
+        float vx, vy;
+        int lifetime;
+    };
+
+    static const int NumParticles = 100;
+    Particle particles[NumParticles];
+};
+
+class MarbleDropEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    struct Marble {
+        float x, y;    // Position
+        float vy;      // Vertical velocity
+        float radius;  // Marble radius
+        bool active;   // Whether the marble is still bouncing
+    };
+
+    static const int NumMarbles = 5;
+    Marble marbles[NumMarbles];
+
+    void drop(Marble& marble);
+    void update(Marble& marble, float dt);
+};
+
+// A random message whose letters fall and bounce into place
+class FallingLettersEffect : public Effect {
+public:
+    using Effect::Effect;
+
+protected:
+    void reset() override;
+    uint32_t render(uint32_t frame, uint32_t elapsedMs) override;
+
+private:
+    struct FallingLetter {
+        char letter;
+        float x, y;
+        float vy;
+        bool settled;
+        float targetY;
+    };
+
+    static const int MaxLetters = 24;
+    FallingLetter letters[MaxLetters];
+    uint8_t letterCount = 0;
+    bool finished = false;
+
+    void update(FallingLetter& letter);
+};
+
+#endif // EFFECTS_H
@@ -0,0 +1,82 @@
+// EventDispatcher.h
+#ifndef EVENT_DISPATCHER_H
+#define EVENT_DISPATCHER_H
+
+#include <Arduino.h>
+#include <cstdint>
+#include "EventStore.h"
+
+#ifndef EVENT_SUBSCRIBER_CAPACITY
+#define EVENT_SUBSCRIBER_CAPACITY 8
+#endif
+
+// Which events a subscriber receives. Bit n selects scenario (or cycle) n for n < 32;
+// a full mask also matches numbers from 32 up.
+struct EventFilter {
+    static constexpr uint32_t Any = 0xFFFFFFFF;
+
+    uint32_t scenarios;
+    uint32_t cycles;
+
+    static constexpr EventFilter all() { return EventFilter{Any, Any}; }
+    static constexpr EventFilter scenario(uint8_t s) { return EventFilter{bit(s), Any}; }
+    static constexpr EventFilter cycle(uint8_t c) { return EventFilter{Any, bit(c)}; }
+
+    constexpr bool matches(const ScheduledEvent& event) const {
+        return (scenarios == Any || (scenarios & bit(event.scenario)) != 0) &&
+               (cycles == Any || (cycles & bit(event.cycle)) != 0);
+    }
+
+    static constexpr uint32_t bit(uint8_t n) { return n < 32 ? 1UL << n : 0; }
+};
+
+// Fixed table of event subscribers, each a function pointer plus context, so binding
+// never allocates. Every call is timed, so a slow consumer shows up in the stats.
+// Subscribe before events start firing; dispatch() runs on the dispatching task.
+class EventDispatcher {
+public:
+    using Handler = void (*)(const ScheduledEvent& event, void* context);
+
+    struct Stats {
+        const char* name;
+        uint32_t calls;
+        uint32_t totalUs;
+        uint32_t maxUs;
+    };
+
+    EventDispatcher();
+
+    // Returns the subscriber id, or -1 when every slot is taken.
+    int subscribe(Handler handler, void* context, EventFilter filter = EventFilter::all(), const char* name = "");
+
+    // Binds a member function at compile time: subscribe<RenderTask, &RenderTask::publishEvent>(renderTask)
+    template <typename T, void (T::*Method)(const ScheduledEvent&)>
+    int subscribe(T& target, EventFilter filter = EventFilter::all(), const char* name = "") {
+        return subscribe(&invokeMember<T, Method>, &target, filter, name);
+    }
+
+    bool unsubscribe(int id);
+    void dispatch(const ScheduledEvent& event);
+
+    bool getStats(int id, Stats& stats) const;
+    int slowestSubscriber() const;  // Highest worst-case call time, or -1
+    void resetStats();
+    void printStats() const;
+
+private:
+    struct Subscriber {
+        Handler handler;  // nullptr marks a free slot
+        void* context;
+        EventFilter filter;
+        Stats stats;
+    };
+
+    Subscriber subscribers[EVENT_SUBSCRIBER_CAPACITY];
+
+    template <typename T, void (T::*Method)(const ScheduledEvent&)>
+    static void invokeMember(const ScheduledEvent& event, void* context) {
+        (static_cast<T*>(context)->*Method)(event);
+    }
+};
+
+#endif // EVENT_DISPATCHER_H
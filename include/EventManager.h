@@ -2,77 +2,308 @@
 #ifndef EVENT_MANAGER_H
 #define EVENT_MANAGER_H
 
-#include <set>
-#include <queue>
-#include <functional>
 #include <cstdint>
 #include <Arduino.h>
-#include "RTClib.h"
+#include "TimeService.h"
+#include "EventStore.h"
+#include "SpscRing.h"
+#include "Recurrence.h"
+#include "DeadlineTimer.h"
+#include "ScheduleImage.h"
+#include "EventDispatcher.h"
+
+#ifndef EVENT_MANAGER_CAPACITY
+#define EVENT_MANAGER_CAPACITY 256
+#endif
+
+#ifndef EVENT_PENDING_CAPACITY
+#define EVENT_PENDING_CAPACITY 16
+#endif
+
+#ifndef EVENT_RULE_CAPACITY
+#define EVENT_RULE_CAPACITY 32
+#endif
+
+#ifndef EVENT_BATCH_ISSUE_CAPACITY
+#define EVENT_BATCH_ISSUE_CAPACITY 8
+#endif
+
+#ifndef EVENT_CATCH_UP_WINDOW
+#define EVENT_CATCH_UP_WINDOW 60  // Seconds overdue before an event counts as missed
+#endif
+
+#ifndef EVENT_IMAGE_MASK_CAPACITY
+#define EVENT_IMAGE_MASK_CAPACITY 16
+#endif
+
+#ifndef EVENT_PRECISE_CAPACITY
+#define EVENT_PRECISE_CAPACITY 16  // Millisecond events queued at once, e.g. the intervals of a phase change
+#endif
 
 class EventManager {
 public:
-    struct Event {
-        uint64_t timeCode;
+    using Event = ScheduledEvent;
+    using Schedule = EventStore<EVENT_MANAGER_CAPACITY>;
+    using ScenarioRange = Schedule::ScenarioRange;
+
+    // How many pending events one dispatch pass delivers.
+    enum class DrainPolicy : uint8_t {
+        All,         // Everything that is pending
+        PerTick,     // At most `limit` events
+        TimeBudget   // Until `limit` microseconds have been spent (always at least one event)
+    };
+
+    // What happens to events that are overdue by more than the catch-up window, as after
+    // a power loss, an RTC step or a long stall.
+    enum class CatchUpPolicy : uint8_t {
+        Latest,   // Coalesce: only the most recent missed event overall is delivered (default)
+        FireAll,  // Deliver every missed event of the scenario, oldest first
+        Skip      // Drop missed events of the scenario; they never become the effective state
+    };
+
+    // One entry of an addEvents() batch, with the same meaning as the addEvent() arguments.
+    struct EventSpec {
+        uint16_t year;
+        uint8_t month;
+        uint8_t day;
+        uint8_t hour;
+        uint8_t minute;
+        uint8_t second;
         uint8_t scenario;
         uint8_t cycle;
-        String description;
-        bool isDaily;
-
-        Event(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second, 
-              uint8_t sc, uint8_t cy, const String& desc = "", bool daily = false)
-            : timeCode(encodeTime(year, month, day, hour, minute, second)), 
-              scenario(sc), cycle(cy), description(desc), isDaily(daily) {}
-
-        bool operator<(const Event& other) const {
-            return timeCode < other.timeCode;
-        }
-
-        static uint64_t encodeTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second) {
-            return ((uint64_t)year << 40) | ((uint64_t)month << 32) | ((uint64_t)day << 24) | 
-                   ((uint64_t)hour << 16) | ((uint64_t)minute << 8) | second;
-        }
-
-        static void decodeTime(uint64_t timeCode, uint16_t& year, uint8_t& month, uint8_t& day, 
-                               uint8_t& hour, uint8_t& minute, uint8_t& second) {
-            year = (timeCode >> 40) & 0xFFFF;
-            month = (timeCode >> 32) & 0xFF;
-            day = (timeCode >> 24) & 0xFF;
-            hour = (timeCode >> 16) & 0xFF;
-            minute = (timeCode >> 8) & 0xFF;
-            second = timeCode & 0xFF;
-        }
+        const char* description = "";
+        bool isDaily = false;
     };
 
-    using EventCallback = std::function<void(const Event&)>;
+    enum class BatchProblem : uint8_t {
+        InvalidTime,   // Date or time out of range
+        TimeTaken,     // Same second as a scheduled event, an image event or an earlier batch entry
+        StoreFull,
+        LabelsFull,    // No room left in the label table for a new description
+        RuleRejected   // Daily entry whose rule could not be added
+    };
+
+    struct BatchIssue {
+        uint32_t index;  // Position in the batch
+        BatchProblem problem;
+        TimeCode timeCode;
+    };
+
+    struct BatchReport {
+        uint32_t accepted;
+        uint32_t rejected;
+        uint8_t issueCount;  // Details of the first EVENT_BATCH_ISSUE_CAPACITY rejections
+        BatchIssue issues[EVENT_BATCH_ISSUE_CAPACITY];
+
+        bool ok() const { return rejected == 0; }
+    };
 
-    EventManager(RTC_DS3231& rtc);
+    static constexpr TimeCode NoTimeCode = 0xFFFFFFFF;
+
+    // One applied change to the overlay, reported to the edit handler, e.g. for a journal.
+    // Image loading and millisecond events are not reported.
+    enum class EditKind : uint8_t {
+        EventAdded,          // timeCode, scenario, cycle, description
+        EventRemoved,        // timeCode
+        RuleAdded,           // ruleId, rule, scenario, cycle, description
+        RuleRemoved,         // ruleId
+        ScenarioRemoved,     // scenario
+        ScenarioRescheduled, // scenario, offsetSeconds
+        Cleared
+    };
+
+    struct ScheduleEdit {
+        EditKind kind;
+        TimeCode timeCode;
+        uint8_t scenario;
+        uint8_t cycle;
+        uint8_t ruleId;
+        int32_t offsetSeconds;
+        const RecurrenceRule* rule;
+        const char* description;
+    };
+
+    using EditHandler = void (*)(const ScheduleEdit& edit, void* context);
+
+    // Read-only view of one scheduled event, from the overlay or the image. The
+    // description points into the label table or the image; nothing is copied.
+    struct EventView {
+        TimeCode timeCode;
+        uint8_t scenario;
+        uint8_t cycle;
+        uint8_t rule;
+        const char* description;
+    };
+
+    // Chronological range over events not yet delivered, merging the overlay and the
+    // image without allocating. Any change to the schedule invalidates it.
+    class EventRange {
+    public:
+        class const_iterator {
+        public:
+            const EventView& operator*() const { return current; }
+            const EventView* operator->() const { return &current; }
+            const_iterator& operator++() {
+                advance();
+                return *this;
+            }
+            bool operator==(const const_iterator& other) const {
+                return done == other.done && (done || current.timeCode == other.current.timeCode);
+            }
+            bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+        private:
+            friend class EventRange;
+
+            const_iterator(const EventManager* manager, Schedule::const_iterator stored, uint32_t imageIndex,
+                           TimeCode until, int16_t scenario, size_t remaining);
+
+            const EventManager* manager;
+            Schedule::const_iterator stored;
+            uint32_t imageIndex;
+            TimeCode until;
+            int16_t scenario;  // -1 matches every scenario
+            size_t remaining;
+            EventView current;
+            bool done;
+
+            void advance();
+        };
+
+        const_iterator begin() const;
+        const_iterator end() const;
+
+    private:
+        friend class EventManager;
+
+        EventRange(const EventManager* manager, TimeCode from, TimeCode until, int16_t scenario, size_t limit)
+            : manager(manager), from(from), until(until), scenario(scenario), limit(limit) {}
+
+        const EventManager* manager;
+        TimeCode from;
+        TimeCode until;
+        int16_t scenario;
+        size_t limit;
+    };
+
+    EventManager(TimeService& clock);
     void begin();
     bool addEvent(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second, 
-                  uint8_t scenario, uint8_t cycle, const String& description = "", bool isDaily = false);
-    bool removeEvent(uint64_t timeCode);
+                  uint8_t scenario, uint8_t cycle, const char* description = "", bool isDaily = false);
+    BatchReport addEvents(const EventSpec* specs, size_t count);
+    template <size_t N>
+    BatchReport addEvents(const EventSpec (&specs)[N]) { return addEvents(specs, N); }
+    // Millisecond events, for phase timing within a second. They are kept apart from the
+    // schedule, fire in time order (equal times in the order added) and are delivered even
+    // when overdue, so a chain of phase changes always completes.
+    bool addPreciseEvent(PreciseTimeCode atMs, uint8_t scenario, uint8_t cycle, const char* description = "");
+    bool addEventAfter(uint32_t delayMs, uint8_t scenario, uint8_t cycle, const char* description = "");
+    size_t cancelPreciseEvents(uint8_t scenario);
+    int addRule(const RecurrenceRule& rule, uint8_t scenario, uint8_t cycle, const char* description = "");
+    bool removeRule(uint8_t ruleId);
+    bool loadImage(const ScheduleImage& image);
+    void unloadImage();
+    const RecurrenceRule* getRule(uint8_t ruleId) const;
+    bool removeEvent(TimeCode timeCode);
+    bool findEvent(TimeCode timeCode, Event& event) const;
+    ScenarioRange scenarioEvents(uint8_t scenario) const;
+    size_t removeScenario(uint8_t scenario);
+    size_t rescheduleScenario(uint8_t scenario, int32_t offsetSeconds);
     void clearEvents();
     void update();
+    void setDeadlineTimer(DeadlineTimer* timer);
+    void setEditHandler(EditHandler handler, void* context);
+    // Picks up after a restart: scenario and cycle become current again and overlay events
+    // at or before deliveredUntil, which were delivered before the restart, are dropped.
+    void resume(uint8_t scenario, uint8_t cycle, TimeCode deliveredUntil);
+    void waitForNextEvent(uint32_t maxWaitMs);
+    void setDrainPolicy(DrainPolicy policy, uint32_t limit = 1);
+    void setCatchUpPolicy(uint8_t scenario, CatchUpPolicy policy);
+    CatchUpPolicy getCatchUpPolicy(uint8_t scenario) const;
+    void setCatchUpWindow(uint32_t seconds);
+    uint32_t getDroppedMissedEvents() const;
+    uint32_t getLabelFailures() const;  // Image events delivered without their description
+#if defined(ESP32)
+    bool startDispatchTask(BaseType_t core, uint32_t stackSize = 4096, UBaseType_t priority = 1);
+#endif
     uint8_t getCurrentScenario() const;
     uint8_t getCurrentCycle() const;
-    void setEventCallback(EventCallback callback);
-    void printEvents() const;
+    EventDispatcher& getDispatcher();
+    const ScheduleImage* getImage() const { return image; }
+    uint8_t getImageRemovalCount() const { return imageMaskCount; }
+    TimeCode getImageRemoval(uint8_t index) const { return imageMasks[index]; }
+    EventRange eventsBetween(TimeCode from, TimeCode until = NoTimeCode) const;  // [from, until)
+    EventRange nextN(size_t n) const;
+    EventRange nextForScenario(uint8_t scenario, size_t n = 1) const;
 
 private:
-    std::set<Event> events;
-    std::queue<Event> pendingEvents;
-    RTC_DS3231& rtc;
-    uint8_t currentScenario;
-    uint8_t currentCycle;
-    EventCallback eventCallback;
+    static_assert(EVENT_RULE_CAPACITY < ScheduledEvent::NoRule, "Rule ids must fit below NoRule");
+
+    struct RuleSlot {
+        RecurrenceRule recurrence;  // weekdayMask == 0 marks a free slot
+        uint8_t scenario;
+        uint8_t cycle;
+        LabelId label;
+        TimeCode retryFrom;  // Next occurrence could not be stored: place it from here; 0 otherwise
+    };
+
+    Schedule events;  // RAM overlay: runtime additions and recurring occurrences
+    const ScheduleImage* image;
+    uint32_t imageCursor;  // Next image event not yet collected
+    TimeCode imageMasks[EVENT_IMAGE_MASK_CAPACITY];  // Image events removed at runtime
+    uint8_t imageMaskCount;
+    Event preciseEvents[EVENT_PRECISE_CAPACITY];  // Sorted by preciseTime()
+    uint8_t preciseCount;
+    RuleSlot rules[EVENT_RULE_CAPACITY];
+    uint8_t deferredRules;  // Rules whose next occurrence is waiting for room in the schedule
+    SpscRing<Event, EVENT_PENDING_CAPACITY> pendingEvents;  // update() produces, dispatch consumes
+    TimeService& clock;
+    volatile uint8_t currentScenario;
+    volatile uint8_t currentCycle;
+    EventDispatcher dispatcher;
     volatile bool isProcessingEvents;
-    unsigned long lastProcessTime;
+    TimeCode lastProcessTime;
+    DeadlineTimer* deadlineTimer;
+    bool deadlineDirty;  // Schedule changed since the timer was last armed
+    EditHandler editHandler;
+    void* editContext;
+    DrainPolicy drainPolicy;
+    uint32_t drainLimit;
+    volatile bool discardPending;  // Set by clearEvents() for the consumer to act on
+    uint8_t catchUpPolicies[64];   // 2 bits per scenario, CatchUpPolicy::Latest when zero
+    uint16_t fireAllScenarios;
+    uint32_t catchUpWindow;
+    TimeCode catchUpCutoff;     // Cutoff of the catch-up being drained, or NoTimeCode
+    TimeCode catchUpEffective;  // The missed event that stands for the rest, found once per catch-up
+    bool backlog;               // The last pass stopped with due events left for lack of room
+    uint32_t droppedMissed;
+    uint32_t labelFailures;
+#if defined(ESP32)
+    TaskHandle_t dispatchTask;
+    static void dispatchTaskMain(void* arg);
+#endif
 
-    std::set<Event>::const_iterator findNextEvent(uint64_t currentTimeCode) const;
-    void processNextPendingEvent();
+    void collectDueEvents(PreciseTimeCode nowMs);
+    TimeCode latestMissed(TimeCode cutoff) const;
+    void dropMissedBefore(TimeCode timeCode, TimeCode now);
+    void scheduleChanged();
+    void skipImageTo(uint32_t index);
+    const ImageEvent* nextImageEvent();
+    void pushImageEvent(uint32_t index);
+    bool imageHas(TimeCode timeCode) const;
+    bool isImageMasked(TimeCode timeCode) const;
+    bool insertEvent(const Event& event);
+    void armDeadline();
+    bool hasInlinePending() const;
+    void dispatchPendingEvents();
+    bool isPreciseDue(PreciseTimeCode nowMs) const;
     bool isValidDate(uint16_t year, uint8_t month, uint8_t day) const;
-    void rescheduleEvent(const Event& event);
-    void addDailyEvent(uint8_t hour, uint8_t minute, uint8_t second, 
-                       uint8_t scenario, uint8_t cycle, const String& description);
+    bool scheduleOccurrence(Event occurrence, TimeCode notBefore);
+    void placeDeferredRules(TimeCode now);
+    void releaseRule(const Event& occurrence);
+    void freeRule(uint8_t ruleId);
+    void notify(EditKind kind, TimeCode timeCode, uint8_t scenario = 0, uint8_t cycle = 0, uint8_t ruleId = 0,
+                int32_t offsetSeconds = 0, const RecurrenceRule* rule = nullptr, const char* description = "");
 };
 
-#endif // EVENT_MANAGER_H
\ No newline at end of file
+#endif // EVENT_MANAGER_H
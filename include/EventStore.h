@@ -0,0 +1,511 @@
+// EventStore.h
+#ifndef EVENT_STORE_H
+#define EVENT_STORE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "CivilTime.h"
+#include "LabelTable.h"
+
+// Seconds since 1970-01-01 in the RTC's local time. All schedule arithmetic is done on
+// this integer; calendar fields are only decoded for display.
+using TimeCode = uint32_t;
+
+// Milliseconds since 1970-01-01, for events that need sub-second placement.
+using PreciseTimeCode = uint64_t;
+
+// Plain-old-data event record. Trivially copyable so the store can move it with memmove.
+struct ScheduledEvent {
+    static constexpr uint8_t NoRule = 0xFF;
+
+    TimeCode timeCode;
+    LabelId label;  // Description, interned in LabelTable::shared()
+    uint8_t scenario;
+    uint8_t cycle;
+    uint8_t rule;  // Recurrence rule that produced this occurrence, or NoRule for one-shot events
+    uint16_t millisecond = 0;  // Offset into timeCode's second; fills what was padding
+
+    ScheduledEvent() = default;
+
+    ScheduledEvent(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second,
+                   uint8_t sc, uint8_t cy, LabelId labelId = LabelTable::Empty, uint8_t ruleId = NoRule)
+        : timeCode(encodeTime(year, month, day, hour, minute, second)),
+          label(labelId), scenario(sc), cycle(cy), rule(ruleId) {}
+
+    PreciseTimeCode preciseTime() const {
+        return static_cast<PreciseTimeCode>(timeCode) * 1000 + millisecond;
+    }
+
+    bool isRecurring() const {
+        return rule != NoRule;
+    }
+
+    bool operator<(const ScheduledEvent& other) const {
+        return timeCode < other.timeCode;
+    }
+
+    const char* description() const {
+        return LabelTable::shared().text(label);
+    }
+
+    // Returns false, leaving the description empty, when the label table is full.
+    bool setDescription(const char* desc) {
+        LabelId id = LabelTable::shared().intern(desc);
+        label = id == LabelTable::NoLabel ? LabelTable::Empty : id;
+        return id != LabelTable::NoLabel;
+    }
+
+    static constexpr TimeCode encodeTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second) {
+        return CivilTime::toEpoch(year, month, day, hour, minute, second);
+    }
+
+    static void decodeTime(TimeCode timeCode, uint16_t& year, uint8_t& month, uint8_t& day,
+                           uint8_t& hour, uint8_t& minute, uint8_t& second) {
+        CivilTime t = CivilTime::fromEpoch(timeCode);
+        year = t.year;
+        month = t.month;
+        day = t.day;
+        hour = t.hour;
+        minute = t.minute;
+        second = t.second;
+    }
+};
+
+static_assert(std::is_trivially_copyable<ScheduledEvent>::value, "ScheduledEvent must stay POD");
+static_assert(sizeof(ScheduledEvent) == 12, "ScheduledEvent should stay a 12-byte record");
+
+// Fixed-capacity multi-index schedule.
+//  - Records live in a pool of stable 16-bit slots and never move once inserted.
+//  - A sorted window of {timeCode, slot} entries gives chronological order and O(1)
+//    peek of the earliest event. Inserts shift whichever side of the window is
+//    shorter, so chronological appends are O(1). Removed events leave a tombstone
+//    entry that is trimmed when it reaches the front or compacted when the window fills.
+//  - An open-addressing hash maps timeCode -> slot for O(1) lookup.
+//  - Each scenario keeps an intrusive list of its slots, so per-scenario operations
+//    cost O(k) in the number of matching events rather than O(n).
+// Duplicate timeCodes are rejected, as with std::set.
+template <size_t Capacity>
+class EventStore {
+    static_assert(Capacity > 0 && Capacity < 0xFFFF, "EventStore slot ids are 16-bit");
+
+    enum : uint16_t { NoSlot = 0xFFFF };
+
+    struct OrderEntry {
+        TimeCode timeCode;
+        uint16_t slot;  // NoSlot marks a tombstone
+    };
+
+    struct SlotLinks {
+        uint16_t next;  // Next slot in the scenario list, or in the free list
+        uint16_t prev;
+    };
+
+    static constexpr size_t nextPowerOfTwo(size_t n, size_t p = 1) {
+        return p >= n ? p : nextPowerOfTwo(n, p << 1);
+    }
+
+    static constexpr size_t HashSize = nextPowerOfTwo(Capacity * 2);
+
+public:
+    // Chronological iterator over live events.
+    class const_iterator {
+    public:
+        const_iterator(const EventStore* store, size_t index) : store(store), index(index) {
+            skipTombstones();
+        }
+        const ScheduledEvent& operator*() const { return store->slots[store->order[index].slot]; }
+        const ScheduledEvent* operator->() const { return &**this; }
+        const_iterator& operator++() {
+            ++index;
+            skipTombstones();
+            return *this;
+        }
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+
+    private:
+        const EventStore* store;
+        size_t index;
+
+        void skipTombstones() {
+            size_t tail = store->head + store->count;
+            while (index < tail && store->order[index].slot == NoSlot) ++index;
+        }
+    };
+
+    // Events of one scenario, in no particular order.
+    class ScenarioRange {
+    public:
+        class const_iterator {
+        public:
+            const_iterator(const EventStore* store, uint16_t slot) : store(store), slot(slot) {}
+            const ScheduledEvent& operator*() const { return store->slots[slot]; }
+            const ScheduledEvent* operator->() const { return &store->slots[slot]; }
+            const_iterator& operator++() {
+                slot = store->links[slot].next;
+                return *this;
+            }
+            bool operator==(const const_iterator& other) const { return slot == other.slot; }
+            bool operator!=(const const_iterator& other) const { return slot != other.slot; }
+
+        private:
+            const EventStore* store;
+            uint16_t slot;
+        };
+
+        ScenarioRange(const EventStore* store, uint16_t first) : store(store), first(first) {}
+        const_iterator begin() const { return const_iterator(store, first); }
+        const_iterator end() const { return const_iterator(store, NoSlot); }
+        bool empty() const { return first == NoSlot; }
+
+    private:
+        const EventStore* store;
+        uint16_t first;
+    };
+
+    EventStore() {
+        clear();
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+    size_t size() const { return liveCount; }
+    bool empty() const { return liveCount == 0; }
+    bool full() const { return liveCount == Capacity; }
+
+    const_iterator begin() const { return const_iterator(this, head); }
+    const_iterator end() const { return const_iterator(this, head + count); }
+
+    // Earliest scheduled event, or nullptr when empty. The window front is never a tombstone.
+    const ScheduledEvent* peek() const {
+        return count ? &slots[order[head].slot] : nullptr;
+    }
+
+    void popFront() {
+        if (count == 0) return;
+        uint16_t slot = order[head].slot;
+        order[head].slot = NoSlot;
+        ++tombstones;
+        hashRemove(slots[slot].timeCode);
+        release(slot);
+        trimFront();
+    }
+
+    // First live event at or after timeCode.
+    const_iterator lowerBound(TimeCode timeCode) const {
+        return const_iterator(this, orderLowerBound(timeCode));
+    }
+
+    // Latest live event before timeCode that accept() takes, searching back from timeCode.
+    template <typename Accept>
+    const ScheduledEvent* lastBefore(TimeCode timeCode, Accept accept) const {
+        for (size_t i = orderLowerBound(timeCode); i > head;) {
+            uint16_t slot = order[--i].slot;
+            if (slot != NoSlot && accept(static_cast<const ScheduledEvent&>(slots[slot]))) return &slots[slot];
+        }
+        return nullptr;
+    }
+
+    // Removes every event before timeCode in one cut of the window front, handing each to
+    // removed() first. removed() must not modify the store. Returns the number removed.
+    template <typename Removed>
+    size_t popBefore(TimeCode timeCode, Removed removed) {
+        size_t end = orderLowerBound(timeCode);
+        size_t popped = 0;
+        for (size_t i = head; i < end; i++) {
+            uint16_t slot = order[i].slot;
+            if (slot == NoSlot) {
+                --tombstones;
+                continue;
+            }
+            removed(static_cast<const ScheduledEvent&>(slots[slot]));
+            hashRemove(slots[slot].timeCode);
+            release(slot);
+            ++popped;
+        }
+        count -= end - head;
+        head = end;
+        trimFront();
+        return popped;
+    }
+
+    const ScheduledEvent* find(TimeCode timeCode) const {
+        uint16_t slot = hashFind(timeCode);
+        return slot == NoSlot ? nullptr : &slots[slot];
+    }
+
+    bool insert(const ScheduledEvent& event) {
+        if (full() || hashFind(event.timeCode) != NoSlot) return false;
+
+        uint16_t slot = freeHead;
+        freeHead = links[slot].next;
+        slots[slot] = event;
+        ++liveCount;
+
+        hashInsert(slot);
+        linkScenario(slot);
+        orderInsert(event.timeCode, slot);
+        return true;
+    }
+
+    enum class BatchReject : uint8_t { Taken, Full };
+
+    // Inserts a batch of records in one pass. Records go straight into free slots and
+    // onto the end of the order window, which is sorted once at the end:
+    // O((n + m) log(n + m)) instead of a window shift per insert. next(i) yields the
+    // i-th record, or nullptr to skip it; records that cannot be stored are passed to
+    // reject(i, reason) and each stored one to accept(i, stored), before the final sort.
+    // Returns the number of records inserted.
+    template <typename Next, typename Reject, typename Accept>
+    size_t insertBatch(size_t n, Next next, Reject reject, Accept accept) {
+        compact();
+        size_t added = 0;
+        for (size_t i = 0; i < n; i++) {
+            const ScheduledEvent* event = next(i);
+            if (event == nullptr) continue;
+            if (hashFind(event->timeCode) != NoSlot) {
+                reject(i, BatchReject::Taken);
+                continue;
+            }
+            if (full()) {
+                reject(i, BatchReject::Full);
+                continue;
+            }
+
+            uint16_t slot = freeHead;
+            freeHead = links[slot].next;
+            slots[slot] = *event;
+            ++liveCount;
+            hashInsert(slot);
+            linkScenario(slot);
+            order[count].timeCode = event->timeCode;
+            order[count].slot = slot;
+            ++count;
+            ++added;
+            accept(i, slots[slot]);
+        }
+
+        auto earlier = [](const OrderEntry& a, const OrderEntry& b) { return a.timeCode < b.timeCode; };
+        if (!std::is_sorted(order, order + count, earlier)) std::sort(order, order + count, earlier);
+        return added;
+    }
+
+    bool erase(TimeCode timeCode) {
+        uint16_t slot = hashFind(timeCode);
+        if (slot == NoSlot) return false;
+        remove(slot);
+        return true;
+    }
+
+    ScenarioRange scenarioEvents(uint8_t scenario) const {
+        return ScenarioRange(this, scenarioHeads[scenario]);
+    }
+
+    size_t removeScenario(uint8_t scenario) {
+        size_t removed = 0;
+        uint16_t slot = scenarioHeads[scenario];
+        while (slot != NoSlot) {
+            uint16_t next = links[slot].next;
+            remove(slot);
+            slot = next;
+            ++removed;
+        }
+        return removed;
+    }
+
+    // Moves every event of a scenario to newTimeCode(event). An event whose new time
+    // collides with another live event is passed to onDropped and removed.
+    // Returns the number of events kept.
+    template <typename TimeFn, typename DropFn>
+    size_t rescheduleScenario(uint8_t scenario, TimeFn newTimeCode, DropFn onDropped) {
+        for (uint16_t slot = scenarioHeads[scenario]; slot != NoSlot; slot = links[slot].next) {
+            hashRemove(slots[slot].timeCode);
+            orderMarkDead(slots[slot].timeCode, slot);
+        }
+
+        size_t kept = 0;
+        uint16_t slot = scenarioHeads[scenario];
+        while (slot != NoSlot) {
+            uint16_t next = links[slot].next;
+            TimeCode timeCode = newTimeCode(static_cast<const ScheduledEvent&>(slots[slot]));
+            if (hashFind(timeCode) != NoSlot) {
+                onDropped(static_cast<const ScheduledEvent&>(slots[slot]));
+                release(slot);
+            } else {
+                slots[slot].timeCode = timeCode;
+                hashInsert(slot);
+                orderInsert(timeCode, slot);
+                ++kept;
+            }
+            slot = next;
+        }
+        trimFront();
+        return kept;
+    }
+
+    template <typename TimeFn>
+    size_t rescheduleScenario(uint8_t scenario, TimeFn newTimeCode) {
+        return rescheduleScenario(scenario, newTimeCode, [](const ScheduledEvent&) {});
+    }
+
+    void clear() {
+        head = 0;
+        count = 0;
+        tombstones = 0;
+        liveCount = 0;
+        for (size_t i = 0; i < Capacity; i++) {
+            links[i].next = (i + 1 < Capacity) ? static_cast<uint16_t>(i + 1) : static_cast<uint16_t>(NoSlot);
+        }
+        freeHead = 0;
+        for (size_t i = 0; i < HashSize; i++) buckets[i] = NoSlot;
+        for (size_t i = 0; i < 256; i++) scenarioHeads[i] = NoSlot;
+    }
+
+private:
+    ScheduledEvent slots[Capacity];
+    SlotLinks links[Capacity];
+    OrderEntry order[Capacity];
+    uint16_t buckets[HashSize];
+    uint16_t scenarioHeads[256];
+    uint16_t freeHead;
+    size_t head;        // Order window start
+    size_t count;       // Order window length, tombstones included
+    size_t tombstones;
+    size_t liveCount;
+
+    // Drops a live slot from every index.
+    void remove(uint16_t slot) {
+        hashRemove(slots[slot].timeCode);
+        orderMarkDead(slots[slot].timeCode, slot);
+        release(slot);
+        trimFront();
+    }
+
+    // Returns a slot that is no longer hashed or ordered to the free list.
+    void release(uint16_t slot) {
+        unlinkScenario(slot);
+        links[slot].next = freeHead;
+        freeHead = slot;
+        --liveCount;
+    }
+
+    static size_t hashOf(TimeCode timeCode) {
+        return static_cast<size_t>((timeCode * 0x9E3779B97F4A7C15ULL) >> 32) & (HashSize - 1);
+    }
+
+    uint16_t hashFind(TimeCode timeCode) const {
+        for (size_t i = hashOf(timeCode); buckets[i] != NoSlot; i = (i + 1) & (HashSize - 1)) {
+            if (slots[buckets[i]].timeCode == timeCode) return buckets[i];
+        }
+        return NoSlot;
+    }
+
+    void hashInsert(uint16_t slot) {
+        size_t i = hashOf(slots[slot].timeCode);
+        while (buckets[i] != NoSlot) i = (i + 1) & (HashSize - 1);
+        buckets[i] = slot;
+    }
+
+    // Linear-probing delete with backward shift, so the table never holds tombstones.
+    void hashRemove(TimeCode timeCode) {
+        size_t i = hashOf(timeCode);
+        while (buckets[i] != NoSlot && slots[buckets[i]].timeCode != timeCode) i = (i + 1) & (HashSize - 1);
+        if (buckets[i] == NoSlot) return;
+
+        size_t j = i;
+        while (true) {
+            j = (j + 1) & (HashSize - 1);
+            if (buckets[j] == NoSlot) break;
+            size_t home = hashOf(slots[buckets[j]].timeCode);
+            bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+            if (!stays) {
+                buckets[i] = buckets[j];
+                i = j;
+            }
+        }
+        buckets[i] = NoSlot;
+    }
+
+    void linkScenario(uint16_t slot) {
+        uint16_t& first = scenarioHeads[slots[slot].scenario];
+        links[slot].prev = NoSlot;
+        links[slot].next = first;
+        if (first != NoSlot) links[first].prev = slot;
+        first = slot;
+    }
+
+    void unlinkScenario(uint16_t slot) {
+        SlotLinks& link = links[slot];
+        if (link.prev != NoSlot) {
+            links[link.prev].next = link.next;
+        } else {
+            scenarioHeads[slots[slot].scenario] = link.next;
+        }
+        if (link.next != NoSlot) links[link.next].prev = link.prev;
+    }
+
+    size_t orderLowerBound(TimeCode timeCode) const {
+        size_t first = head;
+        size_t len = count;
+        while (len > 0) {
+            size_t half = len / 2;
+            if (order[first + half].timeCode < timeCode) {
+                first += half + 1;
+                len -= half + 1;
+            } else {
+                len = half;
+            }
+        }
+        return first;
+    }
+
+    void orderInsert(TimeCode timeCode, uint16_t slot) {
+        if (count == Capacity) compact();
+
+        size_t index = orderLowerBound(timeCode);
+        size_t tail = head + count;
+        size_t rightShift = tail - index;
+        size_t leftShift = index - head;
+
+        if (tail < Capacity && (head == 0 || rightShift <= leftShift)) {
+            memmove(&order[index + 1], &order[index], rightShift * sizeof(OrderEntry));
+        } else {
+            memmove(&order[head - 1], &order[head], leftShift * sizeof(OrderEntry));
+            --head;
+            --index;
+        }
+        order[index].timeCode = timeCode;
+        order[index].slot = slot;
+        ++count;
+    }
+
+    void orderMarkDead(TimeCode timeCode, uint16_t slot) {
+        size_t index = orderLowerBound(timeCode);
+        while (order[index].slot != slot) ++index;  // Only equal-key tombstones can precede it
+        order[index].slot = NoSlot;
+        ++tombstones;
+    }
+
+    void trimFront() {
+        while (count > 0 && order[head].slot == NoSlot) {
+            ++head;
+            --count;
+            --tombstones;
+        }
+        if (count == 0) head = 0;
+    }
+
+    void compact() {
+        size_t out = 0;
+        for (size_t i = head; i < head + count; i++) {
+            if (order[i].slot != NoSlot) order[out++] = order[i];
+        }
+        head = 0;
+        count = out;
+        tombstones = 0;
+    }
+};
+
+#endif // EVENT_STORE_H
@@ -0,0 +1,54 @@
+// FixedMath.h
+#ifndef FIXED_MATH_H
+#define FIXED_MATH_H
+
+#include <cstdint>
+
+// Integer math for the per-pixel effects, where float sin/cos/sqrt (double precision in
+// the C library) dominate the frame time. Values are Q16.16 (Fixed16) or Q8.8 (Fixed8);
+// angles are binary, a full turn being 65536, so they wrap for free.
+typedef int32_t Fixed16;
+typedef int16_t Fixed8;
+typedef uint16_t Angle;
+
+static constexpr Fixed16 FixedOne = 1L << 16;
+static constexpr int32_t AnglePerRadian = 10430;  // 65536 / 2pi
+static constexpr Angle QuarterTurn = 16384;
+
+constexpr Fixed16 toFixed16(float value) {
+    return static_cast<Fixed16>(value * 65536.0f + (value < 0 ? -0.5f : 0.5f));
+}
+
+constexpr Fixed8 toFixed8(float value) {
+    return static_cast<Fixed8>(value * 256.0f + (value < 0 ? -0.5f : 0.5f));
+}
+
+constexpr Angle angleFromRadians(float radians) {
+    return static_cast<Angle>(static_cast<int32_t>(radians * 10430.378f + (radians < 0 ? -0.5f : 0.5f)));
+}
+
+inline Fixed16 fixedMul(Fixed16 a, Fixed16 b) {
+    return static_cast<Fixed16>((static_cast<int64_t>(a) * b) >> 16);
+}
+
+inline Fixed16 fixedDiv(Fixed16 a, Fixed16 b) {
+    return static_cast<Fixed16>((static_cast<int64_t>(a) << 16) / b);
+}
+
+// Rounds towards zero, as a cast from float does
+inline int32_t fixedToInt(Fixed16 value) {
+    return value >= 0 ? value >> 16 : -(-value >> 16);
+}
+
+// Quarter-wave table with linear interpolation; error below 1e-4
+Fixed16 sin16(Angle angle);
+inline Fixed16 cos16(Angle angle) { return sin16(static_cast<Angle>(angle + QuarterTurn)); }
+
+uint16_t isqrt(uint32_t value);
+
+// Distance in Q8.8 for offsets of less than 256 pixels
+inline uint16_t distance8(int32_t dx, int32_t dy) {
+    return isqrt(static_cast<uint32_t>(dx * dx + dy * dy) << 16);
+}
+
+#endif // FIXED_MATH_H
@@ -0,0 +1,61 @@
+// FrameDiff.h
+#ifndef FRAME_DIFF_H
+#define FRAME_DIFF_H
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef FRAME_DIFF_MAX_BYTES
+#define FRAME_DIFF_MAX_BYTES (128 * 64 / 8)  // Largest panel supported: 128x64
+#endif
+
+#ifndef FRAME_DIFF_WINDOW_CAPACITY
+#define FRAME_DIFF_WINDOW_CAPACITY 32
+#endif
+
+// Columns [firstColumn, lastColumn] of pages [firstPage, lastPage] in the SSD1306
+// page-major layout (one byte = 8 vertical pixels). Only a whole-panel window spans
+// more than one page, so window data is always contiguous in the framebuffer.
+struct FlushWindow {
+    uint8_t firstPage;
+    uint8_t lastPage;
+    uint8_t firstColumn;
+    uint8_t lastColumn;
+
+    uint16_t dataBytes() const {
+        return static_cast<uint16_t>((lastPage - firstPage + 1) * (lastColumn - firstColumn + 1));
+    }
+};
+
+// Works out what a flush has to send: the framebuffer is compared with a shadow copy
+// of what the panel holds, page by page, and each page's changed bytes become column
+// windows. Runs separated by fewer unchanged bytes than a window costs to set up are
+// merged. When the windows would cost as much I2C traffic as the whole frame, a single
+// full window is returned instead, so a flush never sends more than display() did.
+// Costs count every byte on the wire, including address and control bytes.
+class FrameDiff {
+public:
+    static constexpr uint16_t CommandBytes = 8;   // Address, control, COLUMNADDR a b, PAGEADDR a b
+    static constexpr uint16_t ChunkBytes = 127;   // Data bytes per transaction, after the control byte
+    static constexpr uint16_t ChunkOverhead = 2;  // Address and control byte of each data transaction
+
+    FrameDiff(uint8_t width, uint8_t height);
+
+    // Fills windows and returns how many there are (0 when nothing changed). The shadow
+    // then matches the frame, so the windows must be sent.
+    uint8_t diff(const uint8_t* frame, FlushWindow (&windows)[FRAME_DIFF_WINDOW_CAPACITY]);
+    void invalidate() { shadowValid = false; }  // Panel content unknown: the next diff sends everything
+
+    static uint16_t cost(const FlushWindow& window);
+    uint16_t fullFrameCost() const { return cost(FlushWindow{0, static_cast<uint8_t>(pages - 1), 0,
+                                                             static_cast<uint8_t>(width - 1)}); }
+    uint8_t getWidth() const { return width; }
+
+private:
+    uint8_t width;
+    uint8_t pages;
+    bool shadowValid;
+    uint8_t shadow[FRAME_DIFF_MAX_BYTES];
+};
+
+#endif // FRAME_DIFF_H
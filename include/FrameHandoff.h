@@ -0,0 +1,46 @@
+// FrameHandoff.h
+#ifndef FRAME_HANDOFF_H
+#define FRAME_HANDOFF_H
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free latest-frame mailbox between one writer and one reader (a double buffer plus
+// a spare, so neither side ever waits). The writer fills back() and publish()es it; the
+// reader acquire()s the most recent published frame and reads front() until its next
+// acquire(). Frames published faster than the reader consumes them are superseded, never queued.
+// back() holds whatever was written two frames ago, so writers should overwrite it fully.
+template <typename T>
+class FrameHandoff {
+public:
+    FrameHandoff() : shared(1), writeIndex(0), readIndex(2) {}
+
+    // Writer side
+    T& back() { return buffers[writeIndex]; }
+
+    void publish() {
+        uint8_t previous = shared.exchange(static_cast<uint8_t>(writeIndex | Fresh), std::memory_order_acq_rel);
+        writeIndex = previous & IndexMask;
+    }
+
+    // Reader side: returns false when nothing new was published since the last acquire
+    bool acquire() {
+        if ((shared.load(std::memory_order_relaxed) & Fresh) == 0) return false;
+        uint8_t previous = shared.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & IndexMask;
+        return true;
+    }
+
+    const T& front() const { return buffers[readIndex]; }
+
+private:
+    static const uint8_t IndexMask = 0x03;
+    static const uint8_t Fresh = 0x04;
+
+    T buffers[3];
+    std::atomic<uint8_t> shared;  // Index of the buffer between writer and reader, plus Fresh
+    uint8_t writeIndex;
+    uint8_t readIndex;
+};
+
+#endif // FRAME_HANDOFF_H
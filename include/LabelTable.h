@@ -0,0 +1,61 @@
+// LabelTable.h
+#ifndef LABEL_TABLE_H
+#define LABEL_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef LABEL_TABLE_CAPACITY
+#define LABEL_TABLE_CAPACITY 128
+#endif
+
+#ifndef LABEL_TABLE_POOL_BYTES
+#define LABEL_TABLE_POOL_BYTES 2048
+#endif
+
+using LabelId = uint16_t;
+
+// Deduplicated, append-only table of event descriptions. Events carry a 16-bit id and
+// resolve it to a const char* on demand, so a label shared by many events is stored once.
+// Text that already sits in read-only flash (string literals, a mapped schedule image)
+// is referenced in place; anything else is copied once into a fixed pool. Labels are
+// never removed. intern() and detach() must be called from one task; text() is safe
+// from any task for an id it has been handed.
+class LabelTable {
+public:
+    static constexpr LabelId Empty = 0;
+    static constexpr LabelId NoLabel = 0xFFFF;
+
+    static LabelTable& shared();
+
+    LabelTable();
+    LabelId intern(const char* text);  // NoLabel when the table or the pool is full
+    // Copies labels referenced in place inside [begin, begin + size) into the pool before
+    // that memory goes away, as when a schedule image is unmapped. Labels the pool has no
+    // room for become empty. Returns how many were emptied.
+    size_t detach(const void* begin, size_t size);
+    const char* text(LabelId id) const {
+        return id < count.load(std::memory_order_acquire) ? entries[id] : "";
+    }
+
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+    size_t poolUsed() const { return poolEnd; }
+
+private:
+    static_assert((LABEL_TABLE_CAPACITY & (LABEL_TABLE_CAPACITY - 1)) == 0 && LABEL_TABLE_CAPACITY < 0x8000,
+                  "LABEL_TABLE_CAPACITY must be a power of two below 32768");
+
+    static constexpr size_t HashSize = LABEL_TABLE_CAPACITY * 2;
+
+    const char* entries[LABEL_TABLE_CAPACITY];
+    uint16_t buckets[HashSize];
+    char pool[LABEL_TABLE_POOL_BYTES];
+    size_t poolEnd;
+    std::atomic<uint16_t> count;
+
+    static uint32_t hashOf(const char* text);
+    static bool isReadOnly(const char* text);
+};
+
+#endif // LABEL_TABLE_H
@@ -0,0 +1,132 @@
+// LampDriver.h
+#ifndef LAMP_DRIVER_H
+#define LAMP_DRIVER_H
+
+#include <cstdint>
+#include "PhaseSequencer.h"
+#if defined(ESP32)
+#include <esp_timer.h>
+#endif
+
+#ifndef LAMP_STATE_CAPACITY
+#define LAMP_STATE_CAPACITY 16
+#endif
+
+#ifndef LAMP_CONFLICT_CAPACITY
+#define LAMP_CONFLICT_CAPACITY 8
+#endif
+
+// Bank of output pins written as one word: bit n is pin n of the port.
+class OutputPort {
+public:
+    virtual ~OutputPort() {}
+    virtual void write(uint32_t setMask, uint32_t clearMask) = 0;  // Clear first, then set
+    virtual uint32_t read() const = 0;                               // Levels actually on the pins
+};
+
+// Host stand-in that remembers every write and can simulate failed outputs.
+class MockPort : public OutputPort {
+public:
+    MockPort() : levels(0), stuckHigh(0), stuckLow(0), writes(0) {}
+
+    void write(uint32_t setMask, uint32_t clearMask) override {
+        levels = (levels & ~clearMask) | setMask;
+        ++writes;
+    }
+    uint32_t read() const override { return (levels | stuckHigh) & ~stuckLow; }
+
+    void setStuck(uint32_t high, uint32_t low) {
+        stuckHigh = high;
+        stuckLow = low;
+    }
+    uint32_t getLevels() const { return levels; }
+    uint32_t getWrites() const { return writes; }
+
+private:
+    uint32_t levels;
+    uint32_t stuckHigh;
+    uint32_t stuckLow;
+    uint32_t writes;
+};
+
+#if defined(ESP32)
+// GPIO 0-31 through the W1TC/W1TS registers: one store clears every lamp going dark and
+// one store lights every lamp coming on, so the only intermediate state, for a few
+// nanoseconds, is fewer lamps lit. Pins are configured as input and output so read()
+// returns the real pin levels.
+class Esp32GpioPort : public OutputPort {
+public:
+    bool begin(uint32_t pinMask);
+    void write(uint32_t setMask, uint32_t clearMask) override;
+    uint32_t read() const override;
+};
+#endif
+
+// Drives the lamps from precomputed masks: each signal state (Phase::state) maps to the
+// pins to light, and switching state is a single port write whatever the number of
+// lamps. Conflicting green groups are declared up front; patterns that would light both
+// sides of a conflict are refused, and check() compares the pins read back against the
+// commanded pattern. A conflict on the pins latches the fail-safe pattern until
+// clearFault(). On the ESP32, startMonitor() runs check() periodically, so a conflict
+// is caught within one period.
+// apply() and check() must run on one context; PhaseTimer and the monitor both use the
+// esp_timer task.
+class LampDriver {
+public:
+    struct Stats {
+        uint32_t switches;
+        uint32_t checks;
+        uint32_t mismatches;  // Pins read back differently from the commanded pattern
+        uint32_t conflicts;
+    };
+
+    LampDriver(OutputPort& port, uint32_t lampMask);
+
+    bool setStatePattern(uint8_t state, uint32_t lit);
+    bool addConflict(uint32_t greensA, uint32_t greensB);
+    bool setFailSafePattern(uint32_t lit);
+
+    bool apply(uint8_t state);
+    static void onPhase(const PhaseSequencer::PhaseChange& change, void* driver);
+
+    bool check();  // False on a conflict or mismatch
+    bool isFaulted() const { return faulted; }
+    void clearFault();
+    uint32_t getCommanded() const { return commanded; }
+    const Stats& getStats() const { return stats; }
+
+#if defined(ESP32)
+    bool startMonitor(uint32_t periodMs);
+#endif
+
+private:
+    struct Masks {
+        uint32_t set;
+        uint32_t clear;
+        bool defined;
+    };
+
+    struct Conflict {
+        uint32_t a;
+        uint32_t b;
+    };
+
+    OutputPort& port;
+    uint32_t lampMask;
+    Masks states[LAMP_STATE_CAPACITY];
+    Conflict conflictPairs[LAMP_CONFLICT_CAPACITY];
+    uint8_t conflictCount;
+    uint32_t failSafe;
+    volatile uint32_t commanded;
+    volatile bool faulted;
+    Stats stats;
+#if defined(ESP32)
+    esp_timer_handle_t monitor;
+    static void onMonitor(void* arg);
+#endif
+
+    bool hasConflict(uint32_t lit) const;
+    void write(uint32_t lit);
+};
+
+#endif // LAMP_DRIVER_H
@@ -0,0 +1,105 @@
+// LatencyMonitor.h
+#ifndef LATENCY_MONITOR_H
+#define LATENCY_MONITOR_H
+
+#include <Arduino.h>
+#include <cstdint>
+#include "EventDispatcher.h"
+#include "TimeService.h"
+
+#ifndef LATENCY_EVENT_DEADLINE_MS
+#define LATENCY_EVENT_DEADLINE_MS 100  // An event delivered later than this counts as missed
+#endif
+
+#ifndef LATENCY_LOOP_BUDGET_US
+#define LATENCY_LOOP_BUDGET_US 20000  // A loop() pass longer than this counts as an overrun
+#endif
+
+// Fixed-size log-linear histogram: exact below 4, then 4 buckets per power of two, so
+// every bucket is within 25% of its values and the whole uint32 range fits in 124 counters.
+class LatencyHistogram {
+public:
+    static constexpr uint8_t SubBuckets = 4;
+    static constexpr uint8_t Buckets = 124;
+
+    LatencyHistogram() { reset(); }
+
+    void record(uint32_t value);
+    void reset();
+
+    uint32_t count() const { return total; }
+    uint32_t max() const { return largest; }
+    uint32_t bucketCount(uint8_t index) const { return counts[index]; }
+    uint32_t percentile(uint8_t percent) const;  // Upper bound of the bucket holding that rank
+
+    static uint8_t bucketOf(uint32_t value);
+    static uint32_t bucketLow(uint8_t index);
+    static uint32_t bucketHigh(uint8_t index);
+
+private:
+    uint32_t counts[Buckets];
+    uint32_t total;
+    uint32_t largest;
+};
+
+// Records how late events reach their subscribers (dispatch time minus scheduled time,
+// in ms) and how long each loop() pass takes (in us), with counters for events past the
+// deadline and passes over budget. Event timing runs on the dispatching task and loop
+// timing on the loop task; each histogram has a single writer, so readers on another
+// task may see a snapshot that is one sample behind.
+class LatencyMonitor {
+public:
+    static constexpr uint32_t BinaryMagic = 0x4D54414C;  // "LATM"
+    static constexpr uint8_t BinaryVersion = 1;
+
+    struct Stats {
+        uint32_t count;
+        uint32_t max;
+        uint32_t p50;
+        uint32_t p99;
+        uint32_t over;       // Samples above threshold
+        uint32_t threshold;
+    };
+
+    explicit LatencyMonitor(TimeService& clock, uint32_t eventDeadlineMs = LATENCY_EVENT_DEADLINE_MS,
+                            uint32_t loopBudgetUs = LATENCY_LOOP_BUDGET_US);
+
+    // Subscribe before the other consumers, so lateness is measured when dispatch starts.
+    bool attach(EventDispatcher& dispatcher);
+    void onEvent(const ScheduledEvent& event);
+
+    void loopStarted();
+    void loopFinished();  // Call before the loop idles, so waiting is not counted
+
+    void setEventDeadline(uint32_t ms) { eventDeadlineMs = ms; }
+    void setLoopBudget(uint32_t us) { loopBudgetUs = us; }
+
+    Stats getEventStats() const;
+    Stats getLoopStats() const;
+    const LatencyHistogram& eventLateness() const { return lateness; }
+    const LatencyHistogram& loopDuration() const { return loopTime; }
+    void reset();
+
+    // Summary and non-empty buckets as CSV text.
+    void printCsv(Print& out) const;
+    // Little-endian: magic, version, bucket count, then for each histogram
+    // count, max, over, threshold, non-empty bucket count and (index u8, count u32) pairs.
+    size_t writeBinary(Print& out) const;
+
+private:
+    TimeService& clock;
+    LatencyHistogram lateness;
+    LatencyHistogram loopTime;
+    uint32_t eventDeadlineMs;
+    uint32_t loopBudgetUs;
+    uint32_t lateEvents;
+    uint32_t overrunLoops;
+    unsigned long loopStart;
+
+    static Stats summarize(const LatencyHistogram& histogram, uint32_t over, uint32_t threshold);
+    static void printCsvBuckets(Print& out, const char* name, const LatencyHistogram& histogram);
+    static size_t writeBinaryHistogram(Print& out, const LatencyHistogram& histogram, uint32_t over,
+                                       uint32_t threshold);
+};
+
+#endif // LATENCY_MONITOR_H
@@ -0,0 +1,63 @@
+// LifeGrid.h
+#ifndef LIFE_GRID_H
+#define LIFE_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include "PackedFrame.h"
+
+#ifndef LIFE_GRID_MAX_WIDTH
+#define LIFE_GRID_MAX_WIDTH 128
+#endif
+
+#ifndef LIFE_GRID_MAX_HEIGHT
+#define LIFE_GRID_MAX_HEIGHT 64
+#endif
+
+// Conway's life on a torus, one bit per cell, rows padded to whole machine words (64-bit
+// on the host, 32-bit on the ESP32). step() counts all neighbours of a word of cells at
+// once with bit-sliced adders and updates the grid in place, keeping only copies of the
+// row above and of the first row: a 128x64 grid is 1 KB plus three rows.
+class LifeGrid {
+public:
+#if UINTPTR_MAX > 0xFFFFFFFFUL
+    typedef uint64_t Word;
+#else
+    typedef uint32_t Word;
+#endif
+    static constexpr uint16_t WordBits = sizeof(Word) * 8;
+    static constexpr uint16_t MaxRowWords = (LIFE_GRID_MAX_WIDTH + WordBits - 1) / WordBits;
+
+    // Sizes beyond the maximum leave an empty 0x0 grid
+    LifeGrid(uint16_t width, uint16_t height);
+
+    void clear();
+    void randomize(uint16_t density, FastRandom& rng);  // Cells alive with probability density / 256
+    bool get(uint16_t x, uint16_t y) const;
+    void set(uint16_t x, uint16_t y, bool alive);
+
+    void step();
+    uint32_t population() const;
+
+    // Row y starts at byte y * getRowBytes(); bit x of a row is bit x % 8 of byte x / 8
+    // (words are stored little-endian on both targets)
+    const uint8_t* getBits() const { return reinterpret_cast<const uint8_t*>(cells); }
+    size_t getRowBytes() const { return rowWords * sizeof(Word); }
+    uint16_t getWidth() const { return width; }
+    uint16_t getHeight() const { return height; }
+
+private:
+    uint16_t width;
+    uint16_t height;
+    uint16_t rowWords;
+    Word lastMask;  // Valid bits of the last word of a row
+    Word cells[MaxRowWords * LIFE_GRID_MAX_HEIGHT];
+    Word above[MaxRowWords];
+    Word current[MaxRowWords];
+    Word first[MaxRowWords];
+
+    Word* row(uint16_t y) { return cells + y * rowWords; }
+    void nextRow(const Word* up, const Word* middle, const Word* down, Word* out) const;
+};
+
+#endif // LIFE_GRID_H
@@ -6,150 +6,114 @@
 #include <Adafruit_GFX.h>
 #include "RTClib.h"
 #include "EventManager.h" // Include this to use Event struct
+#include "FrameDiff.h"
+#include "FrameHandoff.h"
+#include "Effects.h"
 
 class OLEDManager {
 public:
+    // I2C traffic of flush(), against sending the whole frame every time as display() does
+    struct FlushStats {
+        uint32_t flushes;
+        uint32_t bytesSent;
+        uint32_t bytesSaved;
+        uint16_t lastBytesSent;
+        uint16_t lastBytesSaved;
+        uint8_t lastWindows;
+    };
+
+    enum class EffectId {
+        Flicker,
+        TvNoise,
+        FadeOut,
+        ScanLines,
+        Sweep,
+        GeometricShapes,
+        TextEmergence,
+        Matrix,
+        Spiral,
+        Bounce,
+        Wave,
+        Starfield,
+        StarfieldVertical,
+        Mandelbrot,
+        Julia,
+        LSystemTree,
+        Plasma,
+        ParticleSystem,
+        GameOfLife,
+        Vortex,
+        Rain,
+        DynamicWave,
+        CyberGrid,
+        WarpStarfield,
+        ParticleExplosion,
+        MarbleDrop,
+        FallingLetters
+    };
+
     OLEDManager(uint8_t w = 128, uint8_t h = 64, int8_t rst_pin = -1);
     bool begin(uint8_t i2c_address = 0x3C);
     void displayTime(const DateTime& now);
     void displayEvent(const EventManager::Event& event);
     void clear();
-    void showTVTurnOnEffect();
+    void showTVTurnOnEffect();  // Queues the intro; tick() plays it
+
+    // Effects are queued and drawn one frame per tick(), which flushes what it drew and
+    // returns at once. Call it again within msUntilNextFrame() (Idle: nothing queued).
+    bool playEffect(EffectId id);
+    void stopEffects();
+    bool tick(uint32_t nowMs);
+    uint32_t msUntilNextFrame(uint32_t nowMs) const { return effects.msUntilNextFrame(nowMs); }
+    bool isPlayingEffect() const { return effects.isBusy(); }
+    // Latest stats published by flush(), which runs on the render task. Call from one
+    // other task; the returned copy stays unchanged until its next call.
+    const FlushStats& getFlushStats();
 
 private:
     Adafruit_SSD1306 display;
     uint8_t width;
     uint8_t height;
+    uint8_t i2cAddress;
+    FrameDiff frameDiff;
+    FlushStats flushStats;                   // Render-task side
+    FrameHandoff<FlushStats> flushReports;   // Render task -> getFlushStats()
+    void flush();
+    void sendWindow(const FlushWindow& window);
     unsigned long eventDisplayStartTime;
     bool isDisplayingEvent;
-    void drawTVNoise();
-    void fadeOutEffect();
-    void flickerEffect();
-    void scanningLines();
-    void geometricShapes();
-    void textEmergence();
-    void matrixEffect();
-    void spiralEffect();
-    void bounceEffect();
-    void waveEffect();
-    void starfieldEffect();
-    void starfieldEffectV();
-     // New fractal effect methods
-    void mandelbrotEffect();
-    void juliaEffect();
-    void lSystemTreeEffect();
-
-    void plasmaEffect();
-    void particleSystemEffect();
-    void gameOfLifeEffect();
-
-    void vortexParticleEffect();
-    // New rain effect method
-    void rainEffect();
-
-    void dynamicWaveEffect();
-    void cyberGridEffect();
-
-    void starfieldEffect2();
-
-    void particleExplosionEffect();
-
-    void marbleDropEffect();
-
-    // New falling letters effect method
-    void fallingLettersEffect();
-
-    // New neural cell brain effect method
-    void neuralCellBrainEffect();
-
-    // Helper methods for fractal calculations
-    bool mandelbrotCalculation(float x, float y, int maxIterations);
-    bool juliaCalculation(float x, float y, float cx, float cy, int maxIterations);
-    void drawLSystemTree(int x, int y, float angle, int depth); 
-
-    // Helper methods for new effects
-    uint8_t plasma(int x, int y, float time);
-    void updateParticles();
-    void updateGameOfLife();
-
-    // Helper struct for particle properties
-    struct Particle {
-        float x, y;
-        float vx, vy;
-        float life;
-    };
-
-     // Helper struct for raindrop properties
-    struct Raindrop {
-        int x, y;
-        int speed;
-        int size;
-    };
-
-    // Helper struct for ripple properties
-    struct Ripple {
-        int x, y;
-        int size;
-        int life;
-    };
-
-     // Helper method for wave calculation
-    float calculateWave(float x, float time, float frequency, float amplitude);
-
-    // Helper struct for energy line properties
-    struct EnergyLine {
-        int x, y;
-        int length;
-        int speed;
-        bool vertical;
-    };
-
-    void drawStar(int x, int y, int brightness);
-    int stars[100][3]; // Array to hold star positions and brightness
-
-    void drawParticle(int x, int y);
-    struct Particle2 {
-        int x, y;
-        float vx, vy;
-        int lifetime;
-    };
-    Particle2 particles2[100]; // Array to hold particle data
-
-    // Helper struct for marble properties
-    struct Marble {
-        float x, y;    // Position
-        float vy;      // Vertical velocity
-        float radius;  // Marble radius
-        bool active;   // Whether the marble is still bouncing
-    };
-
-    // Helper method for updating marble physics
-    void updateMarble(Marble& marble, float dt);
-
-    // Helper struct for neuron properties
-    struct Neuron {
-        float x, y;
-        float activityLevel;
-        std::vector<int> connections;
-    };
-
-    // Helper methods for neural network simulation
-    void updateNeurons(std::vector<Neuron>& neurons);
-    void drawNeurons(const std::vector<Neuron>& neurons);
-
-    // Updated Helper struct for letter properties
-    struct FallingLetter {
-        char letter;
-        float x, y;
-        float vy;
-        bool settled;
-        float targetY;  // Added targetY member
-    };
 
-    // Helper methods for falling letters effect
-    void updateLetter(FallingLetter& letter);
-    void drawLetters(const std::vector<FallingLetter>& letters);
-    std::string getRandomMessage();
+    FrameScheduler effects;
+    FlickerEffect flicker;
+    TvNoiseEffect noiseBurst;
+    TvNoiseEffect noise;
+    FadeOutEffect fadeOut;
+    ScanLinesEffect scanLines;
+    SweepEffect sweep;
+    GeometricShapesEffect geometricShapes;
+    TextEmergenceEffect textEmergence;
+    MatrixEffect matrix;
+    SpiralEffect spiral;
+    BounceEffect bounce;
+    WaveEffect wave;
+    StarfieldEffect starfield;
+    StarfieldEffect starfieldVertical;
+    FractalEffect mandelbrot;
+    FractalEffect julia;
+    LSystemTreeEffect lSystemTree;
+    PlasmaEffect plasma;
+    ParticleSystemEffect particleSystem;
+    GameOfLifeEffect gameOfLife;
+    VortexEffect vortex;
+    RainEffect rain;
+    DynamicWaveEffect dynamicWave;
+    CyberGridEffect cyberGrid;
+    WarpStarfieldEffect warpStarfield;
+    ParticleExplosionEffect particleExplosion;
+    MarbleDropEffect marbleDrop;
+    FallingLettersEffect fallingLetters;
+
+    Effect* effectFor(EffectId id);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+// PackedFrame.h
+#ifndef PACKED_FRAME_H
+#define PACKED_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+
+// xorshift32: 32 random bits per call, for filling frames a word at a time
+class FastRandom {
+public:
+    explicit FastRandom(uint32_t seed = 2463534242UL) : state(seed ? seed : 1) {}
+    void seed(uint32_t value) { state = value ? value : 1; }
+
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Each bit is set with probability density / 256
+    uint32_t bits(uint16_t density);
+
+private:
+    uint32_t state;
+};
+
+// Whole-byte and whole-word kernels over an SSD1306 framebuffer in its page-major layout:
+// byte page * width + x holds rows 8 * page .. 8 * page + 7 of column x, lowest bit on top.
+// They replace per-pixel drawPixel() loops in the full-screen effects. The buffer is not
+// owned and is worked on in 32-bit words where it can be.
+class PackedFrame {
+public:
+    enum class Op : uint8_t { Set, And, Or, Xor };
+
+    PackedFrame(uint8_t* buffer, uint8_t width, uint8_t height)
+        : buffer(buffer), width(width), height(height), bytes(static_cast<size_t>(width) * ((height + 7) / 8)) {}
+
+    void clear() { fill(0x00); }
+    void fill(uint8_t value);
+
+    // Combines the frame with random bits, each one set with probability density / 256
+    void random(Op op, uint16_t density, FastRandom& rng);
+    // Combines the frame with another of the same size
+    void combine(Op op, const uint8_t* other);
+
+    // Row y lit where samples[x] > threshold, one sample per column
+    void thresholdRow(uint8_t y, const uint8_t* samples, uint8_t threshold);
+    // Copies a row-major, 1 bit per pixel bitmap, LSB first: bit x of row y is bit
+    // y * width + x, or bit x of the row starting at byte y * rowBytes when rowBytes is given
+    void fromRowMajor(const uint8_t* bits, size_t rowBytes = 0);
+
+    void hSpan(int16_t x0, int16_t x1, int16_t y, bool on);
+    void vSpan(int16_t x, int16_t y0, int16_t y1, bool on);
+
+    size_t size() const { return bytes; }
+
+private:
+    uint8_t* buffer;
+    uint8_t width;
+    uint8_t height;
+    size_t bytes;
+};
+
+#endif // PACKED_FRAME_H
@@ -0,0 +1,133 @@
+// PhaseSequencer.h
+#ifndef PHASE_SEQUENCER_H
+#define PHASE_SEQUENCER_H
+
+#include <atomic>
+#include <cstdint>
+#include "EventStore.h"
+#if defined(ESP32)
+#include <esp_timer.h>
+#endif
+
+#ifndef PHASE_SCENARIO_CAPACITY
+#define PHASE_SCENARIO_CAPACITY 8
+#endif
+
+#ifndef PHASE_CYCLE_CAPACITY
+#define PHASE_CYCLE_CAPACITY 4
+#endif
+
+// One step of a cycle plan: a signal state held for a fixed time.
+struct Phase {
+    uint16_t duration;  // In PhaseSequencer ticks
+    uint8_t state;      // Signal state shown for the phase, as understood by the output driver
+};
+
+// Phase table for one scenario and cycle, normally a const array in flash. The cycle is
+// the phases in order; it starts at reference + offset + k * cycle length, which lines
+// up neighbouring controllers that share the reference.
+struct CyclePlan {
+    const Phase* phases;
+    uint8_t phaseCount;
+    uint16_t offset;  // In ticks
+
+    uint32_t cycleTicks() const {
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < phaseCount; i++) total += phases[i].duration;
+        return total;
+    }
+};
+
+// Steps through the CyclePlan selected by scenario and cycle. Phase ends are computed
+// from the plan rather than from when the previous step ran, so a late timer callback
+// never shifts the cycle. A newly selected plan is swapped in at the next cycle boundary
+// in O(1). It starts at its first phase, which is held until the plan's own cycle start
+// (reference + offset + k * length) and then runs its full duration, so controllers
+// stay coordinated across plan changes and no phase is cut short.
+// All time inputs are passed in (microseconds on any monotonic counter), so the engine
+// runs on the host with a simulated clock; PhaseTimer drives it from esp_timer on the ESP32.
+// run() belongs to one context (the timer); select() and the getters may be called from any task.
+class PhaseSequencer {
+public:
+    static constexpr uint32_t TickUs = 10000;
+
+    struct PhaseChange {
+        uint8_t scenario;
+        uint8_t cycle;
+        uint8_t phase;
+        uint8_t state;
+        uint32_t cycleCount;  // Completed cycles since start()
+        uint64_t plannedUs;   // When the phase was due; the handler may run slightly later
+    };
+
+    using Handler = void (*)(const PhaseChange& change, void* context);
+
+    static constexpr uint16_t ticks(uint32_t ms) { return static_cast<uint16_t>(ms * 1000 / TickUs); }
+
+    PhaseSequencer();
+
+    // Plans are registered before start(); the sequencer keeps the pointer.
+    bool setPlan(uint8_t scenario, uint8_t cycle, const CyclePlan* plan);
+    void setHandler(Handler handler, void* context);
+
+    // Requests a plan for the next cycle boundary. False when no plan is registered for it.
+    bool select(uint8_t scenario, uint8_t cycle);
+    void onEvent(const ScheduledEvent& event) { select(event.scenario, event.cycle); }
+
+    // Enters the selected plan at the position its offset gives for nowUs. The reference
+    // may lie before the counter's zero, such as the last midnight shortly after boot.
+    bool start(uint64_t nowUs, int64_t referenceUs = 0);
+    void stop();
+
+    // Completes every phase that ended at or before nowUs. Returns the planned time of the
+    // next phase end, or 0 when stopped.
+    uint64_t run(uint64_t nowUs);
+
+    bool isRunning() const { return running; }
+    uint8_t getScenario() const { return scenario; }
+    uint8_t getCycle() const { return cycle; }
+    uint8_t getPhase() const { return phaseIndex; }
+    uint32_t getCycleCount() const { return cycleCount; }
+
+private:
+    static constexpr uint16_t NoRequest = 0xFFFF;
+
+    const CyclePlan* plans[PHASE_SCENARIO_CAPACITY][PHASE_CYCLE_CAPACITY];
+    Handler handler;
+    void* context;
+    std::atomic<uint16_t> requested;  // scenario << 8 | cycle, or NoRequest
+
+    const CyclePlan* plan;
+    volatile bool running;
+    volatile uint8_t scenario;
+    volatile uint8_t cycle;
+    volatile uint8_t phaseIndex;
+    volatile uint32_t cycleCount;
+    uint64_t phaseEndUs;
+    int64_t referenceUs;
+
+    const CyclePlan* lookup(uint16_t key) const;
+    uint64_t intoCycleUs(uint64_t atUs) const;
+    void enter(uint8_t index, uint64_t startUs);
+};
+
+#if defined(ESP32)
+// Runs a PhaseSequencer from a one-shot esp_timer armed for each planned phase end.
+// Callbacks run on the high-priority esp_timer task, away from loop() and the display.
+class PhaseTimer {
+public:
+    explicit PhaseTimer(PhaseSequencer& sequencer) : sequencer(sequencer), timer(nullptr) {}
+    bool begin();
+    bool start(int64_t referenceUs = 0);  // Reference on the esp_timer_get_time() scale
+    void stop();
+
+private:
+    PhaseSequencer& sequencer;
+    esp_timer_handle_t timer;
+
+    void arm(uint64_t dueUs);
+    static void onTimer(void* arg);
+};
+#endif // ESP32
+
+#endif // PHASE_SEQUENCER_H
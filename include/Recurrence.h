@@ -0,0 +1,93 @@
+// Recurrence.h
+#ifndef RECURRENCE_H
+#define RECURRENCE_H
+
+#include <cstdint>
+#include "CivilTime.h"
+
+// Compact recurrence rule: a time of day on selected weekdays, optionally every Nth
+// week and limited to a date range. Stored once per plan; EventManager keeps only the
+// next occurrence in the schedule and asks the rule for the following one when it fires.
+// Pure integer arithmetic on epoch seconds, so it runs unchanged on the host.
+struct RecurrenceRule {
+    enum : uint8_t {
+        Sunday = 1 << 0,
+        Monday = 1 << 1,
+        Tuesday = 1 << 2,
+        Wednesday = 1 << 3,
+        Thursday = 1 << 4,
+        Friday = 1 << 5,
+        Saturday = 1 << 6,
+        Weekdays = Monday | Tuesday | Wednesday | Thursday | Friday,
+        Weekend = Saturday | Sunday,
+        EveryDay = Weekdays | Weekend
+    };
+
+    static constexpr uint32_t Never = 0xFFFFFFFF;
+    static constexpr uint16_t Unbounded = 0xFFFF;
+
+    uint32_t secondOfDay;
+    uint16_t firstDay;      // Days since 1970-01-01, inclusive
+    uint16_t lastDay;       // Inclusive, or Unbounded
+    uint8_t weekdayMask;    // Bit 0 = Sunday; 0 marks an unused rule
+    uint8_t intervalWeeks;  // 1 = every week, N = every Nth week counted from firstDay
+
+    static constexpr RecurrenceRule onWeekdays(uint8_t mask, uint8_t hour, uint8_t minute, uint8_t second) {
+        return RecurrenceRule{static_cast<uint32_t>(hour * 3600UL + minute * 60UL + second), 0, Unbounded,
+                              static_cast<uint8_t>(mask & EveryDay), 1};
+    }
+
+    static constexpr RecurrenceRule daily(uint8_t hour, uint8_t minute, uint8_t second) {
+        return onWeekdays(EveryDay, hour, minute, second);
+    }
+
+    // dayOfWeek: 0 = Sunday
+    static constexpr RecurrenceRule weekly(uint8_t dayOfWeek, uint8_t hour, uint8_t minute, uint8_t second,
+                                           uint8_t everyNWeeks = 1) {
+        RecurrenceRule rule = onWeekdays(static_cast<uint8_t>(1 << (dayOfWeek % 7)), hour, minute, second);
+        rule.intervalWeeks = everyNWeeks ? everyNWeeks : 1;
+        return rule;
+    }
+
+    // Same rule limited to [first, last] calendar dates, both inclusive.
+    constexpr RecurrenceRule between(uint16_t firstYear, uint8_t firstMonth, uint8_t firstDayOfMonth,
+                                     uint16_t lastYear, uint8_t lastMonth, uint8_t lastDayOfMonth) const {
+        RecurrenceRule rule = *this;
+        rule.firstDay = static_cast<uint16_t>(CivilTime::daysFromCivil(firstYear, firstMonth, firstDayOfMonth));
+        rule.lastDay = static_cast<uint16_t>(CivilTime::daysFromCivil(lastYear, lastMonth, lastDayOfMonth));
+        return rule;
+    }
+
+    constexpr bool isValid() const {
+        return weekdayMask != 0 && secondOfDay < CivilTime::SecondsPerDay && intervalWeeks != 0 &&
+               firstDay <= lastDay;
+    }
+
+    constexpr bool occursOn(uint32_t day) const {
+        return day >= firstDay && day <= lastDay &&
+               (weekdayMask & (1 << ((day + 4) % 7))) != 0 &&
+               (intervalWeeks <= 1 || ((day - firstDay) / 7) % intervalWeeks == 0);
+    }
+
+    // First occurrence at or after t, or Never once the date range is exhausted.
+    // Scans at most 7 * intervalWeeks days, so the cost does not depend on how far ahead it looks.
+    constexpr uint32_t firstAtOrAfter(uint32_t t) const {
+        if (!isValid()) return Never;
+        uint32_t day = t / CivilTime::SecondsPerDay;
+        if (t % CivilTime::SecondsPerDay > secondOfDay) ++day;
+        if (day < firstDay) day = firstDay;
+        for (uint32_t i = 0; i < 7UL * intervalWeeks; ++i, ++day) {
+            if (day > lastDay) return Never;
+            if (occursOn(day)) return day * CivilTime::SecondsPerDay + secondOfDay;
+        }
+        return Never;
+    }
+};
+
+static_assert(RecurrenceRule::daily(7, 0, 0).firstAtOrAfter(CivilTime::toEpoch(2024, 7, 20, 7, 0, 1)) ==
+                  CivilTime::toEpoch(2024, 7, 21, 7, 0, 0), "daily rule must roll to the next day");
+static_assert(RecurrenceRule::onWeekdays(RecurrenceRule::Weekdays, 7, 0, 0)
+                      .firstAtOrAfter(CivilTime::toEpoch(2024, 7, 20, 8, 0, 0)) ==
+                  CivilTime::toEpoch(2024, 7, 22, 7, 0, 0), "weekday rule must skip the weekend");
+
+#endif // RECURRENCE_H
@@ -0,0 +1,44 @@
+// RenderTask.h
+#ifndef RENDER_TASK_H
+#define RENDER_TASK_H
+
+#include <Arduino.h>
+#include "FrameHandoff.h"
+#include "EventStore.h"
+#include "OLEDManager.h"
+
+// Runs all OLEDManager drawing and I2C flushes on its own pinned FreeRTOS task, so the
+// scheduler core never waits on the display. The scheduler side publishes what to show
+// through a FrameHandoff and returns immediately; the render task draws the latest frame.
+// Between frames it plays OLEDManager effects, one frame at a time, so a published event
+// interrupts an effect at the next frame instead of waiting for it to finish.
+// publish* must be called from a single task (the Arduino loop).
+class RenderTask {
+public:
+    struct Frame {
+        TimeCode time;
+        uint32_t eventSerial;  // Changes whenever a new event should be shown
+        ScheduledEvent event;
+    };
+
+    explicit RenderTask(OLEDManager& oled);
+    bool begin(BaseType_t core = 0, uint32_t stackSize = 4096, UBaseType_t priority = 1);
+    void publishTime(TimeCode now);
+    void publishEvent(const ScheduledEvent& event);
+    uint32_t getFramesRendered() const;
+
+private:
+    OLEDManager& oled;
+    FrameHandoff<Frame> frames;
+    Frame latest;               // Writer-side copy of the current state
+    uint32_t lastEventSerial;   // Render-task side
+    TimeCode lastRenderedTime;  // Render-task side
+    volatile uint32_t framesRendered;
+    TaskHandle_t task;
+
+    void publish();
+    void render(const Frame& frame);
+    static void taskMain(void* arg);
+};
+
+#endif // RENDER_TASK_H
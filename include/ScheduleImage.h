@@ -0,0 +1,113 @@
+// ScheduleImage.h
+#ifndef SCHEDULE_IMAGE_H
+#define SCHEDULE_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "EventStore.h"
+#include "Recurrence.h"
+#if defined(ESP32)
+#include <esp_partition.h>
+#endif
+
+// Binary schedule image, little-endian, every section 4-byte aligned:
+//   ImageHeader | ImageEvent[eventCount] sorted by timeCode | ImageRule[ruleCount] | string table
+// Descriptions are byte offsets into the string table of NUL-terminated strings.
+// headerCrc covers the header up to itself; payloadCrc covers everything after the header.
+struct ImageHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t eventCount;
+    uint32_t ruleCount;
+    uint32_t stringsOffset;
+    uint32_t stringsSize;
+    uint32_t payloadCrc;
+    uint32_t headerCrc;
+};
+
+struct ImageEvent {
+    TimeCode timeCode;
+    uint8_t scenario;
+    uint8_t cycle;
+    uint16_t description;
+};
+
+struct ImageRule {
+    uint32_t secondOfDay;
+    uint16_t firstDay;
+    uint16_t lastDay;
+    uint8_t weekdayMask;
+    uint8_t intervalWeeks;
+    uint8_t scenario;
+    uint8_t cycle;
+    uint16_t description;
+    uint16_t reserved;
+
+    RecurrenceRule recurrence() const {
+        return RecurrenceRule{secondOfDay, firstDay, lastDay, weekdayMask, intervalWeeks};
+    }
+};
+
+static_assert(sizeof(ImageHeader) == 32 && sizeof(ImageEvent) == 8 && sizeof(ImageRule) == 16,
+              "Schedule image records must match the on-flash layout");
+
+// Read-only view over an image that stays where it is (memory-mapped flash or a file buffer).
+// open() checks only the header, so it costs the same for any schedule size; verify()
+// walks the whole payload and belongs at install time or in the host tool.
+class ScheduleImage {
+public:
+    static constexpr uint32_t Magic = 0x44484353;  // "SCHD"
+    static constexpr uint16_t Version = 1;
+
+    enum class Status : uint8_t {
+        Ok,
+        NotFound,
+        TooSmall,
+        BadMagic,
+        BadVersion,
+        BadHeader,
+        BadLayout,
+        BadChecksum,
+        Unsorted,
+        BadRecord
+    };
+
+    ScheduleImage();
+    Status open(const void* data, size_t size);
+#if defined(ESP32)
+    Status openPartition(const char* label);  // Maps a data partition into the address space
+#endif
+    Status verify() const;
+    void close();
+
+    bool isOpen() const { return header != nullptr; }
+    uint32_t eventCount() const { return header ? header->eventCount : 0; }
+    uint32_t ruleCount() const { return header ? header->ruleCount : 0; }
+    size_t imageSize() const { return header ? header->stringsOffset + header->stringsSize : 0; }
+    uint32_t checksum() const { return header ? header->payloadCrc : 0; }
+
+    const ImageEvent& event(uint32_t index) const { return events[index]; }
+    const ImageRule& rule(uint32_t index) const { return rules[index]; }
+    const char* string(uint16_t offset) const { return offset < header->stringsSize ? strings + offset : ""; }
+
+    uint32_t lowerBound(TimeCode timeCode) const;  // First event at or after timeCode
+    bool contains(TimeCode timeCode) const;
+    // False when the label table had no room for the description, which is then left empty.
+    bool materialize(uint32_t index, ScheduledEvent& event) const;
+
+    static const char* statusName(Status status);
+    static uint32_t crc32(const void* data, size_t length, uint32_t crc = 0);
+
+private:
+    const ImageHeader* header;
+    const ImageEvent* events;
+    const ImageRule* rules;
+    const char* strings;
+#if defined(ESP32)
+    spi_flash_mmap_handle_t mapHandle;
+    bool mapped;
+#endif
+};
+
+#endif // SCHEDULE_IMAGE_H
@@ -0,0 +1,250 @@
+// ScheduleJournal.h
+#ifndef SCHEDULE_JOURNAL_H
+#define SCHEDULE_JOURNAL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "EventManager.h"
+#if defined(ESP32)
+#include <esp_partition.h>
+#endif
+
+#ifndef JOURNAL_SECTOR_SIZE
+#define JOURNAL_SECTOR_SIZE 4096  // Erase unit of the ESP32's SPI flash
+#endif
+
+#ifndef JOURNAL_QUEUE_CAPACITY
+#define JOURNAL_QUEUE_CAPACITY 512  // Records waiting for the writer; must hold a full snapshot
+#endif
+
+#ifndef JOURNAL_WRITE_DELAY_MS
+#define JOURNAL_WRITE_DELAY_MS 500  // Writer task batches what arrives within this long
+#endif
+
+// Erase-before-write storage with NOR flash rules: erasing sets a sector to 0xFF and
+// writes can only clear bits. Offsets are relative to the start of the storage.
+class JournalStorage {
+public:
+    virtual ~JournalStorage() {}
+    virtual uint32_t size() const = 0;
+    virtual bool read(uint32_t offset, void* data, size_t length) const = 0;
+    virtual bool write(uint32_t offset, const void* data, size_t length) = 0;
+    virtual bool eraseSector(uint32_t offset) = 0;
+};
+
+// Host stand-in over a caller's buffer, with the same write rules as flash.
+class MemoryJournalStorage : public JournalStorage {
+public:
+    MemoryJournalStorage(uint8_t* buffer, uint32_t length) : buffer(buffer), length(length), erases(0) {}
+
+    uint32_t size() const override { return length; }
+    bool read(uint32_t offset, void* data, size_t count) const override {
+        if (offset + count > length) return false;
+        memcpy(data, buffer + offset, count);
+        return true;
+    }
+    bool write(uint32_t offset, const void* data, size_t count) override {
+        if (offset + count > length) return false;
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < count; i++) buffer[offset + i] &= bytes[i];
+        return true;
+    }
+    bool eraseSector(uint32_t offset) override {
+        if (offset % JOURNAL_SECTOR_SIZE != 0 || offset + JOURNAL_SECTOR_SIZE > length) return false;
+        memset(buffer + offset, 0xFF, JOURNAL_SECTOR_SIZE);
+        ++erases;
+        return true;
+    }
+
+    uint32_t getErases() const { return erases; }
+
+private:
+    uint8_t* buffer;
+    uint32_t length;
+    uint32_t erases;
+};
+
+#if defined(ESP32)
+// A data partition from partitions.csv. Writes and erases stall code running from flash
+// on both cores for their duration: tens of microseconds per record, tens of
+// milliseconds per sector erase.
+class PartitionJournalStorage : public JournalStorage {
+public:
+    PartitionJournalStorage() : partition(nullptr) {}
+    bool begin(const char* label);
+
+    uint32_t size() const override { return partition ? partition->size : 0; }
+    bool read(uint32_t offset, void* data, size_t length) const override;
+    bool write(uint32_t offset, const void* data, size_t length) override;
+    bool eraseSector(uint32_t offset) override;
+
+private:
+    const esp_partition_t* partition;
+};
+#endif
+
+// Append-only log of the EventManager overlay and the current scenario, so a restart
+// resumes the running plan instead of rebuilding it from code.
+//
+// The storage is a ring of sectors, each starting with a header (magic, sequence);
+// sequence s always lives in sector s % sectorCount. Records are small (4-byte header
+// with type, length and check, payload padded to 4 bytes) and never span sectors. Each
+// edit appends one record, so a change costs one flash write and a sector is erased
+// only once it is full. When the log since the last snapshot reaches half the ring, a
+// new snapshot (Begin, the state, End) goes into the next sector; older sectors become
+// free without being touched. A snapshot cut short by a reset has no End, and replay
+// falls back to the previous one, which is still intact because the ring never reaches it.
+//
+// Flash writes and erases stall code running from flash on both cores, so nothing is
+// written from the edit handler or the dispatcher callback. Edits and snapshots are
+// queued in RAM, a delivered event only updates the position in RAM, and flush() writes
+// the queue and the newest position: from the low-priority writer task on the device,
+// or directly on the host. Queueing must come from one task, the one running the
+// dispatcher and the edits; flush() from one other task.
+//
+// replay() applies the newest complete snapshot and everything logged after it, then
+// resumes the manager at the last delivered event.
+class ScheduleJournal {
+public:
+    struct Stats {
+        uint32_t records;          // Appended since begin()
+        uint32_t bytesWritten;
+        uint32_t sectorsErased;
+        uint32_t compactions;
+        uint32_t failures;         // Appends lost to a storage error or a full ring
+        uint32_t queueOverflows;   // Records lost to a full queue; a snapshot follows
+        uint32_t replayedRecords;
+        uint32_t replayUs;
+    };
+
+    ScheduleJournal(EventManager& manager, JournalStorage& storage);
+
+    // Finds the end of the log. False when the storage holds fewer than four sectors.
+    bool begin();
+    // Restores the schedule on top of whatever image is loaded. False when there is no
+    // complete snapshot, or it was taken over a different image.
+    bool replay();
+    // Starts logging edits and delivered events, from a fresh snapshot of the current state.
+    bool attach(EventDispatcher& dispatcher);
+    // Queues a snapshot of the current state. False when the queue has no room for one
+    // yet; it is then queued with a later edit or event.
+    bool compact();
+    // Writer side: writes everything queued and the newest delivered position.
+    void flush();
+#if defined(ESP32)
+    bool startWriterTask(BaseType_t core = 0, uint32_t stackSize = 4096, UBaseType_t priority = 1);
+#endif
+
+    bool hasSnapshot() const { return baseSequence != NoSequence; }
+    size_t getQueued() const { return queue.size(); }
+    const Stats& getStats() const { return stats; }
+
+    static void onEdit(const EventManager::ScheduleEdit& edit, void* journal);
+    void onEvent(const ScheduledEvent& event);
+
+private:
+    static constexpr uint32_t Magic = 0x4C4E524A;  // "JRNL"
+    static constexpr uint32_t NoSequence = 0xFFFFFFFF;
+    static constexpr uint32_t SectorHeaderSize = 8;
+    static constexpr uint32_t RecordHeaderSize = 4;
+    static constexpr size_t MaxPayload = 255;
+    static constexpr uint8_t ImageAttached = 0x01;
+    // Begin, Delivered, every overlay event or its rule, the image removals and End
+    static constexpr size_t SnapshotEntries = EVENT_MANAGER_CAPACITY + EVENT_IMAGE_MASK_CAPACITY + 3;
+    static_assert(JOURNAL_QUEUE_CAPACITY > SnapshotEntries, "JOURNAL_QUEUE_CAPACITY must hold a full snapshot");
+
+    enum RecordType : uint8_t {
+        Begin = 1,            // imageChecksum u32, flags u8
+        End,
+        Delivered,            // timeCode u32, scenario, cycle
+        EventAdded,           // timeCode u32, scenario, cycle, description
+        EventRemoved,         // timeCode u32
+        RuleAdded,            // secondOfDay u32, firstDay u16, lastDay u16, weekdays, interval, id, scenario, cycle, description
+        RuleRemoved,          // id
+        ScenarioRemoved,      // scenario
+        ScenarioRescheduled,  // scenario, offsetSeconds i32
+        Cleared
+    };
+
+    struct Record {
+        uint8_t type;
+        uint8_t length;
+        uint8_t payload[MaxPayload + 1];  // Room for a terminating NUL after a description
+    };
+
+    // A record waiting for the writer. Descriptions travel as label ids, which stay valid
+    // when an image is unmapped before the record is written.
+    struct Entry {
+        uint8_t type;
+        uint8_t scenario;  // Flags for Begin
+        uint8_t cycle;
+        uint8_t ruleId;
+        LabelId label;
+        uint8_t weekdayMask;
+        uint8_t intervalWeeks;
+        uint32_t value;  // timeCode, offsetSeconds, secondOfDay, or the image checksum for Begin
+        uint16_t firstDay;
+        uint16_t lastDay;
+    };
+
+    // Position of a record while walking the log
+    struct Cursor {
+        uint32_t sequence;
+        uint32_t offset;
+    };
+
+    enum class ReadResult : uint8_t { Ok, End, Corrupt };
+
+    EventManager& manager;
+    JournalStorage& storage;
+    uint32_t sectorCount;
+    uint32_t baseSequence;        // Sector holding the Begin of the newest complete snapshot
+    uint32_t unfinishedSequence;  // Sector of a later snapshot that has no End
+    uint32_t sequence;            // Sector being appended to
+    uint32_t writeOffset;
+    uint32_t snapshotSequence;    // Sector the snapshot being written started in
+    bool compacting;
+    bool snapshotWritten;         // Every record of that snapshot so far reached the flash
+    bool attached;
+    TimeCode deliveredUntil;      // Replay side
+    uint8_t currentScenario;
+    uint8_t currentCycle;
+    uint8_t ruleIds[EVENT_RULE_CAPACITY];  // Logged rule id -> id given by the manager during replay
+    SpscRing<Entry, JOURNAL_QUEUE_CAPACITY> queue;
+    std::atomic<uint64_t> position;        // Newest delivered timeCode, scenario and cycle, packed
+    uint64_t loggedPosition;               // Writer side: the position last written
+    std::atomic<bool> snapshotWanted;
+    Stats stats;
+#if defined(ESP32)
+    TaskHandle_t writerTask;
+    static void writerTaskMain(void* arg);
+#endif
+
+    static uint64_t pack(TimeCode timeCode, uint8_t scenario, uint8_t cycle) {
+        return timeCode | static_cast<uint64_t>(scenario) << 32 | static_cast<uint64_t>(cycle) << 40;
+    }
+
+    uint32_t sectorOffset(uint32_t sectorSequence) const {
+        return (sectorSequence % sectorCount) * JOURNAL_SECTOR_SIZE;
+    }
+    bool readSectorSequence(uint32_t index, uint32_t& sectorSequence) const;
+    ReadResult readRecord(Cursor& cursor, Record& record) const;
+    ReadResult next(Cursor& cursor, Record& record) const;
+    static uint16_t check(const Record& record);
+
+    void enqueue(const Entry& entry);
+    void wake();
+
+    void write(const Entry& entry);
+    bool writeRecord(const Entry& entry);
+    bool append(uint8_t type, const uint8_t* payload, size_t length);
+    bool openSector(uint32_t sectorSequence);
+    bool appendEvent(uint8_t type, TimeCode timeCode, uint8_t scenario, uint8_t cycle, const char* description);
+    bool appendRule(uint8_t id, const RecurrenceRule& rule, uint8_t scenario, uint8_t cycle, const char* description);
+
+    void apply(Record& record);
+};
+
+#endif // SCHEDULE_JOURNAL_H
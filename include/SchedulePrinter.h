@@ -0,0 +1,28 @@
+// SchedulePrinter.h
+#ifndef SCHEDULE_PRINTER_H
+#define SCHEDULE_PRINTER_H
+
+#include <Arduino.h>
+#include "EventManager.h"
+
+// Streams the schedule to a Print target a few lines at a time instead of in one
+// blocking pass. start() begins a listing; pump() is called from loop() and writes only
+// while the transmit buffer has room and the time budget lasts, resuming after the last
+// printed event on the next call. Schedule changes in between are picked up, not replayed.
+class SchedulePrinter {
+public:
+    SchedulePrinter(const EventManager& manager, Print& out);
+    void start();
+    bool pump(uint32_t budgetUs = 2000);  // True while there is more to print
+    bool isActive() const;
+
+private:
+    const EventManager& manager;
+    Print& out;
+    TimeCode nextTime;
+    uint32_t printed;
+    bool active;
+    bool headerDone;
+};
+
+#endif // SCHEDULE_PRINTER_H
@@ -0,0 +1,73 @@
+// SoftClock.h
+#ifndef SOFT_CLOCK_H
+#define SOFT_CLOCK_H
+
+#include <cstdint>
+
+// Software clock extrapolated from a monotonic millisecond counter and disciplined
+// against a whole-second hardware clock (the DS3231).
+//  - The RTC is read only while locating a seconds edge: once at begin() and then once
+//    per discipline interval, polling every EdgePollMs until the seconds value changes.
+//    Each later search starts EdgeLeadPolls polls before the edge predicted from the
+//    last one and the drift, so it takes a handful of reads instead of a second's worth.
+//  - Drift between the local counter and the RTC is estimated across edges (ppm) and
+//    folded into the extrapolation.
+//  - Small corrections are slewed in at most 1 ms per SlewDivisor ms, so the clock stays
+//    continuous and monotonic and never skips or repeats a second. Larger errors, such
+//    as the RTC being set, step the clock.
+// All time inputs are passed in, so the clock runs on the host with a simulated counter.
+class SoftClock {
+public:
+    class Source {
+    public:
+        virtual ~Source() {}
+        virtual uint32_t readEpoch() = 0;  // Whole seconds since 1970-01-01
+    };
+
+    static constexpr uint32_t EdgePollMs = 10;
+    static constexpr uint32_t SlewDivisor = 20;
+    static constexpr int32_t MaxSlewMs = 2000;
+    static constexpr uint32_t EdgeLeadPolls = 4;
+    static constexpr int32_t MaxDriftPpm = 200;  // Crystal tolerance assumed before the drift is measured
+
+    explicit SoftClock(Source& source, uint32_t disciplineIntervalMs = 600000);
+
+    void begin(uint32_t monoMs);
+    void poll(uint32_t monoMs);  // At most one RTC read per call
+    uint64_t nowMs(uint32_t monoMs);
+    uint32_t now(uint32_t monoMs) { return static_cast<uint32_t>(nowMs(monoMs) / 1000); }
+    uint32_t msUntilNextSecond(uint32_t monoMs) { return 1000 - static_cast<uint32_t>(nowMs(monoMs) % 1000); }
+    uint32_t msUntilNextPoll(uint32_t monoMs) const;  // How long a caller may sleep before poll() has work
+
+    bool isLocked() const { return locked; }
+    int32_t getDriftPpm() const { return driftPpm; }
+    int32_t getLastErrorMs() const { return lastErrorMs; }
+    uint32_t getRtcReads() const { return rtcReads; }
+
+private:
+    Source& source;
+    uint32_t disciplineIntervalMs;
+
+    uint64_t anchorEpochMs;
+    uint32_t anchorMono;
+    int32_t driftPpm;    // Local counter runs fast by this many ppm
+    bool driftMeasured;  // driftPpm holds a measurement rather than the initial guess of 0
+    int32_t slewMs;      // Correction still being slewed in from anchorMono
+    uint64_t lastReturnedMs;
+
+    bool locked;
+    bool seeking;
+    uint32_t seekEpoch;
+    uint32_t lastPollMono;
+    uint32_t seekStartMono;  // When the next edge search starts
+    uint32_t lastEdgeEpoch;
+    uint32_t lastEdgeMono;
+    int32_t lastErrorMs;
+    uint32_t rtcReads;
+
+    uint32_t read();
+    uint64_t extrapolate(uint32_t monoMs) const;
+    void onEdge(uint32_t epoch, uint32_t edgeMono);
+};
+
+#endif // SOFT_CLOCK_H
@@ -0,0 +1,60 @@
+// SpscRing.h
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+
+// Lock-free single-producer/single-consumer ring over an inline array; never allocates.
+// push() may only be called from one task and front()/popFront() from one other task.
+// The consumer reads the front item in place and releases the slot with popFront(),
+// so the producer cannot overwrite it while it is being handled.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing() : head(0), tail(0) {}
+
+    static constexpr size_t capacity() { return Capacity; }
+
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    bool full() const { return size() == Capacity; }
+
+    // Producer side
+    bool push(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity) return false;
+        items[t & (Capacity - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: oldest item, or nullptr when empty
+    const T* front() const {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return nullptr;
+        return &items[h & (Capacity - 1)];
+    }
+
+    void popFront() {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    // Consumer side: drops everything published so far
+    void clear() {
+        head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    T items[Capacity];
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,66 @@
+// TimeService.h
+#ifndef TIME_SERVICE_H
+#define TIME_SERVICE_H
+
+#include <Arduino.h>
+#include "RTClib.h"
+#include "SoftClock.h"
+#include "EventStore.h"
+
+#ifndef TIME_SERVICE_DISCIPLINE_MS
+#define TIME_SERVICE_DISCIPLINE_MS 600000UL  // Re-discipline against the DS3231 every 10 minutes
+#endif
+
+// Shared wall clock for the scheduler and the display. Reads the DS3231 only while
+// disciplining the SoftClock, so the I2C bus is left to the SSD1306 the rest of the time.
+// With the DS3231's 1 Hz square wave wired to an interrupt pin, the time within the
+// second is measured with micros() from the last falling edge (where the RTC's seconds
+// roll over) instead of extrapolated, for millisecond event timing. The RTC is read once
+// per discipline interval, just after an edge, to number the edges; the SoftClock
+// remains the fallback whenever the square wave stops.
+class TimeService : private SoftClock::Source {
+public:
+    static constexpr uint32_t SquareWaveTimeoutUs = 1500000;  // Edge overdue by this much: wave lost
+    static constexpr uint32_t SquareWaveReadWindowUs = 500000;  // Read the RTC only this soon after an edge
+
+    explicit TimeService(RTC_DS3231& rtc, uint32_t disciplineIntervalMs = TIME_SERVICE_DISCIPLINE_MS);
+    void begin();
+#if defined(ESP32)
+    // INT/SQW carries either the square wave or alarms, so this excludes Ds3231AlarmDeadline.
+    // Attach from the task that reads the clock, so the edge interrupt runs on its core.
+    bool attachSquareWave(uint8_t interruptPin);
+#endif
+    void onSquareWaveEdge(uint32_t edgeMicros);  // Interrupt entry; host simulations call it directly
+    bool hasSquareWaveLock();
+    void update();  // Call from loop(); drives discipline without blocking
+    TimeCode now();
+    uint64_t nowMs();
+    DateTime nowDateTime();
+    bool secondTicked();  // True once per new second, for display refresh on the second boundary
+    uint32_t msUntilNextSecond();
+    uint32_t msUntilNextPoll() const;
+    int32_t getDriftPpm() const;
+    uint32_t getRtcReads() const;
+
+private:
+    RTC_DS3231& rtc;
+    SoftClock clock;
+    uint32_t disciplineIntervalMs;
+    TimeCode lastTickedSecond;
+
+    volatile uint32_t edgeCount;
+    volatile uint32_t edgeMicros;
+    bool waveLocked;
+    uint32_t baseEdgeCount;  // Edge that started second baseEpoch
+    TimeCode baseEpoch;
+    uint32_t lockedAtMs;
+    uint64_t lastWaveMs;
+
+    uint32_t readEpoch() override;
+    bool waveNowMs(uint64_t& ms);
+#if defined(ESP32)
+    static void IRAM_ATTR onSquareWave(void* arg);
+#endif
+};
+
+#endif // TIME_SERVICE_H
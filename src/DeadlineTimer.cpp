@@ -0,0 +1,91 @@
+// DeadlineTimer.cpp
+#include "DeadlineTimer.h"
+
+#if defined(ESP32)
+#include "TimeService.h"
+
+bool NotifyingDeadline::begin() {
+    task = xTaskGetCurrentTaskHandle();
+    return true;
+}
+
+void NotifyingDeadline::wait(uint32_t maxWaitMs) {
+    if (hasFired() || maxWaitMs == 0) return;
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(maxWaitMs));
+}
+
+void NotifyingDeadline::notify() {
+    signal();
+    if (task != nullptr) xTaskNotifyGive(task);
+}
+
+void IRAM_ATTR NotifyingDeadline::notifyFromISR() {
+    signal();
+    if (task != nullptr) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    }
+}
+
+bool EspTimerDeadline::begin() {
+    esp_timer_create_args_t args = {};
+    args.callback = &EspTimerDeadline::onTimer;
+    args.arg = this;
+    args.name = "event-deadline";
+    if (esp_timer_create(&args, &timer) != ESP_OK) return false;
+    return NotifyingDeadline::begin();
+}
+
+void EspTimerDeadline::arm(uint32_t delayMs) {
+    if (timer == nullptr) return;
+    esp_timer_stop(timer);
+    consumeFired();
+    if (delayMs == 0) {
+        notify();
+        return;
+    }
+    esp_timer_start_once(timer, static_cast<uint64_t>(delayMs) * 1000);
+}
+
+void EspTimerDeadline::disarm() {
+    if (timer != nullptr) esp_timer_stop(timer);
+}
+
+void EspTimerDeadline::onTimer(void* arg) {
+    static_cast<EspTimerDeadline*>(arg)->notify();
+}
+
+Ds3231AlarmDeadline::Ds3231AlarmDeadline(RTC_DS3231& rtc, TimeService& clock, uint8_t interruptPin)
+    : rtc(rtc), clock(clock), interruptPin(interruptPin) {}
+
+bool Ds3231AlarmDeadline::begin() {
+    rtc.disableAlarm(2);
+    rtc.clearAlarm(1);
+    rtc.clearAlarm(2);
+    rtc.writeSqwPinMode(DS3231_OFF);  // INT/SQW pin signals alarms instead of a square wave
+    pinMode(interruptPin, INPUT_PULLUP);
+    attachInterruptArg(digitalPinToInterrupt(interruptPin), &Ds3231AlarmDeadline::onAlarm, this, FALLING);
+    return NotifyingDeadline::begin();
+}
+
+void Ds3231AlarmDeadline::arm(uint32_t delayMs) {
+    rtc.clearAlarm(1);
+    consumeFired();
+    if (delayMs == 0) {
+        notify();
+        return;
+    }
+    TimeCode due = clock.now() + (delayMs + 999) / 1000;
+    rtc.setAlarm1(DateTime(due), DS3231_A1_Date);
+}
+
+void Ds3231AlarmDeadline::disarm() {
+    rtc.disableAlarm(1);
+    rtc.clearAlarm(1);
+}
+
+void IRAM_ATTR Ds3231AlarmDeadline::onAlarm(void* arg) {
+    static_cast<Ds3231AlarmDeadline*>(arg)->notifyFromISR();
+}
+#endif // ESP32
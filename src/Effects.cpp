@@ -0,0 +1,805 @@
+// Effects.cpp
+#include "Effects.h"
+#include <math.h>
+#include <string.h>
+
+Effect::Effect(Adafruit_SSD1306& display)
+    : display(display), width(display.width()), height(display.height()), frame(0), startMs(0), nextFrameMs(0),
+      running(false) {}
+
+void Effect::start(uint32_t nowMs) {
+    frame = 0;
+    startMs = nowMs;
+    nextFrameMs = nowMs;
+    running = true;
+    reset();
+}
+
+bool Effect::tick(uint32_t nowMs) {
+    if (!running || static_cast<int32_t>(nowMs - nextFrameMs) < 0) return false;
+    uint32_t waitMs = render(frame++, nowMs - startMs);
+    if (waitMs == Stop) {
+        running = false;
+        return false;
+    }
+    nextFrameMs = nowMs + waitMs;
+    return true;
+}
+
+FrameScheduler::FrameScheduler() : queue(), head(0), count(0), current(nullptr), framesDrawn(0) {}
+
+bool FrameScheduler::play(Effect& effect) {
+    if (count == EFFECT_QUEUE_CAPACITY) return false;
+    queue[(head + count) % EFFECT_QUEUE_CAPACITY] = &effect;
+    ++count;
+    return true;
+}
+
+void FrameScheduler::stop() {
+    if (current != nullptr) current->cancel();
+    current = nullptr;
+    count = 0;
+}
+
+bool FrameScheduler::tick(uint32_t nowMs) {
+    if (current == nullptr) {
+        if (count == 0) return false;
+        current = queue[head];
+        head = (head + 1) % EFFECT_QUEUE_CAPACITY;
+        --count;
+        current->start(nowMs);
+    }
+    bool drawn = current->tick(nowMs);
+    if (!current->isRunning()) current = nullptr;  // The next effect starts on the next tick
+    if (drawn) ++framesDrawn;
+    return drawn;
+}
+
+uint32_t FrameScheduler::msUntilNextFrame(uint32_t nowMs) const {
+    if (current == nullptr) return count > 0 ? 0 : Idle;
+    int32_t waitMs = static_cast<int32_t>(current->getNextFrameMs() - nowMs);
+    return waitMs > 0 ? static_cast<uint32_t>(waitMs) : 0;
+}
+
+uint32_t FlickerEffect::render(uint32_t frame, uint32_t) {
+    if (frame >= 20) return Stop;
+    if (frame == 0) display.clearDisplay();
+    bool inverted = frame % 2 == 0;
+    display.invertDisplay(inverted);
+    return inverted ? 50 : 30;
+}
+
+void TvNoiseEffect::reset() {
+    rng.seed(random(1, 0x7FFFFFFF));
+}
+
+uint32_t TvNoiseEffect::render(uint32_t frame, uint32_t elapsedMs) {
+    if (elapsedMs >= durationMs) return Stop;
+    if (blankMs > 0 && frame % 2 == 1) {
+        display.clearDisplay();
+        return blankMs;
+    }
+    packedFrame().random(PackedFrame::Op::Set, 128, rng);  // Half the pixels lit
+    return frameMs;
+}
+
+void FadeOutEffect::reset() {
+    rng.seed(random(1, 0x7FFFFFFF));
+}
+
+uint32_t FadeOutEffect::render(uint32_t frame, uint32_t) {
+    const uint32_t steps = 16;
+    if (frame > steps) return Stop;
+    if (frame == steps) {
+        display.clearDisplay();  // Ensure the display is completely clear at the end
+        return 0;
+    }
+    packedFrame().random(PackedFrame::Op::And, 128, rng);  // Randomly clear bits
+    return 50;
+}
+
+uint32_t ScanLinesEffect::render(uint32_t frame, uint32_t) {
+    const uint32_t linesPerPass = (height + 3) / 4;
+    if (frame >= 3 * linesPerPass) return Stop;
+    display.clearDisplay();
+    display.drawFastHLine(0, (frame % linesPerPass) * 4, width, SSD1306_WHITE);
+    return 10;
+}
+
+uint32_t SweepEffect::render(uint32_t frame, uint32_t) {
+    const uint32_t lines = (height + 1) / 2;
+    if (frame >= lines) return Stop;
+    if (frame == 0) display.clearDisplay();
+    display.drawFastHLine(0, frame * 2, width, SSD1306_WHITE);
+    return frame + 1 == lines ? 10 + 200 : 10;  // Hold the full screen briefly
+}
+
+uint32_t GeometricShapesEffect::render(uint32_t frame, uint32_t) {
+    if (frame >= 30) return Stop;
+    display.clearDisplay();
+    int x = random(width);
+    int y = random(height);
+    int size = random(10, 30);
+
+    switch (random(3)) {
+        case 0:
+            display.drawCircle(x, y, size/2, SSD1306_WHITE);
+            break;
+        case 1:
+            display.drawRect(x, y, size, size, SSD1306_WHITE);
+            break;
+        case 2:
+            display.drawTriangle(x, y, x + size, y, x + size/2, y - size, SSD1306_WHITE);
+            break;
+    }
+    return 100;
+}
+
+static const char* const bootText = "BOOTING...";
+
+void TextEmergenceEffect::reset() {
+    int16_t x1, y1;
+    uint16_t w, h;
+    display.setTextSize(2);
+    display.getTextBounds(bootText, 0, 0, &x1, &y1, &w, &h);
+    x = (width - w) / 2;
+    y = (height - h) / 2;
+}
+
+uint32_t TextEmergenceEffect::render(uint32_t frame, uint32_t) {
+    uint32_t length = strlen(bootText);
+    if (frame >= length) return Stop;
+
+    // Black text on a white screen, one more letter each frame
+    display.fillScreen(SSD1306_WHITE);
+    display.setTextSize(2);
+    display.setTextColor(SSD1306_BLACK);
+    display.setCursor(x, y);
+    for (uint32_t j = 0; j <= frame; j++) {
+        display.print(bootText[j]);
+    }
+    display.setTextColor(SSD1306_WHITE);
+    return frame + 1 == length ? 200 + 1000 : 200;  // Keep the final text on screen for a moment
+}
+
+void MatrixEffect::reset() {
+    for (int i = 0; i < NumDrops; i++) {
+        drops[i] = random(-20, 0);
+    }
+}
+
+uint32_t MatrixEffect::render(uint32_t frame, uint32_t) {
+    if (frame >= 100) return Stop;
+    display.clearDisplay();
+    for (int i = 0; i < NumDrops; i++) {
+        display.drawLine(i * (width / NumDrops), drops[i], i * (width / NumDrops), drops[i] + 20, SSD1306_WHITE);
+        drops[i]++;
+        if (drops[i] > height) {
+            drops[i] = random(-20, 0);
+        }
+    }
+    return 50;
+}
+
+void SpiralEffect::reset() {
+    angle = 0;
+    radius = 0;
+}
+
+uint32_t SpiralEffect::render(uint32_t frame, uint32_t) {
+    if (frame >= 100) return Stop;
+    int x = width / 2 + cos(angle) * radius;
+    int y = height / 2 + sin(angle) * radius;
+    display.drawPixel(x, y, SSD1306_WHITE);
+    angle += 0.5;
+    radius += 0.2;
+    if (radius > width / 2) {
+        radius = 0;
+        display.clearDisplay();
+    }
+    return 20;
+}
+
+void BounceEffect::reset() {
+    x = random(width);
+    y = random(height);
+    dx = 2;
+    dy = 2;
+}
+
+uint32_t BounceEffect::render(uint32_t frame, uint32_t) {
+    const int size = 5;
+    if (frame >= 200) return Stop;
+    display.clearDisplay();
+    display.fillRect(x, y, size, size, SSD1306_WHITE);
+
+    x += dx;
+    y += dy;
+
+    if (x <= 0 || x >= width - size) dx = -dx;
+    if (y <= 0 || y >= height - size) dy = -dy;
+    return 20;
+}
+
+uint32_t WaveEffect::render(uint32_t frame, uint32_t) {
+    if (frame >= 100) return Stop;
+    display.clearDisplay();
+    for (int x = 0; x < width; x++) {
+        int y = height / 2 + sin((x + frame) * 0.2) * 20;
+        display.drawPixel(x, y, SSD1306_WHITE);
+    }
+    return 50;
+}
+
+void StarfieldEffect::reset() {
+    for (int i = 0; i < NumStars; i++) {
+        starX[i] = random(width);
+        starY[i] = vertical ? random(-height, 0) : random(height);  // Vertical stars start above the screen
+        starSpeed[i] = random(1, 5);
+    }
+}
+
+uint32_t StarfieldEffect::render(uint32_t frame, uint32_t) {
+    if (frame >= 200) return Stop;
+    display.clearDisplay();
+    for (int i = 0; i < NumStars; i++) {
+        display.drawPixel(starX[i], starY[i], SSD1306_WHITE);
+        if (vertical) {
+            // Move star downwards and restart it at the top once off screen
+            starY[i] += starSpeed[i];
+            if (starY[i] >= height) {
+                starY[i] = 0;
+                starX[i] = random(width);
+                starSpeed[i] = random(1, 5);
+            }
+        } else {
+            starX[i] -= starSpeed[i];
+            if (starX[i] < 0) {
+                starX[i] = width;
+                starY[i] = random(height);
+                starSpeed[i] = random(1, 5);
+            }
+        }
+    }
+    return 20;
+}
+
+uint32_t FractalEffect::render(uint32_t frame, uint32_t) {
+    const int columnsPerFrame = 4;
+    const int maxIterations = 30;
+    int first = frame * columnsPerFrame;
+    if (first >= width) return Stop;
+
+    const float xMin = julia ? -1.5 : -2.0, xMax = julia ? 1.5 : 1.0;
+    const float yMin = julia ? -1.5 : -1.0, yMax = julia ? 1.5 : 1.0;
+    const float cx = -0.7, cy = 0.27;  // Julia set parameters
+
+    for (int px = first; px < first + columnsPerFrame && px < width; px++) {
+        for (int py = 0; py < height; py++) {
+            float x = xMin + (xMax - xMin) * px / width;
+            float y = yMin + (yMax - yMin) * py / height;
+            bool inside = julia ? escapes(x, y, cx, cy, maxIterations) : escapes(0, 0, x, y, maxIterations);
+            if (inside) {
+                display.drawPixel(px, py, SSD1306_WHITE);
+            }
+        }
+    }
+    return first + columnsPerFrame >= width ? 3000 : 0;  // Show the final image for 3 seconds
+}
+
+bool FractalEffect::escapes(float x, float y, float cx, float cy, int maxIterations) {
+    int iteration = 0;
+    while (x*x + y*y <= 4 && iteration < maxIterations) {
+        float xtemp = x*x - y*y + cx;
+        y = 2*x*y + cy;
+        x = xtemp;
+        iteration++;
+    }
+    return iteration < maxIterations;
+}
+
+uint32_t LSystemTreeEffect::render(uint32_t frame, uint32_t) {
+    if (frame > 0) return Stop;
+    display.clearDisplay();
+    drawTree(width / 2, height - 1, 3 * QuarterTurn, 7);  // Straight up
+    return 3000;
+}
+
+void LSystemTreeEffect::drawTree(int x, int y, Angle angle, int depth) {
+    const Angle branch = angleFromRadians(M_PI / 5);
+    if (depth == 0) return;
+
+    int x2 = x + fixedToInt(cos16(angle) * depth * 7 / 2);
+    int y2 = y + fixedToInt(sin16(angle) * depth * 7 / 2);
+
+    display.drawLine(x, y, x2, y2, SSD1306_WHITE);
+
+    drawTree(x2, y2, angle - branch, depth - 1);
+    drawTree(x2, y2, angle + branch, depth - 1);
+}
+
+uint32_t PlasmaEffect::render(uint32_t frame, uint32_t) {
+    if (frame >= 200 || width > 128) return Stop;
+    // Time runs at 0.1 rad per frame; it stays unwrapped so that time / 3 is right too
+    const int32_t time = frame * AnglePerRadian / 10;
+
+    // v1 = sin(10x / w + t), v2 = sin(10 (x sin(t/2) + y cos(t/3)) / w); steps in Q8 angles
+    const int32_t step = 10 * AnglePerRadian * 256 / width;
+    const int32_t stepX = fixedMul(sin16(time / 2), step);
+    const int32_t stepY = fixedMul(cos16(time / 3), step);
+
+    // v3 = sin(d / 8), d from a centre orbiting by half the panel, offsets in Q8
+    const int32_t orbitX = fixedMul(sin16(time / 5), width * 128) - width / 2 * 256;
+    const int32_t orbitY = fixedMul(cos16(time / 3), height * 128) - height / 2 * 256;
+
+    PackedFrame target = packedFrame();
+    uint8_t colors[128];
+    for (int y = 0; y < height; y++) {
+        int32_t dy = y * 256 + orbitY;
+        uint32_t dySquared = dy * dy;
+        for (int x = 0; x < width; x++) {
+            int32_t dx = x * 256 + orbitX;
+            uint32_t d = isqrt(static_cast<uint32_t>(dx * dx) + dySquared);
+            Fixed16 v = sin16(((x * step) >> 8) + time) + sin16((x * stepX + y * stepY) >> 8) +
+                        sin16((d * AnglePerRadian) >> 11);
+            colors[x] = static_cast<uint8_t>((v + 3 * FixedOne) >> 10);  // (v + 3) * 64
+        }
+        target.thresholdRow(y, colors, 127);
+    }
+    return 20;
+}
+
+void ParticleSystemEffect::reset() {
+    for (int i = 0; i < NumParticles; i++) {
+        particles[i][0] = random(width);   // x
+        particles[i][1] = random(height);  // y
+        particles[i][2] = random(-10, 10) / 10.0;  // dx
+        particles[i][3] = random(-10, 10) / 10.0;  // dy
+    }
+}
+
+uint32_t ParticleSystemEffect::render(uint32_t frame, uint32_t) {
+    if (frame >= 300) return Stop;
+    display.clearDisplay();
+    for (int i = 0; i < NumParticles; i++) {
+        // Update position
+        particles[i][0] += particles[i][2];
+        particles[i][1] += particles[i][3];
+
+        // Bounce off edges
+        if (particles[i][0] < 0 || particles[i][0] >= width) particles[i][2] *= -1;
+        if (particles[i][1] < 0 || particles[i][1] >= height) particles[i][3] *= -1;
+
+        display.drawPixel(particles[i][0], particles[i][1], SSD1306_WHITE);
+    }
+    return 20;
+}
+
+void GameOfLifeEffect::reset() {
+    // About as dense as width * height / 4 random picks: 1 - e^(-1/4) of the cells
+    rng.seed(random(1, 0x7FFFFFFF));
+    life.randomize(57, rng);
+}
+
+uint32_t GameOfLifeEffect::render(uint32_t frame, uint32_t) {
+    if (frame >= 100 || life.getWidth() != width) return Stop;  // Panel larger than the grid
+    // Draw the current generation, then compute the next one
+    packedFrame().fromRowMajor(life.getBits(), life.getRowBytes());
+    life.step();
+    return 100;
+}
+
+void VortexEffect::reset() {
+    for (int i = 0; i < NumParticles; i++) {
+        respawn(particles[i]);
+    }
+}
+
+void VortexEffect::respawn(Particle& p) {
+    p.x = random(width) * FixedOne;
+    p.y = random(height) * FixedOne;
+    p.vx = 0;
+    p.vy = 0;
+    p.life = random(50, 200) * FixedOne / 100;
+}
+
+uint32_t VortexEffect::render(uint32_t frame, uint32_t) {
+    if (frame >= 300) return Stop;
+    const Fixed16 centerX = width * FixedOne / 2;
+    const Fixed16 centerY = height * FixedOne / 2;
+
+    // Time advances 0.1 per frame and the swirl follows sin(time * 0.1)
+    const Fixed16 swirl = fixedMul(sin16(frame * AnglePerRadian / 100), toFixed16(0.05));
+    display.clearDisplay();
+
+    for (int i = 0; i < NumParticles; i++) {
+        Particle& p = particles[i];
+
+        // Direction to center, in Q8 so that the squares fit 32 bits
+        int32_t dx = (centerX - p.x) >> 8;
+        int32_t dy = (centerY - p.y) >> 8;
+        int32_t distance = isqrt(static_cast<uint32_t>(dx * dx + dy * dy));
+
+        // Normalized force towards center, plus the swirl
+        if (distance > 0) {
+            p.vx += dx * toFixed16(0.1) / distance;
+            p.vy += dy * toFixed16(0.1) / distance;
+        }
+        p.vx -= fixedMul(dy << 8, swirl);
+        p.vy += fixedMul(dx << 8, swirl);
+
+        // Apply drag
+        p.vx = fixedMul(p.vx, toFixed16(0.95));
+        p.vy = fixedMul(p.vy, toFixed16(0.95));
+
+        // Update position
+        p.x += p.vx;
+        p.y += p.vy;
+
+        // Decrease life and reset if necessary
+        p.life -= toFixed16(0.01);
+        if (p.life <= 0 || p.x < 0 || p.x >= width * FixedOne || p.y < 0 || p.y >= height * FixedOne) {
+            respawn(p);
+        }
+
+        uint8_t brightness = static_cast<uint8_t>((p.life * 255) >> 16);
+        display.drawPixel(p.x >> 16, p.y >> 16, brightness > 127 ? SSD1306_WHITE : SSD1306_BLACK);
+    }
+    return 20;
+}
+
+void RainEffect::reset() {
+    for (int i = 0; i < NumRaindrops; i++) {
+        raindrops[i].x = random(width);
+        raindrops[i].y = random(-50, -10);
+        raindrops[i].speed = random(1, 3);
+        raindrops[i].size = random(1, 3);
+    }
+    rippleCount = 0;
+}
+
+uint32_t RainEffect::render(uint32_t frame, uint32_t) {
+    if (frame >= 300) return Stop;
+    display.clearDisplay();
+
+    for (int i = 0; i < NumRaindrops; i++) {
+        raindrops[i].y += raindrops[i].speed;
+        display.drawFastVLine(raindrops[i].x, raindrops[i].y, raindrops[i].size, SSD1306_WHITE);
+
+        // Create ripple when raindrop hits bottom
+        if (raindrops[i].y >= height) {
+            if (rippleCount < MaxRipples) {
+                ripples[rippleCount].x = raindrops[i].x;
+                ripples[rippleCount].y = height - 1;
+                ripples[rippleCount].size = 1;
+                ripples[rippleCount].life = 15;
+                rippleCount++;
+            }
+            raindrops[i].x = random(width);
+            raindrops[i].y = random(-50, -10);
+        }
+    }
+
+    for (int i = 0; i < rippleCount; i++) {
+        if (ripples[i].life > 0) {
+            display.drawCircle(ripples[i].x, ripples[i].y, ripples[i].size, SSD1306_WHITE);
+            ripples[i].size++;
+            ripples[i].life--;
+        }
+    }
+
+    // Remove dead ripples
+    for (int i = 0; i < rippleCount; i++) {
+        if (ripples[i].life <= 0) {
+            ripples[i] = ripples[rippleCount - 1];
+            rippleCount--;
+            i--;
+        }
+    }
+    return 30;
+}
+
+int DynamicWaveEffect::waveAt(int x, int32_t time) const {
+    // 0.02, 0.03 and 0.05 rad per column, as Q8 angles
+    static const int32_t frequencies[NumWaves] = {53402, 80103, 133505};
+
+    Fixed16 y = height / 2 * FixedOne;  // Center line
+    for (int i = 0; i < NumWaves; i++) {
+        y += fixedMul(sin16(((x * frequencies[i]) >> 8) + time), amplitudes[i]);
+    }
+    return y >> 16;
+}
+
+uint32_t DynamicWaveEffect::render(uint32_t frame, uint32_t) {
+    static const Fixed16 baseAmplitudes[NumWaves] = {10 * FixedOne, 7 * FixedOne, 5 * FixedOne};
+    static const Angle phaseShifts[NumWaves] = {0, angleFromRadians(M_PI / 3), angleFromRadians(2 * M_PI / 3)};
+    if (frame >= 300) return Stop;
+
+    // Time runs at 0.1 rad per frame; amplitudes swell with sin(time * 0.1)
+    const int32_t time = frame * AnglePerRadian / 10;
+    const Angle slow = time / 10;
+    for (int i = 0; i < NumWaves; i++) {
+        amplitudes[i] = fixedMul(baseAmplitudes[i] + 2 * sin16(slow), sin16(slow + phaseShifts[i]));
+    }
+    display.clearDisplay();
+
+    // The composite wave, its points joined by lines for a smoother appearance
+    int previous = waveAt(0, time);
+    display.drawPixel(0, previous, SSD1306_WHITE);
+    for (int x = 1; x < width; x++) {
+        int y = waveAt(x, time);
+        display.drawLine(x - 1, previous, x, y, SSD1306_WHITE);
+        previous = y;
+    }
+    return 30;
+}
+
+void CyberGridEffect::reset() {
+    for (int i = 0; i < NumEnergyLines; i++) {
+        energyLines[i].vertical = random(2) == 0;
+        if (energyLines[i].vertical) {
+            energyLines[i].x = random(width / GridSize) * GridSize;
+            energyLines[i].y = -GridSize;
+        } else {
+            energyLines[i].x = -GridSize;
+            energyLines[i].y = random(height / GridSize) * GridSize;
+        }
+        energyLines[i].length = random(2, 4) * GridSize;
+        energyLines[i].speed = random(1, 3);
+    }
+}
+
+uint32_t CyberGridEffect::render(uint32_t frame, uint32_t) {
+    if (frame >= 300) return Stop;
+    display.clearDisplay();
+
+    // Draw faint grid
+    for (int x = 0; x < width; x += GridSize) {
+        display.drawFastVLine(x, 0, height, SSD1306_WHITE);
+    }
+    for (int y = 0; y < height; y += GridSize) {
+        display.drawFastHLine(0, y, width, SSD1306_WHITE);
+    }
+
+    // Update and draw energy lines
+    for (int i = 0; i < NumEnergyLines; i++) {
+        EnergyLine& line = energyLines[i];
+        for (int j = 0; j < line.length; j++) {
+            int brightness = 255 - (j * 255 / line.length);
+            uint16_t color = brightness > 127 ? SSD1306_WHITE : SSD1306_BLACK;
+            if (line.vertical) {
+                display.drawPixel(line.x, line.y + j, color);
+            } else {
+                display.drawPixel(line.x + j, line.y, color);
+            }
+        }
+        if (line.vertical) {
+            line.y += line.speed;
+            if (line.y > height) {
+                line.y = -line.length;
+                line.x = random(width / GridSize) * GridSize;
+            }
+        } else {
+            line.x += line.speed;
+            if (line.x > width) {
+                line.x = -line.length;
+                line.y = random(height / GridSize) * GridSize;
+            }
+        }
+    }
+
+    // Add subtle pulsating effect to grid intersections
+    // On while (sin(frame * 0.1 + (x + y) * 0.2) + 1) * 63 > 31
+    const Fixed16 threshold = toFixed16(32.0 / 63 - 1);
+    for (int x = 0; x < width; x += GridSize) {
+        for (int y = 0; y < height; y += GridSize) {
+            Angle angle = frame * AnglePerRadian / 10 + (x + y) * AnglePerRadian / 5;
+            display.drawPixel(x, y, sin16(angle) >= threshold ? SSD1306_WHITE : SSD1306_BLACK);
+        }
+    }
+    return 30;
+}
+
+void WarpStarfieldEffect::reset() {
+    for (int i = 0; i < NumStars; i++) {
+        stars[i][0] = rand() % width;   // x position
+        stars[i][1] = rand() % height;  // y position
+        stars[i][2] = rand() % 4 + 1;   // brightness (1-4)
+    }
+    z = 0;
+}
+
+uint32_t WarpStarfieldEffect::render(uint32_t frame, uint32_t) {
+    if (frame >= 300) return Stop;
+    display.clearDisplay();
+
+    for (int i = 0; i < NumStars; i++) {
+        // Project the star for the current depth
+        int nx = (stars[i][0] - width / 2) * (1.0 / (z + 0.1)) + width / 2;
+        int ny = (stars[i][1] - height / 2) * (1.0 / (z + 0.1)) + height / 2;
+        if (stars[i][2] > 0 && nx >= 0 && nx < width && ny >= 0 && ny < height) {
+            display.drawPixel(nx, ny, SSD1306_WHITE);
+        }
+
+        // Randomly reset star position and brightness to simulate new stars
+        if (rand() % 100 < 2) {
+            stars[i][0] = rand() % width;
+            stars[i][1] = rand() % height;
+            stars[i][2] = rand() % 4 + 1;
+        }
+    }
+
+    z += 0.1;  // Move stars forward
+    if (z > 5.0) {
+        z = 0;
+    }
+    return 20;
+}
+
+void ParticleExplosionEffect::reset() {
+    // All particles start at the center with random velocities and lifetimes (20 to 70 frames)
+    for (int i = 0; i < NumParticles; i++) {
+        particles[i].x = width / 2;
+        particles[i].y = height / 2;
+        particles[i].vx = (rand() % 100 - 50) / 10.0;
+        particles[i].vy = (rand() % 100 - 50) / 10.0;
+        particles[i].lifetime = rand() % 50 + 20;
+    }
+}
+
+uint32_t ParticleExplosionEffect::render(uint32_t frame, uint32_t) {
+    if (frame >= 300) return Stop;
+    display.clearDisplay();
+
+    bool allExpired = true;
+    for (int i = 0; i < NumParticles; i++) {
+        Particle& p = particles[i];
+        if (p.lifetime > 0) {
+            p.x += p.vx;
+            p.y += p.vy;
+            p.lifetime--;
+            if (p.x >= 0 && p.x < width && p.y >= 0 && p.y < height) {
+                display.drawPixel(p.x, p.y, SSD1306_WHITE);
+            }
+        }
+        if (p.lifetime > 0) allExpired = false;
+    }
+
+    if (allExpired) reset();
+    return 20;
+}
+
+void MarbleDropEffect::reset() {
+    for (int i = 0; i < NumMarbles; i++) {
+        marbles[i].radius = random(2, 4);
+        drop(marbles[i]);
+    }
+}
+
+void MarbleDropEffect::drop(Marble& marble) {
+    marble.x = random(width);
+    marble.y = random(-50, -10);
+    marble.vy = 0;
+    marble.active = true;
+}
+
+uint32_t MarbleDropEffect::render(uint32_t frame, uint32_t) {
+    const float dt = 0.5;  // Time step for physics simulation
+    if (frame >= 500) return Stop;
+    display.clearDisplay();
+
+    // Draw floor
+    display.drawFastHLine(0, height - 1, width, SSD1306_WHITE);
+
+    bool allStopped = true;
+    for (int i = 0; i < NumMarbles; i++) {
+        if (marbles[i].active) {
+            update(marbles[i], dt);
+            display.fillCircle(marbles[i].x, marbles[i].y, marbles[i].radius, SSD1306_WHITE);
+        }
+        if (marbles[i].active) allStopped = false;
+    }
+
+    if (allStopped) {
+        // Wait a moment, then drop them again
+        for (int i = 0; i < NumMarbles; i++) {
+            drop(marbles[i]);
+        }
+        return 20 + 1000;
+    }
+    return 20;
+}
+
+void MarbleDropEffect::update(Marble& marble, float dt) {
+    const float floorY = height - 1 - marble.radius;
+    const float gravity = 0.2;
+    const float bounceDamping = 0.8;
+    const float stopVelocity = 0.5;
+
+    marble.vy += gravity * dt;
+    marble.y += marble.vy * dt;
+
+    // Bounce off the floor with damping, until the bounce is too small
+    if (marble.y > floorY) {
+        marble.y = floorY;
+        marble.vy = -marble.vy * bounceDamping;
+        if (abs(marble.vy) < stopVelocity) {
+            marble.vy = 0;
+            marble.active = false;
+        }
+    }
+}
+
+void FallingLettersEffect::reset() {
+    static const char* const messages[] = {
+        "TrafficLight",
+        "Designing Emotions",
+        "Centurion",
+        "CENTURION",
+        "Mater Fatima"
+    };
+    const int letterWidth = 8;    // Width of each letter (including spacing)
+    const int letterHeight = 10;  // Height of each letter
+    const float floorY = height - 30;  // Leave some space at the bottom
+
+    const char* message = messages[random(0, 5)];
+    letterCount = static_cast<uint8_t>(strnlen(message, MaxLetters));
+    int startX = (width - letterCount * letterWidth) / 2;  // Centered
+
+    for (uint8_t i = 0; i < letterCount; i++) {
+        FallingLetter& letter = letters[i];
+        letter.letter = message[i];
+        letter.x = startX + i * letterWidth;
+        letter.y = random(-50, -10);
+        letter.vy = 0;
+        letter.settled = false;
+        letter.targetY = floorY - letterHeight;
+    }
+    finished = false;
+}
+
+uint32_t FallingLettersEffect::render(uint32_t, uint32_t elapsedMs) {
+    if (finished || elapsedMs >= 20000) return Stop;  // Run for 20 seconds max
+    display.clearDisplay();
+
+    bool allSettled = true;
+    for (uint8_t i = 0; i < letterCount; i++) {
+        if (!letters[i].settled) {
+            update(letters[i]);
+            allSettled = false;
+        }
+    }
+
+    display.setTextSize(1);
+    display.setTextColor(SSD1306_WHITE);
+    for (uint8_t i = 0; i < letterCount; i++) {
+        display.setCursor(letters[i].x, letters[i].y);
+        display.print(letters[i].letter);
+    }
+
+    // Once every letter has settled, hold the message for 3 seconds
+    if (allSettled) {
+        finished = true;
+        return 20 + 3000;
+    }
+    return 20;
+}
+
+void FallingLettersEffect::update(FallingLetter& letter) {
+    const float gravity = 0.2;
+    const float bounceDamping = 0.7;
+    const float stopVelocity = 0.5;
+    const float dt = 0.5;
+
+    letter.vy += gravity * dt;
+    letter.y += letter.vy * dt;
+
+    if (letter.y > letter.targetY) {
+        letter.y = letter.targetY;
+        letter.vy = -letter.vy * bounceDamping;
+        if (abs(letter.vy) < stopVelocity) {
+            letter.vy = 0;
+            letter.settled = true;
+        }
+    }
+}
@@ -0,0 +1,75 @@
+// EventDispatcher.cpp
+#include "EventDispatcher.h"
+
+EventDispatcher::EventDispatcher() : subscribers() {}
+
+int EventDispatcher::subscribe(Handler handler, void* context, EventFilter filter, const char* name) {
+    if (handler == nullptr) return -1;
+    for (int id = 0; id < EVENT_SUBSCRIBER_CAPACITY; id++) {
+        Subscriber& slot = subscribers[id];
+        if (slot.handler != nullptr) continue;
+        slot.context = context;
+        slot.filter = filter;
+        slot.stats = Stats{name ? name : "", 0, 0, 0};
+        slot.handler = handler;
+        return id;
+    }
+    return -1;
+}
+
+bool EventDispatcher::unsubscribe(int id) {
+    if (id < 0 || id >= EVENT_SUBSCRIBER_CAPACITY || subscribers[id].handler == nullptr) return false;
+    subscribers[id].handler = nullptr;
+    return true;
+}
+
+void EventDispatcher::dispatch(const ScheduledEvent& event) {
+    for (Subscriber& slot : subscribers) {
+        if (slot.handler == nullptr || !slot.filter.matches(event)) continue;
+
+        unsigned long start = micros();
+        slot.handler(event, slot.context);
+        uint32_t elapsed = micros() - start;
+
+        ++slot.stats.calls;
+        slot.stats.totalUs += elapsed;
+        if (elapsed > slot.stats.maxUs) slot.stats.maxUs = elapsed;
+    }
+}
+
+bool EventDispatcher::getStats(int id, Stats& stats) const {
+    if (id < 0 || id >= EVENT_SUBSCRIBER_CAPACITY || subscribers[id].handler == nullptr) return false;
+    stats = subscribers[id].stats;
+    return true;
+}
+
+int EventDispatcher::slowestSubscriber() const {
+    int slowest = -1;
+    for (int id = 0; id < EVENT_SUBSCRIBER_CAPACITY; id++) {
+        const Subscriber& slot = subscribers[id];
+        if (slot.handler == nullptr || slot.stats.calls == 0) continue;
+        if (slowest < 0 || slot.stats.maxUs > subscribers[slowest].stats.maxUs) slowest = id;
+    }
+    return slowest;
+}
+
+void EventDispatcher::resetStats() {
+    for (Subscriber& slot : subscribers) {
+        slot.stats.calls = 0;
+        slot.stats.totalUs = 0;
+        slot.stats.maxUs = 0;
+    }
+}
+
+void EventDispatcher::printStats() const {
+    Serial.println(F("Event subscribers:"));
+    for (int id = 0; id < EVENT_SUBSCRIBER_CAPACITY; id++) {
+        const Subscriber& slot = subscribers[id];
+        if (slot.handler == nullptr) continue;
+        const Stats& stats = slot.stats;
+        Serial.printf("%d %s - Calls: %u, Avg: %u us, Max: %u us\n", id, stats.name,
+                      static_cast<unsigned>(stats.calls),
+                      static_cast<unsigned>(stats.calls ? stats.totalUs / stats.calls : 0),
+                      static_cast<unsigned>(stats.maxUs));
+    }
+}
@@ -1,93 +1,665 @@
 // EventManager.cpp
 #include "EventManager.h"
 
-EventManager::EventManager(RTC_DS3231& rtc)
-    : rtc(rtc), currentScenario(0), currentCycle(0), isProcessingEvents(false), lastProcessTime(0) {}
+EventManager::EventManager(TimeService& clock)
+    : image(nullptr), imageCursor(0), imageMaskCount(0), preciseCount(0), rules(), deferredRules(0), clock(clock), currentScenario(0), currentCycle(0), isProcessingEvents(false), lastProcessTime(0),
+      deadlineTimer(nullptr), deadlineDirty(false), editHandler(nullptr), editContext(nullptr), drainPolicy(DrainPolicy::All), drainLimit(1),
+      discardPending(false), catchUpPolicies(), fireAllScenarios(0), catchUpWindow(EVENT_CATCH_UP_WINDOW),
+      catchUpCutoff(NoTimeCode), catchUpEffective(NoTimeCode), backlog(false), droppedMissed(0), labelFailures(0)
+#if defined(ESP32)
+      , dispatchTask(nullptr)
+#endif
+{}
 
 void EventManager::begin() {
     // Initialization code if needed
 }
 
 bool EventManager::addEvent(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second, 
-                            uint8_t scenario, uint8_t cycle, const String& description, bool isDaily) {
+                            uint8_t scenario, uint8_t cycle, const char* description, bool isDaily) {
+    scheduleChanged();
     if (isDaily) {
-        addDailyEvent(hour, minute, second, scenario, cycle, description);
-        return true;
+        if (hour >= 24 || minute >= 60 || second >= 60) {
+            Serial.println(F("Invalid date or time"));
+            return false;
+        }
+        return addRule(RecurrenceRule::daily(hour, minute, second), scenario, cycle, description) >= 0;
     }
 
     if (!isValidDate(year, month, day) || hour >= 24 || minute >= 60 || second >= 60) {
         Serial.println(F("Invalid date or time"));
         return false;
     }
-    events.emplace(year, month, day, hour, minute, second, scenario, cycle, description, isDaily);
+    if (events.full()) {
+        Serial.println(F("Event store full"));
+        return false;
+    }
+    Event event(year, month, day, hour, minute, second, scenario, cycle);
+    if (!event.setDescription(description)) {
+        Serial.println(F("Label table full"));
+        return false;
+    }
+    if (!insertEvent(event)) return false;
+    notify(EditKind::EventAdded, event.timeCode, scenario, cycle, 0, 0, nullptr, event.description());
     return true;
 }
 
-void EventManager::addDailyEvent(uint8_t hour, uint8_t minute, uint8_t second, 
-                                 uint8_t scenario, uint8_t cycle, const String& description) {
-    DateTime now = rtc.now();
-    DateTime eventTime(now.year(), now.month(), now.day(), hour, minute, second);
-    
-    if (eventTime < now) {
-        eventTime = eventTime + TimeSpan(1, 0, 0, 0);  // Move to next day if the time has passed for today
+// Validates and stores a whole plan in one pass and sorts the schedule once
+// (EventStore::insertBatch) instead of inserting event by event. Rejected entries are
+// reported instead of printed. Call clearEvents() first to replace the current plan.
+EventManager::BatchReport EventManager::addEvents(const EventSpec* specs, size_t count) {
+    scheduleChanged();
+    BatchReport report = {};
+    auto reject = [&report](size_t index, BatchProblem problem, TimeCode timeCode) {
+        ++report.rejected;
+        if (report.issueCount < EVENT_BATCH_ISSUE_CAPACITY) {
+            report.issues[report.issueCount++] = BatchIssue{static_cast<uint32_t>(index), problem, timeCode};
+        }
+    };
+
+    Event event;
+    report.accepted = events.insertBatch(count, [&](size_t i) -> const Event* {
+        const EventSpec& spec = specs[i];
+        if (spec.isDaily) return nullptr;  // Rules are added below, once the batch is sorted
+        if (!isValidDate(spec.year, spec.month, spec.day) || spec.hour >= 24 || spec.minute >= 60 ||
+            spec.second >= 60) {
+            reject(i, BatchProblem::InvalidTime, 0);
+            return nullptr;
+        }
+        event = Event(spec.year, spec.month, spec.day, spec.hour, spec.minute, spec.second, spec.scenario,
+                      spec.cycle);
+        if (!event.setDescription(spec.description)) {
+            reject(i, BatchProblem::LabelsFull, event.timeCode);
+            return nullptr;
+        }
+        if (imageHas(event.timeCode)) {
+            reject(i, BatchProblem::TimeTaken, event.timeCode);
+            return nullptr;
+        }
+        return &event;
+    }, [&](size_t i, Schedule::BatchReject reason) {
+        reject(i, reason == Schedule::BatchReject::Taken ? BatchProblem::TimeTaken : BatchProblem::StoreFull,
+               event.timeCode);
+    }, [&](size_t, const Event& stored) {
+        notify(EditKind::EventAdded, stored.timeCode, stored.scenario, stored.cycle, 0, 0, nullptr,
+               stored.description());
+    });
+
+    for (size_t i = 0; i < count; i++) {
+        const EventSpec& spec = specs[i];
+        if (!spec.isDaily) continue;
+        if (spec.hour >= 24 || spec.minute >= 60 || spec.second >= 60) {
+            reject(i, BatchProblem::InvalidTime, 0);
+        } else if (addRule(RecurrenceRule::daily(spec.hour, spec.minute, spec.second), spec.scenario, spec.cycle,
+                           spec.description) < 0) {
+            reject(i, BatchProblem::RuleRejected, 0);
+        } else {
+            ++report.accepted;
+        }
+    }
+    return report;
+}
+
+bool EventManager::addPreciseEvent(PreciseTimeCode atMs, uint8_t scenario, uint8_t cycle, const char* description) {
+    deadlineDirty = true;
+    if (preciseCount == EVENT_PRECISE_CAPACITY) {
+        Serial.println(F("Precise event queue full"));
+        return false;
+    }
+    Event event;
+    event.timeCode = static_cast<TimeCode>(atMs / 1000);
+    event.millisecond = static_cast<uint16_t>(atMs % 1000);
+    event.scenario = scenario;
+    event.cycle = cycle;
+    event.rule = Event::NoRule;
+    if (!event.setDescription(description)) {
+        Serial.println(F("Label table full"));
+        return false;
     }
 
-    events.emplace(eventTime.year(), eventTime.month(), eventTime.day(), 
-                   hour, minute, second, scenario, cycle, description, true);
+    // After every event at or before atMs, so equal times keep the order they were added in
+    uint8_t position = preciseCount;
+    while (position > 0 && preciseEvents[position - 1].preciseTime() > atMs) {
+        preciseEvents[position] = preciseEvents[position - 1];
+        --position;
+    }
+    preciseEvents[position] = event;
+    ++preciseCount;
+    return true;
+}
+
+bool EventManager::addEventAfter(uint32_t delayMs, uint8_t scenario, uint8_t cycle, const char* description) {
+    return addPreciseEvent(clock.nowMs() + delayMs, scenario, cycle, description);
 }
 
-bool EventManager::removeEvent(uint64_t timeCode) {
-    for (auto it = events.begin(); it != events.end(); ++it) {
-        if (it->timeCode == timeCode) {
-            events.erase(it);
-            return true;
+size_t EventManager::cancelPreciseEvents(uint8_t scenario) {
+    deadlineDirty = true;
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < preciseCount; i++) {
+        if (preciseEvents[i].scenario != scenario) preciseEvents[kept++] = preciseEvents[i];
+    }
+    size_t cancelled = preciseCount - kept;
+    preciseCount = kept;
+    return cancelled;
+}
+
+// Stores the rule once and schedules only its next occurrence. Returns the rule id, or -1.
+int EventManager::addRule(const RecurrenceRule& rule, uint8_t scenario, uint8_t cycle, const char* description) {
+    deadlineDirty = true;
+    if (!rule.isValid()) {
+        Serial.println(F("Invalid recurrence rule"));
+        return -1;
+    }
+    if (events.full()) {
+        Serial.println(F("Event store full"));
+        return -1;
+    }
+
+    if (rule.firstAtOrAfter(clock.now()) == RecurrenceRule::Never) {
+        Serial.println(F("Recurrence rule has no future occurrence"));
+        return -1;
+    }
+
+    Event occurrence;
+    if (!occurrence.setDescription(description)) {
+        Serial.println(F("Label table full"));
+        return -1;
+    }
+
+    for (uint8_t id = 0; id < EVENT_RULE_CAPACITY; id++) {
+        if (rules[id].recurrence.weekdayMask != 0) continue;
+
+        rules[id] = RuleSlot{rule, scenario, cycle, occurrence.label, 0};
+
+        occurrence.scenario = scenario;
+        occurrence.cycle = cycle;
+        occurrence.rule = id;
+        scheduleOccurrence(occurrence, clock.now());  // If every candidate second is taken, a later pass retries
+        notify(EditKind::RuleAdded, 0, scenario, cycle, id, 0, &rules[id].recurrence, occurrence.description());
+        return id;
+    }
+
+    Serial.println(F("Rule table full"));
+    return -1;
+}
+
+bool EventManager::removeRule(uint8_t ruleId) {
+    scheduleChanged();
+    if (ruleId >= EVENT_RULE_CAPACITY || rules[ruleId].recurrence.weekdayMask == 0) return false;
+
+    for (const Event& event : events.scenarioEvents(rules[ruleId].scenario)) {
+        if (event.rule == ruleId) {
+            events.erase(event.timeCode);
+            break;
         }
     }
-    return false;
+    freeRule(ruleId);
+    notify(EditKind::RuleRemoved, 0, 0, 0, ruleId);
+    return true;
+}
+
+const RecurrenceRule* EventManager::getRule(uint8_t ruleId) const {
+    if (ruleId >= EVENT_RULE_CAPACITY || rules[ruleId].recurrence.weekdayMask == 0) return nullptr;
+    return &rules[ruleId].recurrence;
+}
+
+// Uses the schedule image in place. Its events before now count as already run, except
+// the latest one, which is replayed through catch-up; its
+// rules are copied into the rule table like addRule(). The image must stay mapped until
+// unloadImage() or clearEvents().
+bool EventManager::loadImage(const ScheduleImage& scheduleImage) {
+    scheduleChanged();
+    if (!scheduleImage.isOpen()) return false;
+
+    image = &scheduleImage;
+    EditHandler handler = editHandler;  // The image is configuration, not an edit
+    editHandler = nullptr;
+    imageCursor = image->lowerBound(clock.now());
+    imageMaskCount = 0;
+
+    // Start from the most recent past event, so catch-up restores the current scenario and cycle
+    for (uint32_t i = imageCursor; i > 0;) {
+        if (getCatchUpPolicy(image->event(--i).scenario) != CatchUpPolicy::Skip) {
+            imageCursor = i;
+            break;
+        }
+    }
+
+    bool complete = true;
+    for (uint32_t i = 0; i < image->ruleCount(); i++) {
+        const ImageRule& rule = image->rule(i);
+        if (addRule(rule.recurrence(), rule.scenario, rule.cycle, image->string(rule.description)) < 0) {
+            complete = false;
+        }
+    }
+    editHandler = handler;
+    return complete;
+}
+
+void EventManager::unloadImage() {
+    scheduleChanged();
+    image = nullptr;
+    imageMaskCount = 0;
+}
+
+bool EventManager::removeEvent(TimeCode timeCode) {
+    scheduleChanged();
+    const Event* event = events.find(timeCode);
+    if (event != nullptr) {
+        uint8_t ruleId = event->rule;
+        releaseRule(*event);  // Removing a recurring occurrence cancels its rule, as removing a daily event did
+        events.erase(timeCode);
+        if (ruleId != Event::NoRule) {
+            notify(EditKind::RuleRemoved, 0, 0, 0, ruleId);
+        } else {
+            notify(EditKind::EventRemoved, timeCode);
+        }
+        return true;
+    }
+
+    // The image is read-only, so remember the removal until the cursor passes it
+    if (!imageHas(timeCode)) return false;
+    if (imageMaskCount == EVENT_IMAGE_MASK_CAPACITY) {
+        Serial.println(F("Image removal list full"));
+        return false;
+    }
+    imageMasks[imageMaskCount++] = timeCode;
+    notify(EditKind::EventRemoved, timeCode);
+    return true;
+}
+
+bool EventManager::findEvent(TimeCode timeCode, Event& event) const {
+    if (const Event* stored = events.find(timeCode)) {
+        event = *stored;
+        return true;
+    }
+    if (!imageHas(timeCode)) return false;
+    image->materialize(image->lowerBound(timeCode), event);
+    return true;
+}
+
+EventManager::ScenarioRange EventManager::scenarioEvents(uint8_t scenario) const {
+    return events.scenarioEvents(scenario);
+}
+
+size_t EventManager::removeScenario(uint8_t scenario) {
+    scheduleChanged();
+    for (const Event& event : events.scenarioEvents(scenario)) {
+        releaseRule(event);
+    }
+    size_t removed = events.removeScenario(scenario);
+    notify(EditKind::ScenarioRemoved, 0, scenario);
+    return removed;
 }
 
+// Scenario queries and edits cover the RAM overlay (including recurring occurrences), not image events.
+
+// Shifts every event of a scenario by offsetSeconds. Events that would land on an
+// already occupied time are dropped; the return value counts the events kept.
+// Recurring events move only their pending occurrence and then follow their rule again.
+size_t EventManager::rescheduleScenario(uint8_t scenario, int32_t offsetSeconds) {
+    scheduleChanged();
+    size_t kept = events.rescheduleScenario(scenario, [offsetSeconds](const Event& event) {
+        int64_t moved = static_cast<int64_t>(event.timeCode) + offsetSeconds;
+        return static_cast<TimeCode>(moved < 0 ? 0 : moved);
+    }, [this](const Event& dropped) {
+        releaseRule(dropped);
+    });
+    notify(EditKind::ScenarioRescheduled, 0, scenario, 0, 0, offsetSeconds);
+    return kept;
+}
+
+// Empties the overlay and detaches the image.
 void EventManager::clearEvents() {
+    scheduleChanged();
     events.clear();
-    while (!pendingEvents.empty()) {
-        pendingEvents.pop();
+    image = nullptr;
+    imageMaskCount = 0;
+    preciseCount = 0;
+    if (hasInlinePending() || pendingEvents.empty()) {
+        pendingEvents.clear();  // This task is the consumer
+    } else {
+        discardPending = true;  // Let the dispatch task drop what it has not delivered yet
     }
+    for (RuleSlot& slot : rules) {
+        slot.recurrence.weekdayMask = 0;
+        slot.retryFrom = 0;
+    }
+    deferredRules = 0;
+    notify(EditKind::Cleared, 0);
 }
 
 void EventManager::update() {
-    unsigned long currentTime = millis();
-    if (currentTime - lastProcessTime >= 1000) {  // Check every second
-        lastProcessTime = currentTime;
-        
-        DateTime now = rtc.now();
-        uint64_t currentTimeCode = Event::encodeTime(now.year(), now.month(), now.day(), 
-                                                     now.hour(), now.minute(), now.second());
-        
-        auto nextEvent = findNextEvent(currentTimeCode);
-        
-        while (nextEvent != events.end() && currentTimeCode >= nextEvent->timeCode) {
-            pendingEvents.push(*nextEvent);
-            if (nextEvent->isDaily) {
-                rescheduleEvent(*nextEvent);
+    if (deadlineTimer != nullptr) {
+        // Deadline mode: only touch the schedule when the timer fired or the schedule changed
+        bool fired = deadlineTimer->consumeFired();
+        if (!fired && !deadlineDirty && !hasInlinePending()) return;
+
+        deadlineDirty = false;
+        collectDueEvents(clock.nowMs());
+        dispatchPendingEvents();
+        armDeadline();
+        return;
+    }
+
+    // Check once per second, on the second boundary, whenever a millisecond event is due and
+    // right away while due events are still waiting for room in the pending ring
+    PreciseTimeCode nowMs = clock.nowMs();
+    TimeCode currentTimeCode = static_cast<TimeCode>(nowMs / 1000);
+    if (currentTimeCode != lastProcessTime || backlog || isPreciseDue(nowMs)) {
+        lastProcessTime = currentTimeCode;
+        collectDueEvents(nowMs);
+        dispatchPendingEvents();
+    }
+}
+
+bool EventManager::isPreciseDue(PreciseTimeCode nowMs) const {
+    return preciseCount > 0 && preciseEvents[0].preciseTime() <= nowMs;
+}
+
+// Moves every event due at or before now into the pending ring, merging the image and
+// the overlay in time order. Due events stay where they are if the ring is full and are
+// picked up on the next pass. Events older than the catch-up window are missed and are
+// filtered by their scenario's CatchUpPolicy. The missed events are sized up once per
+// outage, against the cutoff at the first pass that saw them, and without FireAll
+// scenarios the image cursor and the overlay front both jump straight over them, so
+// recovery does not depend on how much was missed.
+// Millisecond events are merged in by their exact time and are never counted as missed.
+void EventManager::collectDueEvents(PreciseTimeCode nowMs) {
+    TimeCode now = static_cast<TimeCode>(nowMs / 1000);
+    TimeCode cutoff = catchUpCutoff;
+    if (cutoff == NoTimeCode) cutoff = now > catchUpWindow ? now - catchUpWindow : 0;
+
+    while (!pendingEvents.full()) {
+        const Event* stored = events.peek();
+        const ImageEvent* fromImage = nextImageEvent();
+        bool imageFirst = fromImage != nullptr && (stored == nullptr || fromImage->timeCode < stored->timeCode);
+        bool haveScheduled = imageFirst || stored != nullptr;
+        TimeCode due = imageFirst ? fromImage->timeCode : (stored != nullptr ? stored->timeCode : NoTimeCode);
+
+        if (isPreciseDue(nowMs) &&
+            (!haveScheduled || preciseEvents[0].preciseTime() < static_cast<PreciseTimeCode>(due) * 1000)) {
+            pendingEvents.push(preciseEvents[0]);
+            --preciseCount;
+            for (uint8_t i = 0; i < preciseCount; i++) preciseEvents[i] = preciseEvents[i + 1];
+            continue;
+        }
+        if (!haveScheduled || due >= cutoff) catchUpCutoff = NoTimeCode;  // Nothing missed is left
+        if (!haveScheduled || due > now) break;
+
+        if (due < cutoff) {
+            if (catchUpCutoff == NoTimeCode) {
+                catchUpCutoff = cutoff;
+                catchUpEffective = latestMissed(cutoff);
+            }
+            TimeCode effective = catchUpEffective;
+            TimeCode skipTo = effective != NoTimeCode && effective > due ? effective : cutoff;
+            uint8_t scenario = imageFirst ? fromImage->scenario : stored->scenario;
+            bool deliver = due == effective || getCatchUpPolicy(scenario) == CatchUpPolicy::FireAll;
+
+            if (imageFirst) {
+                if (deliver) {
+                    pushImageEvent(imageCursor);
+                } else {
+                    ++droppedMissed;
+                }
+                ++imageCursor;
+                if (!deliver && fireAllScenarios == 0) skipImageTo(image->lowerBound(skipTo));
+                continue;
+            }
+
+            if (!deliver && fireAllScenarios == 0) {
+                dropMissedBefore(skipTo, now);
+                continue;
+            }
+            Event missed = *stored;
+            events.popFront();
+            if (deliver) {
+                pendingEvents.push(missed);
             } else {
-                events.erase(nextEvent);
+                ++droppedMissed;
             }
-            nextEvent = findNextEvent(currentTimeCode);
+            if (missed.isRecurring()) scheduleOccurrence(missed, now + 1);
+            continue;
+        }
+
+        if (imageFirst) {
+            pushImageEvent(imageCursor++);
+            continue;
+        }
+
+        Event dueEvent = *stored;
+        events.popFront();
+        pendingEvents.push(dueEvent);
+        if (dueEvent.isRecurring()) {
+            TimeCode after = dueEvent.timeCode > now ? dueEvent.timeCode : now;
+            scheduleOccurrence(dueEvent, after + 1);
+        }
+    }
+    backlog = pendingEvents.full();
+    placeDeferredRules(now);
+
+#if defined(ESP32)
+    if (dispatchTask != nullptr && !pendingEvents.empty()) xTaskNotifyGive(dispatchTask);
+#endif
+}
+
+// Most recent event before cutoff whose scenario does not skip missed events, or NoTimeCode.
+// Both the overlay and the image are searched backwards from the cutoff, so the search
+// normally stops at the first entry it looks at.
+TimeCode EventManager::latestMissed(TimeCode cutoff) const {
+    const Event* stored = events.lastBefore(cutoff, [this](const Event& event) {
+        return getCatchUpPolicy(event.scenario) != CatchUpPolicy::Skip;
+    });
+    TimeCode latest = stored != nullptr ? stored->timeCode : NoTimeCode;
+    if (image == nullptr) return latest;
+
+    for (uint32_t i = image->lowerBound(cutoff); i > imageCursor;) {
+        const ImageEvent& event = image->event(--i);
+        if (latest != NoTimeCode && event.timeCode < latest) break;
+        if (getCatchUpPolicy(event.scenario) != CatchUpPolicy::Skip && !isImageMasked(event.timeCode)) {
+            return event.timeCode;
         }
+    }
+    return latest;
+}
+
+// Drops the overlay events before timeCode without delivering them, in one cut. Each rule
+// keeps at most one occurrence in the overlay, so the recurring ones among them fit in a
+// rule-sized buffer until the store can take their next occurrences.
+void EventManager::dropMissedBefore(TimeCode timeCode, TimeCode now) {
+    Event recurring[EVENT_RULE_CAPACITY];
+    uint8_t recurringCount = 0;
+    droppedMissed += events.popBefore(timeCode, [&](const Event& missed) {
+        if (missed.isRecurring() && recurringCount < EVENT_RULE_CAPACITY) recurring[recurringCount++] = missed;
+    });
+    for (uint8_t i = 0; i < recurringCount; i++) scheduleOccurrence(recurring[i], now + 1);
+}
+
+// An edit can add or remove missed events, so it also ends a catch-up in progress; the
+// next pass sizes up what is left.
+void EventManager::scheduleChanged() {
+    deadlineDirty = true;
+    catchUpCutoff = NoTimeCode;
+}
+
+// Moves the image cursor forward without delivering, forgetting removals it passes.
+void EventManager::skipImageTo(uint32_t index) {
+    if (index <= imageCursor) return;
+    droppedMissed += index - imageCursor;
+    imageCursor = index;
+    TimeCode reached = index < image->eventCount() ? image->event(index).timeCode : NoTimeCode;
+    for (uint8_t i = 0; i < imageMaskCount;) {
+        if (imageMasks[i] < reached) {
+            imageMasks[i] = imageMasks[--imageMaskCount];
+        } else {
+            i++;
+        }
+    }
+}
+
+// Next image event at or after the cursor, skipping (and forgetting) runtime removals.
+const ImageEvent* EventManager::nextImageEvent() {
+    if (image == nullptr) return nullptr;
+    while (imageCursor < image->eventCount()) {
+        const ImageEvent& next = image->event(imageCursor);
+        uint8_t i = 0;
+        while (i < imageMaskCount && imageMasks[i] != next.timeCode) i++;
+        if (i == imageMaskCount) return &next;
+        imageMasks[i] = imageMasks[--imageMaskCount];
+        ++imageCursor;
+    }
+    return nullptr;
+}
+
+// Queues image event `index`. A description the label table has no room for is delivered
+// empty and counted; the first one is reported.
+void EventManager::pushImageEvent(uint32_t index) {
+    Event event;
+    if (!image->materialize(index, event) && labelFailures++ == 0) {
+        Serial.println(F("Label table full: image descriptions delivered empty"));
+    }
+    pendingEvents.push(event);
+}
+
+// True when the image still has a live event at timeCode.
+bool EventManager::imageHas(TimeCode timeCode) const {
+    if (image == nullptr) return false;
+    uint32_t index = image->lowerBound(timeCode);
+    return index >= imageCursor && index < image->eventCount() &&
+           image->event(index).timeCode == timeCode && !isImageMasked(timeCode);
+}
+
+bool EventManager::isImageMasked(TimeCode timeCode) const {
+    for (uint8_t i = 0; i < imageMaskCount; i++) {
+        if (imageMasks[i] == timeCode) return true;
+    }
+    return false;
+}
+
+// Overlay insert that also keeps time codes unique across the image.
+bool EventManager::insertEvent(const Event& event) {
+    if (imageHas(event.timeCode)) return false;
+    return events.insert(event);
+}
+
+// Switches to deadline mode: the timer is armed for the next event instead of checking every second.
+// Pass nullptr to return to per-second polling.
+void EventManager::setDeadlineTimer(DeadlineTimer* timer) {
+    if (deadlineTimer != nullptr) deadlineTimer->disarm();
+    deadlineTimer = timer;
+    deadlineDirty = true;
+}
+
+void EventManager::setEditHandler(EditHandler handler, void* context) {
+    editContext = context;
+    editHandler = handler;
+}
+
+void EventManager::notify(EditKind kind, TimeCode timeCode, uint8_t scenario, uint8_t cycle, uint8_t ruleId,
+                          int32_t offsetSeconds, const RecurrenceRule* rule, const char* description) {
+    if (editHandler == nullptr) return;
+    editHandler(ScheduleEdit{kind, timeCode, scenario, cycle, ruleId, offsetSeconds, rule, description}, editContext);
+}
+
+void EventManager::resume(uint8_t scenario, uint8_t cycle, TimeCode deliveredUntil) {
+    scheduleChanged();
+    currentScenario = scenario;
+    currentCycle = cycle;
+    while (const Event* stored = events.peek()) {
+        if (stored->timeCode > deliveredUntil) break;
+        Event delivered = *stored;
+        events.popFront();
+        if (delivered.isRecurring()) scheduleOccurrence(delivered, deliveredUntil + 1);
+    }
+    if (image != nullptr) {
+        uint32_t next = image->lowerBound(deliveredUntil + 1);
+        if (next > imageCursor) imageCursor = next;
+    }
+}
+
+// Idles the calling task until the next event is due, for at most maxWaitMs.
+// Returns at once when there is pending work or no deadline timer is set.
+void EventManager::waitForNextEvent(uint32_t maxWaitMs) {
+    if (deadlineTimer == nullptr || deadlineDirty || hasInlinePending()) return;
+    deadlineTimer->wait(maxWaitMs);
+}
+
+void EventManager::armDeadline() {
+    static const uint32_t MaxArmMs = 3600000UL;  // Re-arm at least hourly to follow clock discipline
+
+    const Event* stored = events.peek();
+    const ImageEvent* fromImage = nextImageEvent();
+    if (stored == nullptr && fromImage == nullptr && preciseCount == 0) {
+        deadlineTimer->disarm();
+        return;
+    }
+
+    PreciseTimeCode dueMs = preciseCount > 0 ? preciseEvents[0].preciseTime() : static_cast<PreciseTimeCode>(-1);
+    if (stored != nullptr && stored->preciseTime() < dueMs) dueMs = stored->preciseTime();
+    if (fromImage != nullptr && static_cast<PreciseTimeCode>(fromImage->timeCode) * 1000 < dueMs) {
+        dueMs = static_cast<PreciseTimeCode>(fromImage->timeCode) * 1000;
+    }
+    uint64_t nowMs = clock.nowMs();
+    uint64_t delayMs = dueMs > nowMs ? dueMs - nowMs : 0;
+    deadlineTimer->arm(static_cast<uint32_t>(delayMs < MaxArmMs ? delayMs : MaxArmMs));
+}
 
-        processNextPendingEvent();
+// Inserts the rule's first occurrence at or after notBefore. A second already taken by
+// another event skips to the rule's following occurrence. A rule that has run past its
+// date range is released and reported as removed. When the store is full or eight
+// occurrences in a row are taken, the rule is kept and placeDeferredRules() tries again
+// from the next candidate on a later pass.
+bool EventManager::scheduleOccurrence(Event occurrence, TimeCode notBefore) {
+    RuleSlot& slot = rules[occurrence.rule];
+    TimeCode next = slot.recurrence.firstAtOrAfter(notBefore);
+
+    for (uint8_t attempt = 0; next != RecurrenceRule::Never && attempt < 8 && !events.full(); attempt++) {
+        occurrence.timeCode = next;
+        if (insertEvent(occurrence)) return true;
+        next = slot.recurrence.firstAtOrAfter(next + 1);
+    }
+
+    if (next == RecurrenceRule::Never) {
+        freeRule(occurrence.rule);
+        notify(EditKind::RuleRemoved, 0, 0, 0, occurrence.rule);
+        return false;
     }
+    if (slot.retryFrom == 0) ++deferredRules;
+    slot.retryFrom = next;
+    return false;
 }
 
-void EventManager::rescheduleEvent(const Event& event) {
-    uint16_t year;
-    uint8_t month, day, hour, minute, second;
-    Event::decodeTime(event.timeCode, year, month, day, hour, minute, second);
-    
-    DateTime nextOccurrence = rtc.now() + TimeSpan(1, 0, 0, 0);  // Add one day
-    
-    events.erase(event);
-    events.emplace(nextOccurrence.year(), nextOccurrence.month(), nextOccurrence.day(),
-                   hour, minute, second, event.scenario, event.cycle, event.description, true);
+// Retries rules whose occurrence found no room, resuming at the later of the candidate
+// they stopped at and now.
+void EventManager::placeDeferredRules(TimeCode now) {
+    for (uint8_t id = 0; deferredRules > 0 && id < EVENT_RULE_CAPACITY && !events.full(); id++) {
+        RuleSlot& slot = rules[id];
+        if (slot.recurrence.weekdayMask == 0 || slot.retryFrom == 0) continue;
+
+        TimeCode from = slot.retryFrom > now ? slot.retryFrom : now;
+        slot.retryFrom = 0;
+        --deferredRules;
+        deadlineDirty = true;
+
+        Event occurrence;
+        occurrence.label = slot.label;
+        occurrence.scenario = slot.scenario;
+        occurrence.cycle = slot.cycle;
+        occurrence.rule = id;
+        scheduleOccurrence(occurrence, from);
+    }
+}
+
+void EventManager::releaseRule(const Event& occurrence) {
+    if (occurrence.isRecurring() && occurrence.rule < EVENT_RULE_CAPACITY) freeRule(occurrence.rule);
+}
+
+void EventManager::freeRule(uint8_t ruleId) {
+    RuleSlot& slot = rules[ruleId];
+    slot.recurrence.weekdayMask = 0;
+    if (slot.retryFrom != 0) --deferredRules;
+    slot.retryFrom = 0;
 }
 
 uint8_t EventManager::getCurrentScenario() const {
@@ -98,43 +670,163 @@ uint8_t EventManager::getCurrentCycle() const {
     return currentCycle;
 }
 
-void EventManager::setEventCallback(EventCallback callback) {
-    eventCallback = callback;
+EventDispatcher& EventManager::getDispatcher() {
+    return dispatcher;
+}
+
+EventManager::EventRange EventManager::eventsBetween(TimeCode from, TimeCode until) const {
+    return EventRange(this, from, until, -1, static_cast<size_t>(-1));
+}
+
+// The next n events not yet delivered, overdue ones included.
+EventManager::EventRange EventManager::nextN(size_t n) const {
+    return EventRange(this, 0, NoTimeCode, -1, n);
+}
+
+// Walks the image forward until n matches, so a scenario that is rare in a large image costs a longer scan.
+EventManager::EventRange EventManager::nextForScenario(uint8_t scenario, size_t n) const {
+    return EventRange(this, 0, NoTimeCode, scenario, n);
+}
+
+EventManager::EventRange::const_iterator EventManager::EventRange::begin() const {
+    uint32_t imageIndex = 0;
+    if (manager->image != nullptr) {
+        imageIndex = manager->image->lowerBound(from);
+        if (imageIndex < manager->imageCursor) imageIndex = manager->imageCursor;
+    }
+    return const_iterator(manager, manager->events.lowerBound(from), imageIndex, until, scenario, limit);
+}
+
+EventManager::EventRange::const_iterator EventManager::EventRange::end() const {
+    return const_iterator(manager, manager->events.end(), 0, until, scenario, 0);
+}
+
+EventManager::EventRange::const_iterator::const_iterator(const EventManager* manager,
+                                                         Schedule::const_iterator stored, uint32_t imageIndex,
+                                                         TimeCode until, int16_t scenario, size_t remaining)
+    : manager(manager), stored(stored), imageIndex(imageIndex), until(until), scenario(scenario),
+      remaining(remaining), current(), done(false) {
+    advance();
 }
 
-void EventManager::printEvents() const {
-    Serial.println(F("Scheduled Events:"));
-    for (const auto& event : events) {
-        uint16_t year;
-        uint8_t month, day, hour, minute, second;
-        Event::decodeTime(event.timeCode, year, month, day, hour, minute, second);
-        Serial.printf("%04d-%02d-%02d %02d:%02d:%02d - Scenario: %d, Cycle: %d, Desc: %s, Daily: %s\n",
-                      year, month, day, hour, minute, second, event.scenario, event.cycle, 
-                      event.description.c_str(), event.isDaily ? "Yes" : "No");
+void EventManager::EventRange::const_iterator::advance() {
+    const ScheduleImage* image = manager->image;
+    uint32_t imageEnd = image != nullptr ? image->eventCount() : 0;
+
+    while (remaining > 0) {
+        while (imageIndex < imageEnd && manager->isImageMasked(image->event(imageIndex).timeCode)) ++imageIndex;
+        bool haveStored = stored != manager->events.end();
+        if (imageIndex == imageEnd && !haveStored) break;
+
+        if (imageIndex < imageEnd && (!haveStored || image->event(imageIndex).timeCode < stored->timeCode)) {
+            const ImageEvent& event = image->event(imageIndex++);
+            if (event.timeCode >= until) break;
+            if (scenario >= 0 && event.scenario != scenario) continue;
+            current = EventView{event.timeCode, event.scenario, event.cycle, ScheduledEvent::NoRule,
+                                image->string(event.description)};
+        } else {
+            const Event& event = *stored;
+            ++stored;
+            if (event.timeCode >= until) break;
+            if (scenario >= 0 && event.scenario != scenario) continue;
+            current = EventView{event.timeCode, event.scenario, event.cycle, event.rule, event.description()};
+        }
+        --remaining;
+        return;
+    }
+    done = true;
+}
+
+void EventManager::setDrainPolicy(DrainPolicy policy, uint32_t limit) {
+    drainPolicy = policy;
+    drainLimit = limit ? limit : 1;
+}
+
+void EventManager::setCatchUpPolicy(uint8_t scenario, CatchUpPolicy policy) {
+    catchUpCutoff = NoTimeCode;
+    if (getCatchUpPolicy(scenario) == CatchUpPolicy::FireAll) --fireAllScenarios;
+    if (policy == CatchUpPolicy::FireAll) ++fireAllScenarios;
+
+    uint8_t shift = scenario % 4 * 2;
+    uint8_t& packed = catchUpPolicies[scenario / 4];
+    packed = static_cast<uint8_t>((packed & ~(0x03 << shift)) | (static_cast<uint8_t>(policy) << shift));
+}
+
+EventManager::CatchUpPolicy EventManager::getCatchUpPolicy(uint8_t scenario) const {
+    return static_cast<CatchUpPolicy>((catchUpPolicies[scenario / 4] >> (scenario % 4 * 2)) & 0x03);
+}
+
+// Seconds an event may be overdue and still be delivered normally.
+void EventManager::setCatchUpWindow(uint32_t seconds) {
+    catchUpCutoff = NoTimeCode;
+    catchUpWindow = seconds;
+}
+
+uint32_t EventManager::getDroppedMissedEvents() const {
+    return droppedMissed;
+}
+
+uint32_t EventManager::getLabelFailures() const {
+    return labelFailures;
+}
+
+// Pending events are dispatched from update() unless a dispatch task owns them.
+bool EventManager::hasInlinePending() const {
+#if defined(ESP32)
+    if (dispatchTask != nullptr) return false;
+#endif
+    return !pendingEvents.empty();
+}
+
+// Consumer side of pendingEvents. Each event is handled in place and released afterwards.
+void EventManager::dispatchPendingEvents() {
+#if defined(ESP32)
+    if (dispatchTask != nullptr && xTaskGetCurrentTaskHandle() != dispatchTask) return;
+#endif
+    if (discardPending) {
+        discardPending = false;
+        pendingEvents.clear();
+        return;
+    }
+
+    unsigned long startMicros = micros();
+    uint32_t dispatched = 0;
+    while (const Event* event = pendingEvents.front()) {
+        if (drainPolicy == DrainPolicy::PerTick && dispatched >= drainLimit) break;
+        if (drainPolicy == DrainPolicy::TimeBudget && dispatched > 0 && micros() - startMicros >= drainLimit) break;
+
+        currentScenario = event->scenario;
+        currentCycle = event->cycle;
+        dispatcher.dispatch(*event);
+        pendingEvents.popFront();
+        ++dispatched;
     }
 }
 
-std::set<EventManager::Event>::const_iterator EventManager::findNextEvent(uint64_t currentTimeCode) const {
-    Event searchKey(0, 0, 0, 0, 0, 0, 0, 0);
-    searchKey.timeCode = currentTimeCode;
-    return events.lower_bound(searchKey);
+#if defined(ESP32)
+// Moves callbacks onto their own task, optionally on the other core, so a slow consumer
+// cannot delay detection of the next due event. Call once, before events start firing.
+bool EventManager::startDispatchTask(BaseType_t core, uint32_t stackSize, UBaseType_t priority) {
+    if (dispatchTask != nullptr) return true;
+    return xTaskCreatePinnedToCore(&EventManager::dispatchTaskMain, "event-dispatch", stackSize, this,
+                                   priority, &dispatchTask, core) == pdPASS;
 }
 
-void EventManager::processNextPendingEvent() {
-    if (!pendingEvents.empty()) {
-        const Event& event = pendingEvents.front();
-        currentScenario = event.scenario;
-        currentCycle = event.cycle;
-        
-        if (eventCallback) {
-            eventCallback(event);
+void EventManager::dispatchTaskMain(void* arg) {
+    EventManager* manager = static_cast<EventManager*>(arg);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        manager->dispatchPendingEvents();
+        while (!manager->pendingEvents.empty()) {
+            vTaskDelay(1);  // Partial drain under PerTick/TimeBudget: give other tasks a turn
+            manager->dispatchPendingEvents();
         }
-        
-        pendingEvents.pop();
     }
 }
+#endif
 
 bool EventManager::isValidDate(uint16_t year, uint8_t month, uint8_t day) const {
+    if (year < 1970 || year > 2105) return false;  // Range of a 32-bit TimeCode
     if (month == 0 || month > 12) return false;
     if (day == 0 || day > 31) return false;
     if (day == 31 && (month == 4 || month == 6 || month == 9 || month == 11)) return false;
@@ -0,0 +1,67 @@
+// FrameDiff.cpp
+#include "FrameDiff.h"
+#include <cstring>
+
+FrameDiff::FrameDiff(uint8_t width, uint8_t height)
+    : width(width), pages(static_cast<uint8_t>((height + 7) / 8)), shadowValid(false), shadow() {
+    if (static_cast<size_t>(width) * pages > FRAME_DIFF_MAX_BYTES) pages = 0;  // Unsupported panel: nothing is tracked
+}
+
+uint8_t FrameDiff::diff(const uint8_t* frame, FlushWindow (&windows)[FRAME_DIFF_WINDOW_CAPACITY]) {
+    if (pages == 0) return 0;
+    const FlushWindow full = {0, static_cast<uint8_t>(pages - 1), 0, static_cast<uint8_t>(width - 1)};
+    size_t frameBytes = static_cast<size_t>(width) * pages;
+    if (!shadowValid) {
+        memcpy(shadow, frame, frameBytes);
+        shadowValid = true;
+        windows[0] = full;
+        return 1;
+    }
+
+    // A gap shorter than this is cheaper to resend than to skip with a new window
+    const uint8_t mergeGap = CommandBytes + ChunkOverhead;
+    uint8_t count = 0;
+    uint32_t total = 0;
+    bool overflow = false;
+    for (uint8_t page = 0; page < pages && !overflow; page++) {
+        const uint8_t* row = frame + page * width;
+        const uint8_t* old = shadow + page * width;
+        if (memcmp(row, old, width) == 0) continue;
+
+        int16_t start = -1;
+        int16_t end = -1;
+        for (uint8_t column = 0; column < width; column++) {
+            if (row[column] == old[column]) continue;
+            if (start >= 0 && column - end > mergeGap) {
+                if (count == FRAME_DIFF_WINDOW_CAPACITY) {
+                    overflow = true;
+                    break;
+                }
+                windows[count] = FlushWindow{page, page, static_cast<uint8_t>(start), static_cast<uint8_t>(end)};
+                total += cost(windows[count++]);
+                start = -1;
+            }
+            if (start < 0) start = column;
+            end = column;
+        }
+        if (overflow) break;
+        if (count == FRAME_DIFF_WINDOW_CAPACITY) {
+            overflow = true;
+            break;
+        }
+        windows[count] = FlushWindow{page, page, static_cast<uint8_t>(start), static_cast<uint8_t>(end)};
+        total += cost(windows[count++]);
+    }
+
+    memcpy(shadow, frame, frameBytes);
+    if (overflow || total >= cost(full)) {
+        windows[0] = full;
+        return 1;
+    }
+    return count;
+}
+
+uint16_t FrameDiff::cost(const FlushWindow& window) {
+    uint16_t data = window.dataBytes();
+    return static_cast<uint16_t>(CommandBytes + data + (data + ChunkBytes - 1) / ChunkBytes * ChunkOverhead);
+}
@@ -0,0 +1,80 @@
+// LabelTable.cpp
+#include "LabelTable.h"
+#include <cstring>
+#if defined(ESP32)
+#include <soc/soc_memory_layout.h>
+#endif
+
+LabelTable& LabelTable::shared() {
+    static LabelTable table;
+    return table;
+}
+
+LabelTable::LabelTable() : poolEnd(0), count(1) {
+    entries[Empty] = "";
+    for (size_t i = 0; i < HashSize; i++) buckets[i] = NoLabel;
+}
+
+LabelId LabelTable::intern(const char* text) {
+    if (text == nullptr || text[0] == '\0') return Empty;
+
+    size_t i = hashOf(text) & (HashSize - 1);
+    for (; buckets[i] != NoLabel; i = (i + 1) & (HashSize - 1)) {
+        if (strcmp(entries[buckets[i]], text) == 0) return buckets[i];
+    }
+
+    uint16_t id = count.load(std::memory_order_relaxed);
+    if (id == LABEL_TABLE_CAPACITY) return NoLabel;
+
+    const char* stored = text;
+    if (!isReadOnly(text)) {
+        size_t length = strlen(text) + 1;
+        if (poolEnd + length > LABEL_TABLE_POOL_BYTES) return NoLabel;
+        memcpy(pool + poolEnd, text, length);
+        stored = pool + poolEnd;
+        poolEnd += length;
+    }
+
+    entries[id] = stored;
+    buckets[i] = id;
+    count.store(static_cast<uint16_t>(id + 1), std::memory_order_release);
+    return id;
+}
+
+size_t LabelTable::detach(const void* begin, size_t size) {
+    const char* first = static_cast<const char*>(begin);
+    size_t emptied = 0;
+    for (uint16_t id = Empty + 1; id < count.load(std::memory_order_relaxed); id++) {
+        const char* text = entries[id];
+        if (text < first || text >= first + size) continue;
+
+        size_t length = strlen(text) + 1;
+        if (poolEnd + length > LABEL_TABLE_POOL_BYTES) {
+            entries[id] = "";  // Keeps its hash bucket; the text no longer matches anything
+            ++emptied;
+            continue;
+        }
+        memcpy(pool + poolEnd, text, length);
+        entries[id] = pool + poolEnd;
+        poolEnd += length;
+    }
+    return emptied;
+}
+
+// FNV-1a
+uint32_t LabelTable::hashOf(const char* text) {
+    uint32_t hash = 2166136261u;
+    while (*text) {
+        hash = (hash ^ static_cast<uint8_t>(*text++)) * 16777619u;
+    }
+    return hash;
+}
+
+bool LabelTable::isReadOnly(const char* text) {
+#if defined(ESP32)
+    return esp_ptr_in_drom(text);
+#else
+    (void)text;
+    return false;
+#endif
+}
@@ -0,0 +1,116 @@
+// LampDriver.cpp
+#include "LampDriver.h"
+#if defined(ESP32)
+#include <driver/gpio.h>
+#include <soc/gpio_struct.h>
+#endif
+
+#if defined(ESP32)
+bool Esp32GpioPort::begin(uint32_t pinMask) {
+    gpio_config_t config = {};
+    config.pin_bit_mask = pinMask;
+    config.mode = GPIO_MODE_INPUT_OUTPUT;
+    GPIO.out_w1tc = pinMask;  // Dark before the pins start driving
+    return gpio_config(&config) == ESP_OK;
+}
+
+void IRAM_ATTR Esp32GpioPort::write(uint32_t setMask, uint32_t clearMask) {
+    GPIO.out_w1tc = clearMask;
+    GPIO.out_w1ts = setMask;
+}
+
+uint32_t Esp32GpioPort::read() const {
+    return GPIO.in;
+}
+#endif
+
+LampDriver::LampDriver(OutputPort& port, uint32_t lampMask)
+    : port(port), lampMask(lampMask), states(), conflictPairs(), conflictCount(0), failSafe(0), commanded(0),
+      faulted(false), stats()
+#if defined(ESP32)
+      , monitor(nullptr)
+#endif
+{}
+
+// Precomputes the port write for a state. Refused when it lights both sides of a conflict.
+bool LampDriver::setStatePattern(uint8_t state, uint32_t lit) {
+    if (state >= LAMP_STATE_CAPACITY || (lit & ~lampMask) != 0 || hasConflict(lit)) return false;
+    states[state] = Masks{lit, lampMask & ~lit, true};
+    return true;
+}
+
+// Lamps in greensA must never be lit together with lamps in greensB.
+bool LampDriver::addConflict(uint32_t greensA, uint32_t greensB) {
+    if (conflictCount == LAMP_CONFLICT_CAPACITY || greensA == 0 || greensB == 0) return false;
+    conflictPairs[conflictCount++] = Conflict{greensA, greensB};
+    return true;
+}
+
+bool LampDriver::setFailSafePattern(uint32_t lit) {
+    if ((lit & ~lampMask) != 0 || hasConflict(lit)) return false;
+    failSafe = lit;
+    return true;
+}
+
+bool LampDriver::apply(uint8_t state) {
+    if (faulted || state >= LAMP_STATE_CAPACITY || !states[state].defined) return false;
+    const Masks& masks = states[state];
+    port.write(masks.set, masks.clear);
+    commanded = masks.set;
+    ++stats.switches;
+    return true;
+}
+
+void LampDriver::onPhase(const PhaseSequencer::PhaseChange& change, void* driver) {
+    static_cast<LampDriver*>(driver)->apply(change.state);
+}
+
+bool LampDriver::check() {
+    uint32_t lit = port.read() & lampMask;
+    ++stats.checks;
+    if (hasConflict(lit)) {
+        ++stats.conflicts;
+        faulted = true;
+        write(failSafe);
+        return false;
+    }
+    if (lit != commanded) {
+        ++stats.mismatches;
+        return false;
+    }
+    return true;
+}
+
+void LampDriver::clearFault() {
+    faulted = false;
+}
+
+bool LampDriver::hasConflict(uint32_t lit) const {
+    for (uint8_t i = 0; i < conflictCount; i++) {
+        if ((lit & conflictPairs[i].a) != 0 && (lit & conflictPairs[i].b) != 0) return true;
+    }
+    return false;
+}
+
+void LampDriver::write(uint32_t lit) {
+    port.write(lit, lampMask & ~lit);
+    commanded = lit;
+}
+
+#if defined(ESP32)
+bool LampDriver::startMonitor(uint32_t periodMs) {
+    if (monitor == nullptr) {
+        esp_timer_create_args_t args = {};
+        args.callback = &LampDriver::onMonitor;
+        args.arg = this;
+        args.name = "lamp-monitor";
+        if (esp_timer_create(&args, &monitor) != ESP_OK) return false;
+    }
+    esp_timer_stop(monitor);
+    return esp_timer_start_periodic(monitor, static_cast<uint64_t>(periodMs) * 1000) == ESP_OK;
+}
+
+void LampDriver::onMonitor(void* arg) {
+    static_cast<LampDriver*>(arg)->check();
+}
+#endif
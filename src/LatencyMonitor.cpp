@@ -0,0 +1,158 @@
+// LatencyMonitor.cpp
+#include "LatencyMonitor.h"
+#include <cstring>
+
+void LatencyHistogram::record(uint32_t value) {
+    ++counts[bucketOf(value)];
+    ++total;
+    if (value > largest) largest = value;
+}
+
+void LatencyHistogram::reset() {
+    memset(counts, 0, sizeof(counts));
+    total = 0;
+    largest = 0;
+}
+
+uint32_t LatencyHistogram::percentile(uint8_t percent) const {
+    if (total == 0) return 0;
+    uint64_t rank = (static_cast<uint64_t>(total) * percent + 99) / 100;
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (uint8_t i = 0; i < Buckets; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint32_t high = bucketHigh(i);
+            return high < largest ? high : largest;
+        }
+    }
+    return largest;
+}
+
+uint8_t LatencyHistogram::bucketOf(uint32_t value) {
+    if (value < SubBuckets) return static_cast<uint8_t>(value);
+    uint8_t msb = static_cast<uint8_t>(31 - __builtin_clz(value));
+    return static_cast<uint8_t>((msb - 1) * SubBuckets + ((value >> (msb - 2)) & (SubBuckets - 1)));
+}
+
+uint32_t LatencyHistogram::bucketLow(uint8_t index) {
+    if (index < SubBuckets) return index;
+    uint8_t msb = index / SubBuckets + 1;
+    return static_cast<uint32_t>(SubBuckets + index % SubBuckets) << (msb - 2);
+}
+
+uint32_t LatencyHistogram::bucketHigh(uint8_t index) {
+    if (index < SubBuckets) return index;
+    uint8_t msb = index / SubBuckets + 1;
+    return bucketLow(index) + ((1UL << (msb - 2)) - 1);
+}
+
+LatencyMonitor::LatencyMonitor(TimeService& clock, uint32_t eventDeadlineMs, uint32_t loopBudgetUs)
+    : clock(clock), eventDeadlineMs(eventDeadlineMs), loopBudgetUs(loopBudgetUs), lateEvents(0), overrunLoops(0),
+      loopStart(0) {}
+
+bool LatencyMonitor::attach(EventDispatcher& dispatcher) {
+    return dispatcher.subscribe<LatencyMonitor, &LatencyMonitor::onEvent>(*this, EventFilter::all(), "latency") >= 0;
+}
+
+void LatencyMonitor::onEvent(const ScheduledEvent& event) {
+    uint64_t scheduledMs = event.preciseTime();
+    uint64_t nowMs = clock.nowMs();
+    uint64_t late = nowMs > scheduledMs ? nowMs - scheduledMs : 0;
+    uint32_t lateMs = late > 0xFFFFFFFF ? 0xFFFFFFFF : static_cast<uint32_t>(late);
+
+    lateness.record(lateMs);
+    if (lateMs > eventDeadlineMs) ++lateEvents;
+}
+
+void LatencyMonitor::loopStarted() {
+    loopStart = micros();
+}
+
+void LatencyMonitor::loopFinished() {
+    uint32_t elapsed = micros() - loopStart;
+    loopTime.record(elapsed);
+    if (elapsed > loopBudgetUs) ++overrunLoops;
+}
+
+LatencyMonitor::Stats LatencyMonitor::getEventStats() const {
+    return summarize(lateness, lateEvents, eventDeadlineMs);
+}
+
+LatencyMonitor::Stats LatencyMonitor::getLoopStats() const {
+    return summarize(loopTime, overrunLoops, loopBudgetUs);
+}
+
+void LatencyMonitor::reset() {
+    lateness.reset();
+    loopTime.reset();
+    lateEvents = 0;
+    overrunLoops = 0;
+}
+
+LatencyMonitor::Stats LatencyMonitor::summarize(const LatencyHistogram& histogram, uint32_t over,
+                                                uint32_t threshold) {
+    return Stats{histogram.count(), histogram.max(), histogram.percentile(50), histogram.percentile(99), over,
+                 threshold};
+}
+
+void LatencyMonitor::printCsv(Print& out) const {
+    Stats events = getEventStats();
+    Stats loops = getLoopStats();
+    out.println(F("name,count,max,p50,p99,over,threshold"));
+    out.printf("event_ms,%u,%u,%u,%u,%u,%u\n", static_cast<unsigned>(events.count),
+               static_cast<unsigned>(events.max), static_cast<unsigned>(events.p50),
+               static_cast<unsigned>(events.p99), static_cast<unsigned>(events.over),
+               static_cast<unsigned>(events.threshold));
+    out.printf("loop_us,%u,%u,%u,%u,%u,%u\n", static_cast<unsigned>(loops.count), static_cast<unsigned>(loops.max),
+               static_cast<unsigned>(loops.p50), static_cast<unsigned>(loops.p99), static_cast<unsigned>(loops.over),
+               static_cast<unsigned>(loops.threshold));
+    out.println(F("name,low,high,count"));
+    printCsvBuckets(out, "event_ms", lateness);
+    printCsvBuckets(out, "loop_us", loopTime);
+}
+
+void LatencyMonitor::printCsvBuckets(Print& out, const char* name, const LatencyHistogram& histogram) {
+    for (uint8_t i = 0; i < LatencyHistogram::Buckets; i++) {
+        if (histogram.bucketCount(i) == 0) continue;
+        out.printf("%s,%u,%u,%u\n", name, static_cast<unsigned>(LatencyHistogram::bucketLow(i)),
+                   static_cast<unsigned>(LatencyHistogram::bucketHigh(i)),
+                   static_cast<unsigned>(histogram.bucketCount(i)));
+    }
+}
+
+size_t LatencyMonitor::writeBinary(Print& out) const {
+    uint8_t header[6];
+    uint32_t magic = BinaryMagic;
+    memcpy(header, &magic, sizeof(magic));
+    header[4] = BinaryVersion;
+    header[5] = LatencyHistogram::Buckets;
+    size_t written = out.write(header, sizeof(header));
+    written += writeBinaryHistogram(out, lateness, lateEvents, eventDeadlineMs);
+    written += writeBinaryHistogram(out, loopTime, overrunLoops, loopBudgetUs);
+    return written;
+}
+
+size_t LatencyMonitor::writeBinaryHistogram(Print& out, const LatencyHistogram& histogram, uint32_t over,
+                                            uint32_t threshold) {
+    uint8_t used = 0;
+    for (uint8_t i = 0; i < LatencyHistogram::Buckets; i++) {
+        if (histogram.bucketCount(i) != 0) ++used;
+    }
+
+    uint8_t summary[17];
+    uint32_t fields[4] = {histogram.count(), histogram.max(), over, threshold};
+    memcpy(summary, fields, sizeof(fields));
+    summary[16] = used;
+    size_t written = out.write(summary, sizeof(summary));
+
+    for (uint8_t i = 0; i < LatencyHistogram::Buckets; i++) {
+        uint32_t count = histogram.bucketCount(i);
+        if (count == 0) continue;
+        uint8_t entry[5];
+        entry[0] = i;
+        memcpy(entry + 1, &count, sizeof(count));
+        written += out.write(entry, sizeof(entry));
+    }
+    return written;
+}
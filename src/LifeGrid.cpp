@@ -0,0 +1,113 @@
+// LifeGrid.cpp
+#include "LifeGrid.h"
+#include <cstring>
+
+LifeGrid::LifeGrid(uint16_t width, uint16_t height)
+    : width(width), height(height), rowWords(0), lastMask(0), cells(), above(), current(), first() {
+    if (width == 0 || height == 0 || width > LIFE_GRID_MAX_WIDTH || height > LIFE_GRID_MAX_HEIGHT) {
+        this->width = 0;
+        this->height = 0;
+        return;
+    }
+    rowWords = (width + WordBits - 1) / WordBits;
+    uint16_t tail = width % WordBits;
+    lastMask = tail == 0 ? ~static_cast<Word>(0) : (static_cast<Word>(1) << tail) - 1;
+}
+
+void LifeGrid::clear() {
+    memset(cells, 0, sizeof(Word) * rowWords * height);
+}
+
+void LifeGrid::randomize(uint16_t density, FastRandom& rng) {
+    for (uint16_t y = 0; y < height; y++) {
+        Word* cellsRow = row(y);
+        for (uint16_t i = 0; i < rowWords; i++) {
+            Word word = 0;
+            for (uint16_t part = 0; part < sizeof(Word) / 4; part++) {
+                word |= static_cast<Word>(rng.bits(density)) << (32 * part);
+            }
+            cellsRow[i] = word;
+        }
+        cellsRow[rowWords - 1] &= lastMask;
+    }
+}
+
+bool LifeGrid::get(uint16_t x, uint16_t y) const {
+    if (x >= width || y >= height) return false;
+    return (cells[y * rowWords + x / WordBits] >> (x % WordBits)) & 1;
+}
+
+void LifeGrid::set(uint16_t x, uint16_t y, bool alive) {
+    if (x >= width || y >= height) return;
+    Word bit = static_cast<Word>(1) << (x % WordBits);
+    Word& word = row(y)[x / WordBits];
+    word = alive ? word | bit : word & ~bit;
+}
+
+void LifeGrid::step() {
+    if (height == 0) return;
+    const size_t rowSize = sizeof(Word) * rowWords;
+    memcpy(first, row(0), rowSize);
+    memcpy(above, row(height - 1), rowSize);
+    for (uint16_t y = 0; y < height; y++) {
+        memcpy(current, row(y), rowSize);
+        const Word* down = y + 1 < height ? row(y + 1) : first;
+        nextRow(above, current, down, row(y));
+        memcpy(above, current, rowSize);
+    }
+}
+
+uint32_t LifeGrid::population() const {
+    uint32_t count = 0;
+    for (size_t i = 0; i < static_cast<size_t>(rowWords) * height; i++) {
+        count += __builtin_popcountll(cells[i]);
+    }
+    return count;
+}
+
+namespace {
+
+// Sum of three bit planes as a sum bit and a carry bit
+inline void add3(LifeGrid::Word a, LifeGrid::Word b, LifeGrid::Word c, LifeGrid::Word& sum, LifeGrid::Word& carry) {
+    LifeGrid::Word partial = a ^ b;
+    sum = partial ^ c;
+    carry = (a & b) | (partial & c);
+}
+
+} // namespace
+
+// Each word of out gets the next state of WordBits cells. The west and east neighbour
+// planes are the rows shifted by one cell, wrapping around the row's width.
+void LifeGrid::nextRow(const Word* up, const Word* middle, const Word* down, Word* out) const {
+    const uint16_t last = rowWords - 1;
+    const uint16_t topBit = (width - 1) % WordBits;
+    const Word* rows[3] = {up, middle, down};
+
+    for (uint16_t i = 0; i < rowWords; i++) {
+        Word west[3], east[3];
+        for (uint8_t r = 0; r < 3; r++) {
+            const Word* cellsRow = rows[r];
+            Word fromLeft = i > 0 ? cellsRow[i - 1] >> (WordBits - 1) : (cellsRow[last] >> topBit) & 1;
+            Word fromRight = i < last ? cellsRow[i + 1] << (WordBits - 1) : static_cast<Word>(cellsRow[0] & 1) << topBit;
+            west[r] = (cellsRow[i] << 1) | fromLeft;
+            east[r] = (cellsRow[i] >> 1) | fromRight;
+        }
+
+        // Eight neighbour planes: ones = s0, twos = s1, four or more = fours
+        Word sumUp, carryUp, sumDown, carryDown;
+        add3(west[0], up[i], east[0], sumUp, carryUp);
+        add3(west[2], down[i], east[2], sumDown, carryDown);
+        Word sumMiddle = west[1] ^ east[1];
+        Word carryMiddle = west[1] & east[1];
+
+        Word s0, c0, t, u;
+        add3(sumUp, sumDown, sumMiddle, s0, c0);
+        add3(carryUp, carryDown, carryMiddle, t, u);
+        Word s1 = t ^ c0;
+        Word fours = u | (t & c0);
+
+        // Born with 3, survives with 2 or 3
+        out[i] = s1 & ~fours & (s0 | middle[i]);
+    }
+    out[last] &= lastMask;
+}
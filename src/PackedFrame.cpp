@@ -0,0 +1,141 @@
+// PackedFrame.cpp
+#include "PackedFrame.h"
+#include <cstring>
+
+// Builds the probability bit by bit of density, lowest first: OR with fresh random bits
+// halves the chance of a zero, AND halves the chance of a one
+uint32_t FastRandom::bits(uint16_t density) {
+    if (density == 0) return 0;
+    if (density >= 256) return 0xFFFFFFFFUL;
+    uint32_t result = 0;
+    for (uint8_t i = __builtin_ctz(density); i < 8; i++) {
+        result = (density >> i) & 1 ? result | next() : result & next();
+    }
+    return result;
+}
+
+namespace {
+
+inline uint32_t apply(PackedFrame::Op op, uint32_t word, uint32_t value) {
+    switch (op) {
+        case PackedFrame::Op::Set: return value;
+        case PackedFrame::Op::And: return word & value;
+        case PackedFrame::Op::Or: return word | value;
+        case PackedFrame::Op::Xor: return word ^ value;
+    }
+    return word;
+}
+
+// Transposes an 8x8 bit matrix, bit j of byte i <-> bit i of byte j (Hacker's Delight 7-3)
+inline uint64_t transpose8(uint64_t x) {
+    uint64_t t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+} // namespace
+
+void PackedFrame::fill(uint8_t value) {
+    memset(buffer, value, bytes);
+}
+
+void PackedFrame::random(Op op, uint16_t density, FastRandom& rng) {
+    size_t words = bytes / 4;
+    for (size_t i = 0; i < words; i++) {
+        uint32_t word;
+        memcpy(&word, buffer + i * 4, 4);
+        word = apply(op, word, rng.bits(density));
+        memcpy(buffer + i * 4, &word, 4);
+    }
+    for (size_t i = words * 4; i < bytes; i++) {
+        buffer[i] = static_cast<uint8_t>(apply(op, buffer[i], rng.bits(density)));
+    }
+}
+
+void PackedFrame::combine(Op op, const uint8_t* other) {
+    size_t words = bytes / 4;
+    for (size_t i = 0; i < words; i++) {
+        uint32_t word, value;
+        memcpy(&word, buffer + i * 4, 4);
+        memcpy(&value, other + i * 4, 4);
+        word = apply(op, word, value);
+        memcpy(buffer + i * 4, &word, 4);
+    }
+    for (size_t i = words * 4; i < bytes; i++) {
+        buffer[i] = static_cast<uint8_t>(apply(op, buffer[i], other[i]));
+    }
+}
+
+void PackedFrame::thresholdRow(uint8_t y, const uint8_t* samples, uint8_t threshold) {
+    if (y >= height) return;
+    uint8_t* row = buffer + (y / 8) * width;
+    const uint8_t shift = y & 7;
+    const uint8_t keep = static_cast<uint8_t>(~(1 << shift));
+    for (uint8_t x = 0; x < width; x++) {
+        row[x] = static_cast<uint8_t>((row[x] & keep) | ((samples[x] > threshold) << shift));
+    }
+}
+
+void PackedFrame::fromRowMajor(const uint8_t* bits, size_t rowBytes) {
+    const uint8_t pages = static_cast<uint8_t>((height + 7) / 8);
+    if (width % 8 == 0 && height % 8 == 0) {
+        // Eight rows of eight columns at a time: one 8x8 bit transpose per block
+        const size_t stride = rowBytes != 0 ? rowBytes : width / 8;
+        for (uint8_t page = 0; page < pages; page++) {
+            for (uint8_t block = 0; block < width / 8; block++) {
+                uint64_t rows = 0;
+                for (uint8_t r = 0; r < 8; r++) {
+                    rows |= static_cast<uint64_t>(bits[(page * 8 + r) * stride + block]) << (8 * r);
+                }
+                uint64_t columns = transpose8(rows);
+                uint8_t* out = buffer + page * width + block * 8;
+                for (uint8_t c = 0; c < 8; c++) {
+                    out[c] = static_cast<uint8_t>(columns >> (8 * c));
+                }
+            }
+        }
+        return;
+    }
+
+    const size_t rowBits = rowBytes != 0 ? rowBytes * 8 : width;
+    for (uint8_t page = 0; page < pages; page++) {
+        for (uint8_t x = 0; x < width; x++) {
+            uint8_t column = 0;
+            for (uint8_t r = 0; r < 8 && page * 8 + r < height; r++) {
+                size_t i = static_cast<size_t>(page * 8 + r) * rowBits + x;
+                column |= ((bits[i >> 3] >> (i & 7)) & 1) << r;
+            }
+            buffer[page * width + x] = column;
+        }
+    }
+}
+
+void PackedFrame::hSpan(int16_t x0, int16_t x1, int16_t y, bool on) {
+    if (y < 0 || y >= height) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 >= width) x1 = width - 1;
+    uint8_t* row = buffer + (y / 8) * width;
+    const uint8_t bit = static_cast<uint8_t>(1 << (y & 7));
+    for (int16_t x = x0; x <= x1; x++) {
+        row[x] = on ? row[x] | bit : row[x] & ~bit;
+    }
+}
+
+void PackedFrame::vSpan(int16_t x, int16_t y0, int16_t y1, bool on) {
+    if (x < 0 || x >= width) return;
+    if (y0 < 0) y0 = 0;
+    if (y1 >= height) y1 = height - 1;
+    // Whole bytes for the covered pages, masks for the partial ones at either end
+    while (y0 <= y1) {
+        uint8_t page = y0 / 8;
+        uint8_t last = y1 / 8 == page ? y1 & 7 : 7;
+        uint8_t mask = static_cast<uint8_t>((0xFF << (y0 & 7)) & (0xFF >> (7 - last)));
+        uint8_t& column = buffer[page * width + x];
+        column = on ? column | mask : column & ~mask;
+        y0 = (page + 1) * 8;
+    }
+}
@@ -0,0 +1,145 @@
+// PhaseSequencer.cpp
+#include "PhaseSequencer.h"
+
+PhaseSequencer::PhaseSequencer()
+    : plans(), handler(nullptr), context(nullptr), requested(NoRequest), plan(nullptr), running(false), scenario(0),
+      cycle(0), phaseIndex(0), cycleCount(0), phaseEndUs(0), referenceUs(0) {}
+
+bool PhaseSequencer::setPlan(uint8_t scenario, uint8_t cycle, const CyclePlan* cyclePlan) {
+    if (scenario >= PHASE_SCENARIO_CAPACITY || cycle >= PHASE_CYCLE_CAPACITY) return false;
+    if (cyclePlan != nullptr && (cyclePlan->phaseCount == 0 || cyclePlan->cycleTicks() == 0)) return false;
+    plans[scenario][cycle] = cyclePlan;
+    return true;
+}
+
+void PhaseSequencer::setHandler(Handler phaseHandler, void* handlerContext) {
+    context = handlerContext;
+    handler = phaseHandler;
+}
+
+bool PhaseSequencer::select(uint8_t newScenario, uint8_t newCycle) {
+    uint16_t key = static_cast<uint16_t>(newScenario << 8 | newCycle);
+    if (lookup(key) == nullptr) return false;
+    requested.store(key, std::memory_order_release);
+    return true;
+}
+
+bool PhaseSequencer::start(uint64_t nowUs, int64_t cycleReferenceUs) {
+    uint16_t key = requested.exchange(NoRequest, std::memory_order_acq_rel);
+    const CyclePlan* selected = key != NoRequest ? lookup(key) : plan;
+    if (selected == nullptr) return false;
+    if (key != NoRequest) {
+        scenario = key >> 8;
+        cycle = key & 0xFF;
+    }
+    plan = selected;
+    cycleCount = 0;
+    referenceUs = cycleReferenceUs;
+
+    // Walk by the offset into the cycle: shortly after boot the phase may have started
+    // before the counter's zero
+    uint64_t intoUs = intoCycleUs(nowUs);
+    uint8_t index = 0;
+    while (index + 1 < plan->phaseCount && intoUs >= static_cast<uint64_t>(plan->phases[index].duration) * TickUs) {
+        intoUs -= static_cast<uint64_t>(plan->phases[index].duration) * TickUs;
+        ++index;
+    }
+
+    running = true;
+    enter(index, nowUs - intoUs);  // Wraps when the phase began before zero; its end wraps back
+    return true;
+}
+
+void PhaseSequencer::stop() {
+    running = false;
+}
+
+uint64_t PhaseSequencer::run(uint64_t nowUs) {
+    if (!running) return 0;
+    while (nowUs >= phaseEndUs) {
+        uint64_t boundaryUs = phaseEndUs;
+        uint8_t next = phaseIndex + 1;
+        if (next >= plan->phaseCount) {
+            next = 0;
+            cycleCount = cycleCount + 1;
+            uint16_t key = requested.exchange(NoRequest, std::memory_order_acq_rel);
+            const CyclePlan* selected = key != NoRequest ? lookup(key) : nullptr;
+            if (selected != nullptr) {
+                bool switched = selected != plan;
+                plan = selected;
+                scenario = key >> 8;
+                cycle = key & 0xFF;
+                if (switched) {
+                    // Hold the first phase until the new plan's own cycle start
+                    uint64_t lengthUs = static_cast<uint64_t>(plan->cycleTicks()) * TickUs;
+                    uint64_t intoUs = intoCycleUs(boundaryUs);
+                    uint64_t alignedUs = intoUs == 0 ? boundaryUs : boundaryUs + lengthUs - intoUs;
+                    enter(0, boundaryUs);
+                    phaseEndUs = alignedUs + static_cast<uint64_t>(plan->phases[0].duration) * TickUs;
+                    continue;
+                }
+            }
+        }
+        enter(next, boundaryUs);
+    }
+    return phaseEndUs;
+}
+
+// Time since the start of the current plan's cycle at atUs; cycles start at
+// reference + offset + k * length.
+uint64_t PhaseSequencer::intoCycleUs(uint64_t atUs) const {
+    int64_t lengthUs = static_cast<int64_t>(plan->cycleTicks()) * TickUs;
+    int64_t sinceAnchorUs = static_cast<int64_t>(atUs) - referenceUs - static_cast<int64_t>(plan->offset) * TickUs;
+    return static_cast<uint64_t>((sinceAnchorUs % lengthUs + lengthUs) % lengthUs);
+}
+
+const CyclePlan* PhaseSequencer::lookup(uint16_t key) const {
+    uint8_t s = key >> 8;
+    uint8_t c = key & 0xFF;
+    if (s >= PHASE_SCENARIO_CAPACITY || c >= PHASE_CYCLE_CAPACITY) return nullptr;
+    return plans[s][c];
+}
+
+void PhaseSequencer::enter(uint8_t index, uint64_t startUs) {
+    const Phase& phase = plan->phases[index];
+    phaseIndex = index;
+    phaseEndUs = startUs + static_cast<uint64_t>(phase.duration) * TickUs;
+    if (handler != nullptr) {
+        handler(PhaseChange{scenario, cycle, index, phase.state, cycleCount, startUs}, context);
+    }
+}
+
+#if defined(ESP32)
+bool PhaseTimer::begin() {
+    esp_timer_create_args_t args = {};
+    args.callback = &PhaseTimer::onTimer;
+    args.arg = this;
+    args.name = "phase-sequencer";
+    return esp_timer_create(&args, &timer) == ESP_OK;
+}
+
+bool PhaseTimer::start(int64_t referenceUs) {
+    if (timer == nullptr) return false;
+    esp_timer_stop(timer);
+    if (!sequencer.start(esp_timer_get_time(), referenceUs)) return false;
+    arm(sequencer.run(esp_timer_get_time()));
+    return true;
+}
+
+void PhaseTimer::stop() {
+    if (timer != nullptr) esp_timer_stop(timer);
+    sequencer.stop();
+}
+
+void PhaseTimer::arm(uint64_t dueUs) {
+    if (dueUs == 0) return;
+    int64_t now = esp_timer_get_time();
+    uint64_t delayUs = dueUs > static_cast<uint64_t>(now) ? dueUs - now : 1;
+    esp_timer_start_once(timer, delayUs);
+}
+
+void PhaseTimer::onTimer(void* arg) {
+    PhaseTimer* self = static_cast<PhaseTimer*>(arg);
+    self->arm(self->sequencer.run(esp_timer_get_time()));
+}
+#endif // ESP32
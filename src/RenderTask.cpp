@@ -0,0 +1,57 @@
+// RenderTask.cpp
+#include "RenderTask.h"
+
+RenderTask::RenderTask(OLEDManager& oled)
+    : oled(oled), latest(), lastEventSerial(0), lastRenderedTime(0), framesRendered(0), task(nullptr) {}
+
+bool RenderTask::begin(BaseType_t core, uint32_t stackSize, UBaseType_t priority) {
+    if (task != nullptr) return true;
+    return xTaskCreatePinnedToCore(&RenderTask::taskMain, "render", stackSize, this, priority, &task, core) == pdPASS;
+}
+
+void RenderTask::publishTime(TimeCode now) {
+    latest.time = now;
+    publish();
+}
+
+void RenderTask::publishEvent(const ScheduledEvent& event) {
+    latest.event = event;
+    ++latest.eventSerial;
+    publish();
+}
+
+uint32_t RenderTask::getFramesRendered() const {
+    return framesRendered;
+}
+
+void RenderTask::publish() {
+    frames.back() = latest;
+    frames.publish();
+    if (task != nullptr) xTaskNotifyGive(task);
+}
+
+void RenderTask::render(const Frame& frame) {
+    if (frame.eventSerial != lastEventSerial) {
+        lastEventSerial = frame.eventSerial;
+        oled.displayEvent(frame.event);
+    } else if (frame.time != lastRenderedTime) {
+        lastRenderedTime = frame.time;
+        oled.displayTime(DateTime(frame.time));
+    } else {
+        return;
+    }
+    ++framesRendered;
+}
+
+void RenderTask::taskMain(void* arg) {
+    RenderTask* self = static_cast<RenderTask*>(arg);
+    for (;;) {
+        // Sleep until something is published or the playing effect's next frame is due
+        uint32_t waitMs = self->oled.msUntilNextFrame(millis());
+        ulTaskNotifyTake(pdTRUE, waitMs == FrameScheduler::Idle ? portMAX_DELAY : pdMS_TO_TICKS(waitMs));
+        if (self->frames.acquire()) {
+            self->render(self->frames.front());
+        }
+        self->oled.tick(millis());
+    }
+}
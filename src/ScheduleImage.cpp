@@ -0,0 +1,154 @@
+// ScheduleImage.cpp
+#include "ScheduleImage.h"
+
+ScheduleImage::ScheduleImage()
+    : header(nullptr), events(nullptr), rules(nullptr), strings(nullptr)
+#if defined(ESP32)
+      , mapHandle(0), mapped(false)
+#endif
+{}
+
+ScheduleImage::Status ScheduleImage::open(const void* data, size_t size) {
+    header = nullptr;
+    if (data == nullptr || size < sizeof(ImageHeader)) return Status::TooSmall;
+    if (reinterpret_cast<uintptr_t>(data) % 4 != 0) return Status::BadLayout;
+
+    const ImageHeader* candidate = static_cast<const ImageHeader*>(data);
+    if (candidate->magic != Magic) return Status::BadMagic;
+    if (candidate->version != Version) return Status::BadVersion;
+    if (candidate->headerSize != sizeof(ImageHeader) ||
+        crc32(candidate, offsetof(ImageHeader, headerCrc)) != candidate->headerCrc) {
+        return Status::BadHeader;
+    }
+
+    uint64_t recordsEnd = sizeof(ImageHeader) + static_cast<uint64_t>(candidate->eventCount) * sizeof(ImageEvent) +
+                          static_cast<uint64_t>(candidate->ruleCount) * sizeof(ImageRule);
+    uint64_t end = static_cast<uint64_t>(candidate->stringsOffset) + candidate->stringsSize;
+    if (candidate->stringsOffset != recordsEnd || end > size || candidate->stringsSize > 0x10000) {
+        return Status::BadLayout;
+    }
+
+    const uint8_t* base = static_cast<const uint8_t*>(data);
+    const char* table = reinterpret_cast<const char*>(base + candidate->stringsOffset);
+    if (candidate->stringsSize == 0 || table[candidate->stringsSize - 1] != '\0') {
+        return Status::BadLayout;  // Every offset must reach a terminator inside the table
+    }
+
+    header = candidate;
+    events = reinterpret_cast<const ImageEvent*>(base + sizeof(ImageHeader));
+    rules = reinterpret_cast<const ImageRule*>(events + header->eventCount);
+    strings = table;
+    return Status::Ok;
+}
+
+#if defined(ESP32)
+ScheduleImage::Status ScheduleImage::openPartition(const char* label) {
+    close();
+    const esp_partition_t* partition =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (partition == nullptr) return Status::NotFound;
+
+    const void* data = nullptr;
+    if (esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &data, &mapHandle) != ESP_OK) {
+        return Status::NotFound;
+    }
+    mapped = true;
+
+    Status status = open(data, partition->size);
+    if (status != Status::Ok) close();
+    return status;
+}
+#endif
+
+// Full check of everything open() takes on trust: payload checksum, ordering, record fields.
+ScheduleImage::Status ScheduleImage::verify() const {
+    if (header == nullptr) return Status::NotFound;
+
+    const uint8_t* payload = reinterpret_cast<const uint8_t*>(header) + sizeof(ImageHeader);
+    if (crc32(payload, imageSize() - sizeof(ImageHeader)) != header->payloadCrc) return Status::BadChecksum;
+
+    for (uint32_t i = 0; i < header->eventCount; i++) {
+        if (i > 0 && events[i].timeCode <= events[i - 1].timeCode) return Status::Unsorted;
+        if (events[i].description >= header->stringsSize) return Status::BadRecord;
+    }
+    for (uint32_t i = 0; i < header->ruleCount; i++) {
+        if (!rules[i].recurrence().isValid() || rules[i].description >= header->stringsSize) {
+            return Status::BadRecord;
+        }
+    }
+    return Status::Ok;
+}
+
+void ScheduleImage::close() {
+    // Descriptions interned from the image point into it; move them out before it is unmapped
+    if (header != nullptr) LabelTable::shared().detach(strings, header->stringsSize);
+    header = nullptr;
+    events = nullptr;
+    rules = nullptr;
+    strings = nullptr;
+#if defined(ESP32)
+    if (mapped) {
+        spi_flash_munmap(mapHandle);
+        mapped = false;
+    }
+#endif
+}
+
+uint32_t ScheduleImage::lowerBound(TimeCode timeCode) const {
+    uint32_t low = 0;
+    uint32_t high = eventCount();
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (events[mid].timeCode < timeCode) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+bool ScheduleImage::contains(TimeCode timeCode) const {
+    uint32_t index = lowerBound(timeCode);
+    return index < eventCount() && events[index].timeCode == timeCode;
+}
+
+bool ScheduleImage::materialize(uint32_t index, ScheduledEvent& event) const {
+    const ImageEvent& record = events[index];
+    event.timeCode = record.timeCode;
+    event.millisecond = 0;
+    event.scenario = record.scenario;
+    event.cycle = record.cycle;
+    event.rule = ScheduledEvent::NoRule;
+    return event.setDescription(string(record.description));
+}
+
+const char* ScheduleImage::statusName(Status status) {
+    switch (status) {
+        case Status::Ok: return "ok";
+        case Status::NotFound: return "not found";
+        case Status::TooSmall: return "too small";
+        case Status::BadMagic: return "bad magic";
+        case Status::BadVersion: return "unsupported version";
+        case Status::BadHeader: return "corrupt header";
+        case Status::BadLayout: return "bad layout";
+        case Status::BadChecksum: return "checksum mismatch";
+        case Status::Unsorted: return "events not sorted";
+        case Status::BadRecord: return "bad record";
+    }
+    return "unknown";
+}
+
+// CRC-32 (IEEE 802.3, reflected), bitwise to keep the table out of RAM; pass the previous
+// result as crc to continue over several buffers.
+uint32_t ScheduleImage::crc32(const void* data, size_t length, uint32_t crc) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,539 @@
+// ScheduleJournal.cpp
+#include "ScheduleJournal.h"
+#include "CivilTime.h"
+
+#if defined(ESP32)
+bool PartitionJournalStorage::begin(const char* label) {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    return partition != nullptr;
+}
+
+bool PartitionJournalStorage::read(uint32_t offset, void* data, size_t length) const {
+    return partition != nullptr && esp_partition_read(partition, offset, data, length) == ESP_OK;
+}
+
+bool PartitionJournalStorage::write(uint32_t offset, const void* data, size_t length) {
+    return partition != nullptr && esp_partition_write(partition, offset, data, length) == ESP_OK;
+}
+
+bool PartitionJournalStorage::eraseSector(uint32_t offset) {
+    return partition != nullptr && esp_partition_erase_range(partition, offset, JOURNAL_SECTOR_SIZE) == ESP_OK;
+}
+#endif
+
+ScheduleJournal::ScheduleJournal(EventManager& manager, JournalStorage& storage)
+    : manager(manager), storage(storage), sectorCount(0), baseSequence(NoSequence), unfinishedSequence(NoSequence),
+      sequence(NoSequence), writeOffset(0), snapshotSequence(NoSequence), compacting(false), snapshotWritten(false),
+      attached(false), deliveredUntil(0), currentScenario(0), currentCycle(0), ruleIds(), queue(), position(0),
+      loggedPosition(0), snapshotWanted(false), stats()
+#if defined(ESP32)
+      , writerTask(nullptr)
+#endif
+{}
+
+bool ScheduleJournal::begin() {
+    sectorCount = storage.size() / JOURNAL_SECTOR_SIZE;
+    baseSequence = NoSequence;
+    unfinishedSequence = NoSequence;
+    sequence = NoSequence;
+    if (sectorCount < 4) return false;
+
+    uint32_t newest = NoSequence;
+    for (uint32_t i = 0; i < sectorCount; i++) {
+        uint32_t found;
+        if (readSectorSequence(i, found) && (newest == NoSequence || found > newest)) newest = found;
+    }
+    if (newest == NoSequence) return true;  // Blank: the first append starts sector 0
+
+    // The log is the run of consecutive sequences that ends at the newest sector
+    uint32_t oldest = newest;
+    uint32_t found;
+    while (oldest > 0 && newest - (oldest - 1) < sectorCount &&
+           readSectorSequence((oldest - 1) % sectorCount, found) && found == oldest - 1) {
+        --oldest;
+    }
+
+    sequence = newest;
+    Cursor cursor = {oldest, SectorHeaderSize};
+    Record record;
+    ReadResult result;
+    while ((result = next(cursor, record)) == ReadResult::Ok) {
+        if (record.type == Begin) {
+            unfinishedSequence = cursor.sequence;
+        } else if (record.type == End && unfinishedSequence != NoSequence) {
+            baseSequence = unfinishedSequence;
+            unfinishedSequence = NoSequence;
+        }
+    }
+    // Never append after a torn record: its bytes may be half programmed
+    writeOffset = result == ReadResult::End ? cursor.offset : JOURNAL_SECTOR_SIZE;
+    return true;
+}
+
+bool ScheduleJournal::replay() {
+    if (baseSequence == NoSequence) return false;
+    unsigned long startMicros = micros();
+
+    Cursor cursor = {baseSequence, SectorHeaderSize};
+    Record record;
+    if (next(cursor, record) != ReadResult::Ok || record.type != Begin) return false;
+    const ScheduleImage* image = manager.getImage();
+    uint32_t checksum;
+    memcpy(&checksum, record.payload, sizeof(checksum));
+    bool hadImage = (record.payload[4] & ImageAttached) != 0;
+    if (hadImage != (image != nullptr) || (image != nullptr && checksum != image->checksum())) return false;
+
+    if (attached) manager.setEditHandler(nullptr, nullptr);
+    memset(ruleIds, ScheduledEvent::NoRule, sizeof(ruleIds));
+    deliveredUntil = 0;
+    currentScenario = manager.getCurrentScenario();
+    currentCycle = manager.getCurrentCycle();
+    stats.replayedRecords = 0;
+    // A snapshot cut short by a reset, and anything after it, is left out
+    do {
+        apply(record);
+        ++stats.replayedRecords;
+    } while (next(cursor, record) == ReadResult::Ok &&
+             !(record.type == Begin && cursor.sequence == unfinishedSequence));
+    manager.resume(currentScenario, currentCycle, deliveredUntil);
+    position.store(pack(deliveredUntil, currentScenario, currentCycle), std::memory_order_release);
+    if (attached) manager.setEditHandler(&ScheduleJournal::onEdit, this);
+
+    stats.replayUs = micros() - startMicros;
+    return true;
+}
+
+bool ScheduleJournal::attach(EventDispatcher& dispatcher) {
+    if (sectorCount < 4) return false;
+    if (!attached) {
+        if (dispatcher.subscribe<ScheduleJournal, &ScheduleJournal::onEvent>(*this, EventFilter::all(), "journal") < 0) {
+            return false;
+        }
+        manager.setEditHandler(&ScheduleJournal::onEdit, this);
+        attached = true;
+    }
+    // Also renumbers the rules as the manager knows them after a replay
+    return compact();
+}
+
+bool ScheduleJournal::compact() {
+    if (sectorCount < 4) return false;
+    if (queue.capacity() - queue.size() < SnapshotEntries) {
+        snapshotWanted.store(true, std::memory_order_release);
+        return false;
+    }
+    snapshotWanted.store(false, std::memory_order_release);
+
+    const ScheduleImage* image = manager.getImage();
+    Entry entry = {};
+    entry.type = Begin;
+    entry.value = image != nullptr ? image->checksum() : 0;
+    entry.scenario = image != nullptr ? ImageAttached : 0;
+    enqueue(entry);
+
+    uint64_t latest = position.load(std::memory_order_relaxed);
+    entry = {};
+    entry.type = Delivered;
+    entry.value = static_cast<TimeCode>(latest);
+    entry.scenario = static_cast<uint8_t>(latest >> 32);
+    entry.cycle = static_cast<uint8_t>(latest >> 40);
+    enqueue(entry);
+
+    // Rules are written once, from their pending occurrence
+    bool ruleQueued[EVENT_RULE_CAPACITY] = {};
+    for (uint16_t scenario = 0; scenario < 256; scenario++) {
+        for (const ScheduledEvent& event : manager.scenarioEvents(static_cast<uint8_t>(scenario))) {
+            entry = {};
+            entry.scenario = event.scenario;
+            entry.cycle = event.cycle;
+            entry.label = event.label;
+            if (!event.isRecurring()) {
+                entry.type = EventAdded;
+                entry.value = event.timeCode;
+                enqueue(entry);
+                continue;
+            }
+            const RecurrenceRule* rule = manager.getRule(event.rule);
+            if (rule == nullptr || event.rule >= EVENT_RULE_CAPACITY || ruleQueued[event.rule]) continue;
+            ruleQueued[event.rule] = true;
+            entry.type = RuleAdded;
+            entry.ruleId = event.rule;
+            entry.value = rule->secondOfDay;
+            entry.firstDay = rule->firstDay;
+            entry.lastDay = rule->lastDay;
+            entry.weekdayMask = rule->weekdayMask;
+            entry.intervalWeeks = rule->intervalWeeks;
+            enqueue(entry);
+        }
+    }
+
+    for (uint8_t i = 0; i < manager.getImageRemovalCount(); i++) {
+        entry = {};
+        entry.type = EventRemoved;
+        entry.value = manager.getImageRemoval(i);
+        enqueue(entry);
+    }
+    entry = {};
+    entry.type = End;
+    enqueue(entry);
+    wake();
+    return true;
+}
+
+void ScheduleJournal::onEdit(const EventManager::ScheduleEdit& edit, void* journal) {
+    ScheduleJournal* self = static_cast<ScheduleJournal*>(journal);
+    Entry entry = {};
+    switch (edit.kind) {
+    case EventManager::EditKind::EventAdded:
+        entry.type = EventAdded;
+        entry.value = edit.timeCode;
+        break;
+    case EventManager::EditKind::EventRemoved:
+        entry.type = EventRemoved;
+        entry.value = edit.timeCode;
+        break;
+    case EventManager::EditKind::RuleAdded:
+        entry.type = RuleAdded;
+        entry.value = edit.rule->secondOfDay;
+        entry.firstDay = edit.rule->firstDay;
+        entry.lastDay = edit.rule->lastDay;
+        entry.weekdayMask = edit.rule->weekdayMask;
+        entry.intervalWeeks = edit.rule->intervalWeeks;
+        break;
+    case EventManager::EditKind::RuleRemoved:
+        entry.type = RuleRemoved;
+        break;
+    case EventManager::EditKind::ScenarioRemoved:
+        entry.type = ScenarioRemoved;
+        break;
+    case EventManager::EditKind::ScenarioRescheduled:
+        entry.type = ScenarioRescheduled;
+        entry.value = static_cast<uint32_t>(edit.offsetSeconds);
+        break;
+    case EventManager::EditKind::Cleared:
+        entry.type = Cleared;
+        break;
+    }
+    entry.scenario = edit.scenario;
+    entry.cycle = edit.cycle;
+    entry.ruleId = edit.ruleId;
+    if (entry.type == EventAdded || entry.type == RuleAdded) {
+        // Already in the table, so this only looks the id up
+        LabelId id = edit.description != nullptr ? LabelTable::shared().intern(edit.description) : LabelTable::Empty;
+        entry.label = id == LabelTable::NoLabel ? LabelTable::Empty : id;
+    }
+    self->enqueue(entry);
+    if (self->snapshotWanted.load(std::memory_order_acquire)) self->compact();
+    self->wake();
+}
+
+// RAM only: the writer logs the newest position on its next pass
+void ScheduleJournal::onEvent(const ScheduledEvent& event) {
+    TimeCode until = static_cast<TimeCode>(position.load(std::memory_order_relaxed));
+    if (event.timeCode > until) until = event.timeCode;
+    position.store(pack(until, event.scenario, event.cycle), std::memory_order_release);
+    if (snapshotWanted.load(std::memory_order_acquire)) compact();
+    wake();
+}
+
+void ScheduleJournal::flush() {
+    while (const Entry* entry = queue.front()) {
+        write(*entry);
+        queue.popFront();
+    }
+    uint64_t latest = position.load(std::memory_order_acquire);
+    if (latest != loggedPosition && !compacting) {
+        Entry entry = {};
+        entry.type = Delivered;
+        entry.value = static_cast<TimeCode>(latest);
+        entry.scenario = static_cast<uint8_t>(latest >> 32);
+        entry.cycle = static_cast<uint8_t>(latest >> 40);
+        writeRecord(entry);
+    }
+}
+
+#if defined(ESP32)
+bool ScheduleJournal::startWriterTask(BaseType_t core, uint32_t stackSize, UBaseType_t priority) {
+    if (writerTask != nullptr) return true;
+    return xTaskCreatePinnedToCore(&ScheduleJournal::writerTaskMain, "journal", stackSize, this, priority,
+                                   &writerTask, core) == pdPASS;
+}
+
+void ScheduleJournal::writerTaskMain(void* arg) {
+    ScheduleJournal* journal = static_cast<ScheduleJournal*>(arg);
+    for (;;) {
+        journal->flush();  // The first pass writes the snapshot queued by attach()
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(JOURNAL_WRITE_DELAY_MS));  // A burst of events costs one position record
+    }
+}
+#endif
+
+// A full queue loses the record; the snapshot queued next makes the log whole again
+void ScheduleJournal::enqueue(const Entry& entry) {
+    if (queue.push(entry)) return;
+    ++stats.queueOverflows;
+    snapshotWanted.store(true, std::memory_order_release);
+}
+
+void ScheduleJournal::wake() {
+#if defined(ESP32)
+    if (writerTask != nullptr) xTaskNotifyGive(writerTask);
+#endif
+}
+
+bool ScheduleJournal::readSectorSequence(uint32_t index, uint32_t& sectorSequence) const {
+    uint32_t header[2];
+    if (!storage.read(index * JOURNAL_SECTOR_SIZE, header, sizeof(header)) || header[0] != Magic) return false;
+    sectorSequence = header[1];
+    return header[1] != NoSequence && header[1] % sectorCount == index;
+}
+
+ScheduleJournal::ReadResult ScheduleJournal::readRecord(Cursor& cursor, Record& record) const {
+    if (cursor.offset + RecordHeaderSize > JOURNAL_SECTOR_SIZE) return ReadResult::End;
+    uint8_t header[RecordHeaderSize];
+    uint32_t base = sectorOffset(cursor.sequence);
+    if (!storage.read(base + cursor.offset, header, sizeof(header))) return ReadResult::Corrupt;
+    if (header[0] == 0xFF && header[1] == 0xFF && header[2] == 0xFF && header[3] == 0xFF) return ReadResult::End;
+
+    uint32_t size = (RecordHeaderSize + header[1] + 3) & ~3UL;
+    if (cursor.offset + size > JOURNAL_SECTOR_SIZE) return ReadResult::Corrupt;
+    record.type = header[0];
+    record.length = header[1];
+    if (!storage.read(base + cursor.offset + RecordHeaderSize, record.payload, record.length)) {
+        return ReadResult::Corrupt;
+    }
+    record.payload[record.length] = '\0';
+    if (check(record) != static_cast<uint16_t>(header[2] | header[3] << 8)) return ReadResult::Corrupt;
+
+    cursor.offset += size;
+    return ReadResult::Ok;
+}
+
+// Next record of the log, moving on to the following sector at the end of one. A torn
+// record ends its sector only; the log carried on in a fresh sector after the restart.
+ScheduleJournal::ReadResult ScheduleJournal::next(Cursor& cursor, Record& record) const {
+    for (;;) {
+        ReadResult result = readRecord(cursor, record);
+        if (result == ReadResult::Ok || cursor.sequence == sequence) return result;
+        ++cursor.sequence;
+        cursor.offset = SectorHeaderSize;
+    }
+}
+
+uint16_t ScheduleJournal::check(const Record& record) {
+    uint32_t crc = ScheduleImage::crc32(&record.type, 2);
+    return static_cast<uint16_t>(ScheduleImage::crc32(record.payload, record.length, crc));
+}
+
+// Appends one record. Running out of sector space opens the next sector; once the log
+// since the last snapshot fills half the ring, the owner task is asked to queue a new one.
+bool ScheduleJournal::append(uint8_t type, const uint8_t* payload, size_t length) {
+    uint32_t size = (RecordHeaderSize + length + 3) & ~3UL;
+    if (sequence == NoSequence || writeOffset + size > JOURNAL_SECTOR_SIZE) {
+        uint32_t next = sequence == NoSequence ? 0 : sequence + 1;
+        if (!compacting && (baseSequence == NoSequence || next - baseSequence >= sectorCount / 2)) {
+            snapshotWanted.store(true, std::memory_order_release);
+        }
+        if (!openSector(next)) {
+            ++stats.failures;
+            return false;
+        }
+    }
+
+    Record record;
+    record.type = type;
+    record.length = static_cast<uint8_t>(length);
+    if (length > 0) memcpy(record.payload, payload, length);
+    uint16_t sum = check(record);
+
+    uint8_t buffer[RecordHeaderSize + MaxPayload + 1];
+    memset(buffer, 0xFF, size);  // Padding stays erased
+    buffer[0] = type;
+    buffer[1] = record.length;
+    buffer[2] = static_cast<uint8_t>(sum);
+    buffer[3] = static_cast<uint8_t>(sum >> 8);
+    memcpy(buffer + RecordHeaderSize, record.payload, length);
+    if (!storage.write(sectorOffset(sequence) + writeOffset, buffer, size)) {
+        writeOffset = JOURNAL_SECTOR_SIZE;  // Whatever reached the flash is skipped by the check
+        ++stats.failures;
+        return false;
+    }
+    writeOffset += size;
+    ++stats.records;
+    stats.bytesWritten += size;
+    return true;
+}
+
+// Erases the sector for sectorSequence and makes it the one appended to. Refuses to
+// erase the sector of the last complete snapshot or anything after it.
+bool ScheduleJournal::openSector(uint32_t sectorSequence) {
+    if (baseSequence != NoSequence && sectorSequence - baseSequence >= sectorCount) return false;
+    uint32_t offset = sectorOffset(sectorSequence);
+    if (!storage.eraseSector(offset)) return false;
+    ++stats.sectorsErased;
+
+    uint32_t header[2] = {Magic, sectorSequence};
+    sequence = sectorSequence;
+    writeOffset = JOURNAL_SECTOR_SIZE;
+    if (!storage.write(offset, header, sizeof(header))) return false;
+    writeOffset = SectorHeaderSize;
+    return true;
+}
+
+// Writes one queued entry. A snapshot starts in a fresh sector and only becomes the
+// base for replay once its End is written.
+void ScheduleJournal::write(const Entry& entry) {
+    if (entry.type == Begin) {
+        uint8_t payload[5];
+        memcpy(payload, &entry.value, sizeof(entry.value));
+        payload[4] = entry.scenario;
+        snapshotSequence = sequence == NoSequence ? 0 : sequence + 1;
+        compacting = true;
+        snapshotWritten = openSector(snapshotSequence) && append(Begin, payload, sizeof(payload));
+        return;
+    }
+    if (entry.type == End) {
+        if (!compacting) return;
+        compacting = false;
+        if (snapshotWritten && append(End, nullptr, 0)) {
+            baseSequence = snapshotSequence;
+            unfinishedSequence = NoSequence;
+            ++stats.compactions;
+        } else {
+            ++stats.failures;
+            unfinishedSequence = snapshotSequence;
+            snapshotWanted.store(true, std::memory_order_release);
+        }
+        return;
+    }
+    if (compacting) {
+        snapshotWritten = snapshotWritten && writeRecord(entry);
+    } else {
+        writeRecord(entry);
+    }
+}
+
+bool ScheduleJournal::writeRecord(const Entry& entry) {
+    uint8_t payload[5];
+    switch (entry.type) {
+    case Delivered:
+        if (!appendEvent(Delivered, entry.value, entry.scenario, entry.cycle, nullptr)) return false;
+        loggedPosition = pack(entry.value, entry.scenario, entry.cycle);
+        return true;
+    case EventAdded:
+        return appendEvent(EventAdded, entry.value, entry.scenario, entry.cycle,
+                           LabelTable::shared().text(entry.label));
+    case EventRemoved:
+        memcpy(payload, &entry.value, sizeof(entry.value));
+        return append(EventRemoved, payload, 4);
+    case RuleAdded: {
+        RecurrenceRule rule = {entry.value, entry.firstDay, entry.lastDay, entry.weekdayMask, entry.intervalWeeks};
+        return appendRule(entry.ruleId, rule, entry.scenario, entry.cycle, LabelTable::shared().text(entry.label));
+    }
+    case RuleRemoved:
+        return append(RuleRemoved, &entry.ruleId, 1);
+    case ScenarioRemoved:
+        return append(ScenarioRemoved, &entry.scenario, 1);
+    case ScenarioRescheduled:
+        payload[0] = entry.scenario;
+        memcpy(payload + 1, &entry.value, sizeof(entry.value));
+        return append(ScenarioRescheduled, payload, 5);
+    case Cleared:
+        return append(Cleared, nullptr, 0);
+    default:
+        return false;
+    }
+}
+
+bool ScheduleJournal::appendEvent(uint8_t type, TimeCode timeCode, uint8_t scenario, uint8_t cycle,
+                                  const char* description) {
+    uint8_t payload[MaxPayload];
+    memcpy(payload, &timeCode, sizeof(timeCode));
+    payload[4] = scenario;
+    payload[5] = cycle;
+    size_t length = description != nullptr ? strnlen(description, MaxPayload - 6) : 0;
+    if (length > 0) memcpy(payload + 6, description, length);
+    return append(type, payload, 6 + length);
+}
+
+bool ScheduleJournal::appendRule(uint8_t id, const RecurrenceRule& rule, uint8_t scenario, uint8_t cycle,
+                                 const char* description) {
+    uint8_t payload[MaxPayload];
+    memcpy(payload, &rule.secondOfDay, 4);
+    memcpy(payload + 4, &rule.firstDay, 2);
+    memcpy(payload + 6, &rule.lastDay, 2);
+    payload[8] = rule.weekdayMask;
+    payload[9] = rule.intervalWeeks;
+    payload[10] = id;
+    payload[11] = scenario;
+    payload[12] = cycle;
+    size_t length = description != nullptr ? strnlen(description, MaxPayload - 13) : 0;
+    if (length > 0) memcpy(payload + 13, description, length);
+    return append(RuleAdded, payload, 13 + length);
+}
+
+void ScheduleJournal::apply(Record& record) {
+    const uint8_t* p = record.payload;
+    TimeCode timeCode = 0;
+    if (record.length >= 4) memcpy(&timeCode, p, sizeof(timeCode));
+
+    switch (record.type) {
+    case Begin:
+        // The snapshot replaces the overlay; image events are restored by the image itself
+        if (p[4] & ImageAttached) {
+            for (uint8_t id = 0; id < EVENT_RULE_CAPACITY; id++) manager.removeRule(id);
+            for (uint16_t scenario = 0; scenario < 256; scenario++) {
+                manager.removeScenario(static_cast<uint8_t>(scenario));
+            }
+        } else {
+            manager.clearEvents();
+        }
+        break;
+    case Delivered:
+        if (timeCode > deliveredUntil) deliveredUntil = timeCode;
+        currentScenario = p[4];
+        currentCycle = p[5];
+        break;
+    case EventAdded: {
+        CivilTime t = CivilTime::fromEpoch(timeCode);
+        manager.addEvent(t.year, t.month, t.day, t.hour, t.minute, t.second, p[4], p[5],
+                         reinterpret_cast<const char*>(p + 6));
+        break;
+    }
+    case EventRemoved:
+        manager.removeEvent(timeCode);
+        break;
+    case RuleAdded: {
+        RecurrenceRule rule = {};
+        memcpy(&rule.secondOfDay, p, 4);
+        memcpy(&rule.firstDay, p + 4, 2);
+        memcpy(&rule.lastDay, p + 6, 2);
+        rule.weekdayMask = p[8];
+        rule.intervalWeeks = p[9];
+        int id = manager.addRule(rule, p[11], p[12], reinterpret_cast<const char*>(p + 13));
+        if (p[10] < EVENT_RULE_CAPACITY) ruleIds[p[10]] = id >= 0 ? static_cast<uint8_t>(id) : ScheduledEvent::NoRule;
+        break;
+    }
+    case RuleRemoved:
+        if (p[0] < EVENT_RULE_CAPACITY && ruleIds[p[0]] != ScheduledEvent::NoRule) {
+            manager.removeRule(ruleIds[p[0]]);
+            ruleIds[p[0]] = ScheduledEvent::NoRule;
+        }
+        break;
+    case ScenarioRemoved:
+        manager.removeScenario(p[0]);
+        break;
+    case ScenarioRescheduled: {
+        int32_t offsetSeconds;
+        memcpy(&offsetSeconds, p + 1, sizeof(offsetSeconds));
+        manager.rescheduleScenario(p[0], offsetSeconds);
+        break;
+    }
+    case Cleared:
+        manager.clearEvents();
+        break;
+    default:
+        break;  // End, or a record type from a newer firmware
+    }
+}
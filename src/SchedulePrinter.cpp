@@ -0,0 +1,55 @@
+// SchedulePrinter.cpp
+#include "SchedulePrinter.h"
+
+SchedulePrinter::SchedulePrinter(const EventManager& manager, Print& out)
+    : manager(manager), out(out), nextTime(0), printed(0), active(false), headerDone(false) {}
+
+void SchedulePrinter::start() {
+    nextTime = 0;
+    printed = 0;
+    active = true;
+    headerDone = false;
+}
+
+bool SchedulePrinter::pump(uint32_t budgetUs) {
+    if (!active) return false;
+
+    unsigned long startMicros = micros();
+    if (!headerDone) {
+        out.println(F("Scheduled Events:"));
+        headerDone = true;
+    }
+
+    for (const EventManager::EventView& event : manager.eventsBetween(nextTime)) {
+        CivilTime t = CivilTime::fromEpoch(event.timeCode);
+        char line[112];
+        int length = snprintf(line, sizeof(line), "%04d-%02d-%02d %02d:%02d:%02d - Scenario: %d, Cycle: %d, Desc: %s",
+                              t.year, t.month, t.day, t.hour, t.minute, t.second, event.scenario, event.cycle,
+                              event.description);
+        if (length < 0) length = 0;
+        if (length >= static_cast<int>(sizeof(line))) length = sizeof(line) - 1;
+        if (event.rule != ScheduledEvent::NoRule) {
+            length += snprintf(line + length, sizeof(line) - length, ", Rule: %d", event.rule);
+            if (length >= static_cast<int>(sizeof(line))) length = sizeof(line) - 1;
+        }
+
+        // Targets that report their free space are never written into a full buffer
+        int room = out.availableForWrite();
+        if (room > 0 && room < length + 2) return true;
+
+        out.write(reinterpret_cast<const uint8_t*>(line), length);
+        out.println();
+        ++printed;
+        if (event.timeCode == EventManager::NoTimeCode) break;
+        nextTime = event.timeCode + 1;
+        if (micros() - startMicros >= budgetUs) return true;
+    }
+
+    out.printf("%u events\n", static_cast<unsigned>(printed));
+    active = false;
+    return false;
+}
+
+bool SchedulePrinter::isActive() const {
+    return active;
+}
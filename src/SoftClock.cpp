@@ -0,0 +1,119 @@
+// SoftClock.cpp
+#include "SoftClock.h"
+
+SoftClock::SoftClock(Source& source, uint32_t disciplineIntervalMs)
+    : source(source), disciplineIntervalMs(disciplineIntervalMs), anchorEpochMs(0), anchorMono(0),
+      driftPpm(0), driftMeasured(false), slewMs(0), lastReturnedMs(0), locked(false), seeking(false), seekEpoch(0),
+      lastPollMono(0), seekStartMono(0), lastEdgeEpoch(0), lastEdgeMono(0), lastErrorMs(0),
+      rtcReads(0) {}
+
+void SoftClock::begin(uint32_t monoMs) {
+    // Coarse anchor mid-way through the unknown sub-second phase until the first edge is found
+    uint32_t epoch = read();
+    anchorEpochMs = static_cast<uint64_t>(epoch) * 1000 + 500;
+    anchorMono = monoMs;
+    slewMs = 0;
+    lastReturnedMs = 0;
+    locked = false;
+    seeking = true;
+    seekEpoch = epoch;
+    lastPollMono = monoMs;
+    seekStartMono = monoMs;
+}
+
+void SoftClock::poll(uint32_t monoMs) {
+    if (!seeking) {
+        if (static_cast<int32_t>(monoMs - seekStartMono) < 0) return;
+        seekEpoch = read();
+        seeking = true;
+        lastPollMono = monoMs;
+        return;
+    }
+
+    uint32_t sinceLastPoll = monoMs - lastPollMono;
+    if (sinceLastPoll < EdgePollMs) return;
+
+    uint32_t epoch = read();
+    lastPollMono = monoMs;
+    if (epoch == seekEpoch) return;
+
+    if (sinceLastPoll > 2 * EdgePollMs) {
+        // The loop stalled between reads, so the edge position is too uncertain; wait for the next one
+        seekEpoch = epoch;
+        return;
+    }
+    onEdge(epoch, monoMs - sinceLastPoll / 2);
+}
+
+uint32_t SoftClock::msUntilNextPoll(uint32_t monoMs) const {
+    if (seeking) {
+        uint32_t sinceLastPoll = monoMs - lastPollMono;
+        return sinceLastPoll >= EdgePollMs ? 0 : EdgePollMs - sinceLastPoll;
+    }
+    int32_t untilSeek = static_cast<int32_t>(seekStartMono - monoMs);
+    return untilSeek > 0 ? static_cast<uint32_t>(untilSeek) : 0;
+}
+
+uint64_t SoftClock::nowMs(uint32_t monoMs) {
+    uint64_t value = extrapolate(monoMs);
+    if (value < lastReturnedMs) value = lastReturnedMs;
+    lastReturnedMs = value;
+    return value;
+}
+
+uint32_t SoftClock::read() {
+    ++rtcReads;
+    return source.readEpoch();
+}
+
+uint64_t SoftClock::extrapolate(uint32_t monoMs) const {
+    int64_t elapsed = static_cast<uint32_t>(monoMs - anchorMono);
+    int64_t scaled = elapsed - elapsed * driftPpm / 1000000;
+    int64_t slewLimit = elapsed / SlewDivisor;
+    int64_t applied = slewMs > 0 ? (slewMs < slewLimit ? slewMs : slewLimit)
+                                 : (-slewMs < slewLimit ? slewMs : -slewLimit);
+    return anchorEpochMs + scaled + applied;
+}
+
+void SoftClock::onEdge(uint32_t epoch, uint32_t edgeMono) {
+    uint64_t rtcMs = static_cast<uint64_t>(epoch) * 1000;
+    uint64_t current = extrapolate(edgeMono);  // Before the drift estimate changes, to stay continuous
+
+    if (locked) {
+        int64_t localElapsed = static_cast<uint32_t>(edgeMono - lastEdgeMono);
+        int64_t rtcElapsed = (static_cast<int64_t>(epoch) - lastEdgeEpoch) * 1000;
+        if (rtcElapsed >= 60000) {
+            int64_t ppm = (localElapsed - rtcElapsed) * 1000000 / rtcElapsed;
+            if (ppm > -1000 && ppm < 1000) {  // Reject estimates across an RTC adjustment
+                // The first measurement replaces the guess outright; later ones are smoothed
+                driftPpm = driftMeasured ? static_cast<int32_t>((driftPpm * 3 + ppm) / 4) : static_cast<int32_t>(ppm);
+                driftMeasured = true;
+            }
+        }
+    }
+
+    int64_t error = static_cast<int64_t>(rtcMs) - static_cast<int64_t>(current);
+    lastErrorMs = static_cast<int32_t>(error);
+
+    if (!locked || error > MaxSlewMs || error < -MaxSlewMs) {
+        anchorEpochMs = rtcMs;
+        slewMs = 0;
+        lastReturnedMs = 0;
+    } else {
+        anchorEpochMs = current;
+        slewMs = static_cast<int32_t>(error);
+    }
+    anchorMono = edgeMono;
+
+    locked = true;
+    seeking = false;
+    lastEdgeEpoch = epoch;
+    lastEdgeMono = edgeMono;
+
+    // The next search starts shortly before the first edge a discipline interval on,
+    // with extra lead for an unmeasured drift
+    int64_t spanMs = static_cast<int64_t>((disciplineIntervalMs + 999) / 1000) * 1000;
+    int64_t predictedMs = spanMs + spanMs * driftPpm / 1000000;
+    int64_t leadMs = EdgeLeadPolls * EdgePollMs + (driftMeasured ? 0 : spanMs * MaxDriftPpm / 1000000);
+    seekStartMono = edgeMono + static_cast<uint32_t>(predictedMs - leadMs);
+}
@@ -0,0 +1,119 @@
+// TimeService.cpp
+#include "TimeService.h"
+
+TimeService::TimeService(RTC_DS3231& rtc, uint32_t disciplineIntervalMs)
+    : rtc(rtc), clock(*this, disciplineIntervalMs), disciplineIntervalMs(disciplineIntervalMs), lastTickedSecond(0),
+      edgeCount(0), edgeMicros(0), waveLocked(false), baseEdgeCount(0), baseEpoch(0), lockedAtMs(0),
+      lastWaveMs(0) {}
+
+void TimeService::begin() {
+    clock.begin(millis());
+}
+
+#if defined(ESP32)
+bool TimeService::attachSquareWave(uint8_t interruptPin) {
+    rtc.writeSqwPinMode(DS3231_SquareWave1Hz);
+    pinMode(interruptPin, INPUT_PULLUP);
+    attachInterruptArg(digitalPinToInterrupt(interruptPin), &TimeService::onSquareWave, this, FALLING);
+    return true;
+}
+
+void IRAM_ATTR TimeService::onSquareWave(void* arg) {
+    TimeService* self = static_cast<TimeService*>(arg);
+    self->edgeMicros = micros();
+    self->edgeCount = self->edgeCount + 1;
+}
+#endif
+
+void TimeService::onSquareWaveEdge(uint32_t edgeUs) {
+    edgeMicros = edgeUs;
+    edgeCount = edgeCount + 1;
+}
+
+void TimeService::update() {
+    clock.poll(millis());
+
+    // Number the edges: the second read just after an edge is the one that edge started
+    uint32_t edges = edgeCount;
+    if (edges == 0) return;
+    bool due = !waveLocked || millis() - lockedAtMs >= disciplineIntervalMs;
+    if (!due || micros() - edgeMicros >= SquareWaveReadWindowUs) return;
+
+    TimeCode epoch = readEpoch();
+    if (edgeCount != edges) return;  // Another edge arrived during the read; try again after it
+    if (waveLocked && epoch != baseEpoch + (edges - baseEdgeCount)) {
+        lastWaveMs = 0;  // The RTC was set or edges were lost: step instead of holding the clock back
+    }
+    baseEpoch = epoch;
+    baseEdgeCount = edges;
+    lockedAtMs = millis();
+    waveLocked = true;
+}
+
+bool TimeService::hasSquareWaveLock() {
+    uint64_t ms;
+    return waveNowMs(ms);
+}
+
+// Time from the square wave, or false when it is not locked or has stopped.
+bool TimeService::waveNowMs(uint64_t& ms) {
+    if (!waveLocked) return false;
+
+    uint32_t edges;
+    uint32_t edgeUs;
+    do {
+        edges = edgeCount;
+        edgeUs = edgeMicros;
+    } while (edges != edgeCount);
+
+    uint32_t sinceEdgeUs = micros() - edgeUs;
+    if (sinceEdgeUs >= SquareWaveTimeoutUs) return false;
+
+    // An edge served late holds the clock at the end of the second rather than running past it
+    uint32_t withinSecond = sinceEdgeUs / 1000;
+    ms = static_cast<uint64_t>(baseEpoch + (edges - baseEdgeCount)) * 1000 + (withinSecond < 999 ? withinSecond : 999);
+    if (ms < lastWaveMs) ms = lastWaveMs;
+    lastWaveMs = ms;
+    return true;
+}
+
+TimeCode TimeService::now() {
+    return static_cast<TimeCode>(nowMs() / 1000);
+}
+
+uint64_t TimeService::nowMs() {
+    uint64_t softMs = clock.nowMs(millis());
+    uint64_t waveMs;
+    return waveNowMs(waveMs) ? waveMs : softMs;
+}
+
+DateTime TimeService::nowDateTime() {
+    return DateTime(now());
+}
+
+bool TimeService::secondTicked() {
+    TimeCode second = now();
+    if (second == lastTickedSecond) return false;
+    lastTickedSecond = second;
+    return true;
+}
+
+uint32_t TimeService::msUntilNextSecond() {
+    return 1000 - static_cast<uint32_t>(nowMs() % 1000);
+}
+
+uint32_t TimeService::msUntilNextPoll() const {
+    return clock.msUntilNextPoll(millis());
+}
+
+int32_t TimeService::getDriftPpm() const {
+    return clock.getDriftPpm();
+}
+
+uint32_t TimeService::getRtcReads() const {
+    return clock.getRtcReads();
+}
+
+uint32_t TimeService::readEpoch() {
+    return rtc.now().unixtime();
+}
@@ -2,21 +2,67 @@
 // Main Arduino sketch
 #include <Wire.h>
 #include "RTClib.h"
+#include "TimeService.h"
 #include "EventManager.h"
+#include "DeadlineTimer.h"
+#include "ScheduleImage.h"
 #include "OLEDManager.h"
+#include "RenderTask.h"
+#include "SchedulePrinter.h"
+#include "LatencyMonitor.h"
+#include "PhaseSequencer.h"
+#include "LampDriver.h"
+#include "ScheduleJournal.h"
 
 RTC_DS3231 rtc;
-EventManager eventManager(rtc);
+TimeService timeService(rtc);
+EventManager eventManager(timeService);
+EspTimerDeadline eventDeadline;
+ScheduleImage scheduleImage;
 OLEDManager oledManager;
+RenderTask renderTask(oledManager);
+SchedulePrinter schedulePrinter(eventManager, Serial);
+LatencyMonitor latencyMonitor(timeService);
+PhaseSequencer phaseSequencer;
+PhaseTimer phaseTimer(phaseSequencer);
+PartitionJournalStorage journalStorage;
+ScheduleJournal journal(eventManager, journalStorage);
 
-void onEventTriggered(const EventManager::Event& event) {
+// Signal states used by the phase tables
+enum SignalState : uint8_t { AllRed, MainGreen, MainAmber, SideGreen, SideAmber };
+
+static const Phase rushHourPhases[] = {
+    {PhaseSequencer::ticks(40000), MainGreen}, {PhaseSequencer::ticks(4000), MainAmber},
+    {PhaseSequencer::ticks(2000), AllRed},     {PhaseSequencer::ticks(20000), SideGreen},
+    {PhaseSequencer::ticks(4000), SideAmber},  {PhaseSequencer::ticks(2000), AllRed},
+};
+static const Phase offPeakPhases[] = {
+    {PhaseSequencer::ticks(25000), MainGreen}, {PhaseSequencer::ticks(3000), MainAmber},
+    {PhaseSequencer::ticks(2000), AllRed},     {PhaseSequencer::ticks(15000), SideGreen},
+    {PhaseSequencer::ticks(3000), SideAmber},  {PhaseSequencer::ticks(2000), AllRed},
+};
+static const CyclePlan rushHourPlan = {rushHourPhases, 6, 0};
+static const CyclePlan offPeakPlan = {offPeakPhases, 6, 0};
+
+// Lamp outputs, all on GPIO 0-31 so a state change is one masked port write
+enum LampPin : uint8_t {
+    MainRedPin = 27, MainAmberPin = 26, MainGreenPin = 25,
+    SideRedPin = 21, SideAmberPin = 19, SideGreenPin = 18
+};
+constexpr uint32_t lampBit(LampPin pin) { return 1UL << pin; }
+constexpr uint32_t MainMoving = lampBit(MainGreenPin) | lampBit(MainAmberPin);
+constexpr uint32_t SideMoving = lampBit(SideGreenPin) | lampBit(SideAmberPin);
+constexpr uint32_t BothRed = lampBit(MainRedPin) | lampBit(SideRedPin);
+constexpr uint32_t LampMask = MainMoving | SideMoving | BothRed;
+
+Esp32GpioPort lampPort;
+LampDriver lampDriver(lampPort, LampMask);
+
+void logEvent(const EventManager::Event& event, void*) {
     Serial.printf("Event triggered - Scenario: %d, Cycle: %d, Desc: %s\n",
         event.scenario,
         event.cycle,
-        event.description.c_str());
-    // Implement your traffic light control logic here
-    oledManager.displayEvent(event);
-    // Your other event handling code here
+        event.description());
 }
 
 void setup() {
@@ -33,37 +79,133 @@ void setup() {
         rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
     }
 
+    timeService.begin();
+#ifdef RTC_SQW_PIN
+    timeService.attachSquareWave(RTC_SQW_PIN);  // Millisecond timing from the DS3231's 1 Hz edge
+#endif
+
     if (!oledManager.begin()) {
         Serial.println("SSD1306 allocation failed");
         while (1);
     }
 
     eventManager.begin();
-    eventManager.setEventCallback(onEventTriggered);
+    EventDispatcher& dispatcher = eventManager.getDispatcher();
+    latencyMonitor.attach(dispatcher);  // First, so it sees each event before the other consumers
+    dispatcher.subscribe(logEvent, nullptr, EventFilter::all(), "serial");
+    // Drawn on the render core; never blocks the scheduler
+    dispatcher.subscribe<RenderTask, &RenderTask::publishEvent>(renderTask, EventFilter::all(), "display");
+    // Scenario and cycle of each event pick the phase plan from the next cycle boundary
+    phaseSequencer.setPlan(0, 0, &offPeakPlan);
+    phaseSequencer.setPlan(1, 1, &rushHourPlan);
+    phaseSequencer.setPlan(2, 1, &rushHourPlan);
+    phaseSequencer.setPlan(3, 1, &offPeakPlan);
+    phaseSequencer.setHandler(&LampDriver::onPhase, &lampDriver);
+    dispatcher.subscribe<PhaseSequencer, &PhaseSequencer::onEvent>(phaseSequencer, EventFilter::all(), "phases");
+    if (eventDeadline.begin()) {
+        eventManager.setDeadlineTimer(&eventDeadline);
+    }
     
-    // Add your events
-    eventManager.addEvent(2024, 7, 20, 7, 12, 0, 1, 1, "Morning Rush Hour");
-    eventManager.addEvent(0, 0, 0, 12, 42, 0, 2, 1, "Daily Evening Rush Hour", true);
+    // Use the flashed schedule image in place (built with tools/schedule_tool)
+    ScheduleImage::Status imageStatus = scheduleImage.openPartition("schedule");
+    if (imageStatus == ScheduleImage::Status::Ok) {
+        eventManager.loadImage(scheduleImage);
+    }
+
+    // Edits and the running scenario from before the restart, on top of the image
+    bool restored = journalStorage.begin("journal") && journal.begin() && journal.replay();
+    if (restored) {
+        Serial.printf("Journal replayed: %u records in %u us\n",
+                      static_cast<unsigned>(journal.getStats().replayedRecords),
+                      static_cast<unsigned>(journal.getStats().replayUs));
+    } else if (imageStatus != ScheduleImage::Status::Ok) {
+        Serial.printf("No schedule image (%s), using built-in events\n", ScheduleImage::statusName(imageStatus));
+        static const EventManager::EventSpec builtInPlan[] = {
+            {2024, 7, 20, 7, 12, 0, 1, 1, "Morning Rush Hour"},
+            {0, 0, 0, 12, 42, 0, 2, 1, "Daily Evening Rush Hour", true},
+        };
+        EventManager::BatchReport report = eventManager.addEvents(builtInPlan);
+        for (uint8_t i = 0; i < report.issueCount; i++) {
+            Serial.printf("Plan entry %u rejected (problem %u)\n", static_cast<unsigned>(report.issues[i].index),
+                          static_cast<unsigned>(report.issues[i].problem));
+        }
+        eventManager.addRule(RecurrenceRule::onWeekdays(RecurrenceRule::Weekend, 9, 0, 0), 3, 1, "Weekend Plan");
+    }
+    // Records are queued by the loop and written at low priority, never inside a callback
+    if (journal.attach(dispatcher)) {
+        journal.startWriterTask(0);
+    }
+
+    // Resume the plan that was running; with nothing restored this is plan 0, 0
+    if (!phaseSequencer.select(eventManager.getCurrentScenario(), eventManager.getCurrentCycle())) {
+        phaseSequencer.select(0, 0);
+    }
 
-    eventManager.printEvents();
+    schedulePrinter.start();  // Listed from loop(), a few lines per pass
 
+    // Lamps start all red; a conflicting green on the pins falls back to all red within 50 ms
+    lampDriver.addConflict(MainMoving, SideMoving);
+    lampDriver.setStatePattern(AllRed, BothRed);
+    lampDriver.setStatePattern(MainGreen, lampBit(MainGreenPin) | lampBit(SideRedPin));
+    lampDriver.setStatePattern(MainAmber, lampBit(MainAmberPin) | lampBit(SideRedPin));
+    lampDriver.setStatePattern(SideGreen, lampBit(SideGreenPin) | lampBit(MainRedPin));
+    lampDriver.setStatePattern(SideAmber, lampBit(SideAmberPin) | lampBit(MainRedPin));
+    lampDriver.setFailSafePattern(BothRed);
+    if (lampPort.begin(LampMask)) {
+        lampDriver.apply(AllRed);
+        lampDriver.startMonitor(50);
+    }
+
+    // Cycles are counted from local midnight, so controllers sharing a plan stay coordinated
+    if (phaseTimer.begin()) {
+        int64_t sinceMidnightUs = static_cast<int64_t>(timeService.nowMs() % 86400000ULL) * 1000;
+        phaseTimer.start(esp_timer_get_time() - sinceMidnightUs);
+    }
+
+    // The intro is only queued here; the render task plays it while scheduling runs
     if (oledManager.begin()) {
         oledManager.showTVTurnOnEffect();
     }
+
+    // From here on only the render task touches the display; the loop task schedules on core 1
+    renderTask.begin(0);
 }
 
 void loop() {
-    static unsigned long lastDisplayUpdate = 0;
-    unsigned long currentMillis = millis();
-
+    latencyMonitor.loopStarted();
+    timeService.update();
     eventManager.update();
 
-    // Update OLED display every second
-    if (currentMillis - lastDisplayUpdate >= 1000) {
-        DateTime now = rtc.now();
-        oledManager.displayTime(now);
-        lastDisplayUpdate = currentMillis;
+    // Update OLED display on each new second
+    if (timeService.secondTicked()) {
+        renderTask.publishTime(timeService.now());
     }
 
+    schedulePrinter.pump();
+
     // Other loop code...
+
+    latencyMonitor.loopFinished();
+
+    // Reports on request: 'l' prints latency CSV, 'L' sends the binary form, 'd' display traffic
+    if (Serial.available() > 0) {
+        int command = Serial.read();
+        if (command == 'l') {
+            latencyMonitor.printCsv(Serial);
+        } else if (command == 'L') {
+            latencyMonitor.writeBinary(Serial);
+        } else if (command == 'd') {
+            const OLEDManager::FlushStats& flushes = oledManager.getFlushStats();  // Snapshot from the render task
+            Serial.printf("Display: %u flushes, %u bytes sent, %u saved; last %u sent, %u saved in %u windows\n",
+                          static_cast<unsigned>(flushes.flushes), static_cast<unsigned>(flushes.bytesSent),
+                          static_cast<unsigned>(flushes.bytesSaved), static_cast<unsigned>(flushes.lastBytesSent),
+                          static_cast<unsigned>(flushes.lastBytesSaved), static_cast<unsigned>(flushes.lastWindows));
+        }
+    }
+
+    // Idle until the next event, the next clock poll or the next display second
+    uint32_t untilSecond = timeService.msUntilNextSecond();
+    uint32_t untilPoll = timeService.msUntilNextPoll();
+    uint32_t maxWait = untilSecond < untilPoll ? untilSecond : untilPoll;
+    eventManager.waitForNextEvent(schedulePrinter.isActive() ? 0 : maxWait);
 }
\ No newline at end of file
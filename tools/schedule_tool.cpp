@@ -0,0 +1,369 @@
+// schedule_tool.cpp
+// Host-side builder and checker for binary schedule images (see ScheduleImage.h).
+// Build: g++ -O2 -std=gnu++17 -Iinclude tools/schedule_tool.cpp src/ScheduleImage.cpp src/LabelTable.cpp -o schedule_tool
+//
+//   schedule_tool build schedule.csv schedule.bin   Validate the CSV and write an image
+//   schedule_tool check schedule.bin                Verify an image and print a summary
+//   schedule_tool dump schedule.bin                 Print an image back as CSV
+//
+// Flash the image into the "schedule" partition (offset from partitions.csv):
+//   esptool.py write_flash 0x290000 schedule.bin
+//
+// CSV lines (blank lines and lines starting with # are ignored; descriptions may not contain commas):
+//   event,2024-07-20,07:12:00,<scenario>,<cycle>,<description>
+//   rule,<days>,09:00:00,<scenario>,<cycle>,<description>[,<first date>,<last date>[,<every N weeks>]]
+// <days> is daily, weekdays, weekend or a list such as mon|wed|fri.
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "LabelTable.h"
+#include "ScheduleImage.h"
+
+namespace {
+
+// The device resolves every distinct description to a label table entry; entry 0 is the
+// empty description.
+constexpr size_t MaxDescriptions = LABEL_TABLE_CAPACITY - 1;
+
+struct Builder {
+    std::vector<ImageEvent> events;
+    std::vector<ImageRule> rules;
+    std::string strings;
+    std::map<std::string, uint16_t> offsets;  // Identical descriptions share one entry
+
+    bool intern(const std::string& text, uint16_t& offset) {
+        auto found = offsets.find(text);
+        if (found != offsets.end()) {
+            offset = found->second;
+            return true;
+        }
+        if (strings.size() + text.size() + 1 > 0x10000) return false;
+        offset = static_cast<uint16_t>(strings.size());
+        strings.append(text);
+        strings.push_back('\0');
+        offsets[text] = offset;
+        return true;
+    }
+};
+
+std::vector<std::string> split(const std::string& line, char separator) {
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, separator)) {
+        size_t first = field.find_first_not_of(" \t\r");
+        size_t last = field.find_last_not_of(" \t\r");
+        fields.push_back(first == std::string::npos ? "" : field.substr(first, last - first + 1));
+    }
+    return fields;
+}
+
+bool parseDate(const std::string& text, uint16_t& year, uint8_t& month, uint8_t& day) {
+    unsigned y, m, d;
+    char tail;
+    if (sscanf(text.c_str(), "%u-%u-%u%c", &y, &m, &d, &tail) != 3) return false;
+    if (y < 1970 || y > 2105 || m < 1 || m > 12 || d < 1) return false;
+    int32_t monthLength = CivilTime::daysFromCivil(m == 12 ? y + 1 : y, m == 12 ? 1 : m + 1, 1) -
+                          CivilTime::daysFromCivil(y, m, 1);
+    if (static_cast<int32_t>(d) > monthLength) return false;
+    year = static_cast<uint16_t>(y);
+    month = static_cast<uint8_t>(m);
+    day = static_cast<uint8_t>(d);
+    return true;
+}
+
+bool parseTime(const std::string& text, uint8_t& hour, uint8_t& minute, uint8_t& second) {
+    unsigned h, m, s;
+    char tail;
+    if (sscanf(text.c_str(), "%u:%u:%u%c", &h, &m, &s, &tail) != 3 || h > 23 || m > 59 || s > 59) return false;
+    hour = static_cast<uint8_t>(h);
+    minute = static_cast<uint8_t>(m);
+    second = static_cast<uint8_t>(s);
+    return true;
+}
+
+bool parseByte(const std::string& text, uint8_t& value) {
+    unsigned parsed;
+    char tail;
+    if (sscanf(text.c_str(), "%u%c", &parsed, &tail) != 1 || parsed > 255) return false;
+    value = static_cast<uint8_t>(parsed);
+    return true;
+}
+
+bool parseDays(const std::string& text, uint8_t& mask) {
+    static const char* const names[] = {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+    if (text == "daily") mask = RecurrenceRule::EveryDay;
+    else if (text == "weekdays") mask = RecurrenceRule::Weekdays;
+    else if (text == "weekend") mask = RecurrenceRule::Weekend;
+    else {
+        mask = 0;
+        for (const std::string& name : split(text, '|')) {
+            const char* const* found = std::find_if(std::begin(names), std::end(names),
+                                                    [&name](const char* n) { return name == n; });
+            if (found == std::end(names)) return false;
+            mask |= static_cast<uint8_t>(1 << (found - names));
+        }
+    }
+    return mask != 0;
+}
+
+bool parseLine(Builder& builder, const std::vector<std::string>& fields, std::string& error) {
+    if (fields.size() < 6) {
+        error = "expected at least 6 fields";
+        return false;
+    }
+    uint8_t hour, minute, second, scenario, cycle;
+    if (!parseTime(fields[2], hour, minute, second)) {
+        error = "bad time '" + fields[2] + "'";
+        return false;
+    }
+    if (!parseByte(fields[3], scenario) || !parseByte(fields[4], cycle)) {
+        error = "scenario and cycle must be 0-255";
+        return false;
+    }
+    uint16_t description;
+    if (!builder.intern(fields[5], description)) {
+        error = "string table full";
+        return false;
+    }
+
+    if (fields[0] == "event") {
+        uint16_t year;
+        uint8_t month, day;
+        if (fields.size() != 6 || !parseDate(fields[1], year, month, day)) {
+            error = "bad date '" + fields[1] + "'";
+            return false;
+        }
+        builder.events.push_back(ImageEvent{ScheduledEvent::encodeTime(year, month, day, hour, minute, second),
+                                            scenario, cycle, description});
+        return true;
+    }
+
+    if (fields[0] == "rule") {
+        uint8_t mask;
+        if (!parseDays(fields[1], mask)) {
+            error = "bad days '" + fields[1] + "'";
+            return false;
+        }
+        RecurrenceRule rule = RecurrenceRule::onWeekdays(mask, hour, minute, second);
+        if (fields.size() >= 8) {
+            uint16_t firstYear, lastYear;
+            uint8_t firstMonth, firstDay, lastMonth, lastDay;
+            if (!parseDate(fields[6], firstYear, firstMonth, firstDay) ||
+                !parseDate(fields[7], lastYear, lastMonth, lastDay)) {
+                error = "bad date range";
+                return false;
+            }
+            rule = rule.between(firstYear, firstMonth, firstDay, lastYear, lastMonth, lastDay);
+        }
+        if (fields.size() >= 9 && (!parseByte(fields[8], rule.intervalWeeks) || rule.intervalWeeks == 0)) {
+            error = "bad week interval";
+            return false;
+        }
+        if (fields.size() > 9 || !rule.isValid()) {
+            error = "invalid rule";
+            return false;
+        }
+        builder.rules.push_back(ImageRule{rule.secondOfDay, rule.firstDay, rule.lastDay, rule.weekdayMask,
+                                          rule.intervalWeeks, scenario, cycle, description, 0});
+        return true;
+    }
+
+    error = "unknown record kind '" + fields[0] + "'";
+    return false;
+}
+
+int build(const char* csvPath, const char* imagePath) {
+    std::ifstream csv(csvPath);
+    if (!csv) {
+        fprintf(stderr, "%s: cannot open\n", csvPath);
+        return 1;
+    }
+
+    Builder builder;
+    builder.strings.push_back('\0');  // Offset 0 is the empty description
+    builder.offsets[""] = 0;
+
+    std::string line;
+    int errors = 0;
+    for (unsigned lineNumber = 1; std::getline(csv, line); lineNumber++) {
+        std::vector<std::string> fields = split(line, ',');
+        if (fields.empty() || fields[0].empty() || fields[0][0] == '#') continue;
+        std::string error;
+        if (!parseLine(builder, fields, error)) {
+            fprintf(stderr, "%s:%u: %s\n", csvPath, lineNumber, error.c_str());
+            ++errors;
+        }
+    }
+
+    std::stable_sort(builder.events.begin(), builder.events.end(),
+                     [](const ImageEvent& a, const ImageEvent& b) { return a.timeCode < b.timeCode; });
+    for (size_t i = 1; i < builder.events.size(); i++) {
+        if (builder.events[i].timeCode == builder.events[i - 1].timeCode) {
+            CivilTime when = CivilTime::fromEpoch(builder.events[i].timeCode);
+            fprintf(stderr, "%s: two events at %04u-%02u-%02u %02u:%02u:%02u\n", csvPath, when.year, when.month,
+                    when.day, when.hour, when.minute, when.second);
+            ++errors;
+        }
+    }
+    size_t descriptions = builder.offsets.size() - 1;
+    if (descriptions > MaxDescriptions) {
+        fprintf(stderr, "%s: %zu distinct descriptions, the device label table holds %zu\n", csvPath,
+                descriptions, MaxDescriptions);
+        ++errors;
+    }
+    if (errors) {
+        fprintf(stderr, "%d error(s), no image written\n", errors);
+        return 1;
+    }
+
+    while (builder.strings.size() % 4) builder.strings.push_back('\0');
+
+    ImageHeader header = {};
+    header.magic = ScheduleImage::Magic;
+    header.version = ScheduleImage::Version;
+    header.headerSize = sizeof(ImageHeader);
+    header.eventCount = static_cast<uint32_t>(builder.events.size());
+    header.ruleCount = static_cast<uint32_t>(builder.rules.size());
+    header.stringsOffset = static_cast<uint32_t>(sizeof(ImageHeader) + builder.events.size() * sizeof(ImageEvent) +
+                                                 builder.rules.size() * sizeof(ImageRule));
+    header.stringsSize = static_cast<uint32_t>(builder.strings.size());
+
+    std::vector<uint8_t> image(header.stringsOffset + header.stringsSize);
+    uint8_t* cursor = image.data() + sizeof(ImageHeader);
+    if (!builder.events.empty()) memcpy(cursor, builder.events.data(), builder.events.size() * sizeof(ImageEvent));
+    cursor += builder.events.size() * sizeof(ImageEvent);
+    if (!builder.rules.empty()) memcpy(cursor, builder.rules.data(), builder.rules.size() * sizeof(ImageRule));
+    cursor += builder.rules.size() * sizeof(ImageRule);
+    memcpy(cursor, builder.strings.data(), builder.strings.size());
+
+    header.payloadCrc = ScheduleImage::crc32(image.data() + sizeof(ImageHeader), image.size() - sizeof(ImageHeader));
+    header.headerCrc = ScheduleImage::crc32(&header, offsetof(ImageHeader, headerCrc));
+    memcpy(image.data(), &header, sizeof(header));
+
+    std::ofstream out(imagePath, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+    if (!out) {
+        fprintf(stderr, "%s: write failed\n", imagePath);
+        return 1;
+    }
+    printf("%s: %u events, %u rules, %u string bytes, %zu bytes\n", imagePath, header.eventCount,
+           header.ruleCount, header.stringsSize, image.size());
+    return 0;
+}
+
+bool load(const char* imagePath, std::vector<uint32_t>& storage, ScheduleImage& image) {
+    std::ifstream in(imagePath, std::ios::binary | std::ios::ate);
+    if (!in) {
+        fprintf(stderr, "%s: cannot open\n", imagePath);
+        return false;
+    }
+    size_t size = static_cast<size_t>(in.tellg());
+    storage.assign((size + 3) / 4, 0);  // uint32_t storage keeps the view aligned
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(storage.data()), static_cast<std::streamsize>(size));
+
+    ScheduleImage::Status status = image.open(storage.data(), size);
+    if (status == ScheduleImage::Status::Ok) status = image.verify();
+    if (status != ScheduleImage::Status::Ok) {
+        fprintf(stderr, "%s: %s\n", imagePath, ScheduleImage::statusName(status));
+        return false;
+    }
+    return true;
+}
+
+void printTime(uint32_t secondOfDay) {
+    printf("%02u:%02u:%02u", static_cast<unsigned>(secondOfDay / 3600), static_cast<unsigned>(secondOfDay / 60 % 60),
+           static_cast<unsigned>(secondOfDay % 60));
+}
+
+void printDay(uint32_t day) {
+    CivilTime date = CivilTime::fromDays(day);
+    printf("%04u-%02u-%02u", date.year, date.month, date.day);
+}
+
+int check(const char* imagePath) {
+    std::vector<uint32_t> storage;
+    ScheduleImage image;
+    if (!load(imagePath, storage, image)) return 1;
+    std::set<std::string> descriptions;
+    for (uint32_t i = 0; i < image.eventCount(); i++) descriptions.insert(image.string(image.event(i).description));
+    for (uint32_t i = 0; i < image.ruleCount(); i++) descriptions.insert(image.string(image.rule(i).description));
+    descriptions.erase("");
+    if (descriptions.size() > MaxDescriptions) {
+        fprintf(stderr, "%s: %zu distinct descriptions, the device label table holds %zu\n", imagePath,
+                descriptions.size(), MaxDescriptions);
+        return 1;
+    }
+
+    printf("%s: ok, version %u, %u events, %u rules, %zu descriptions, %zu bytes\n", imagePath,
+           ScheduleImage::Version, image.eventCount(), image.ruleCount(), descriptions.size(), image.imageSize());
+    if (image.eventCount() > 0) {
+        printf("  first ");
+        printDay(image.event(0).timeCode / CivilTime::SecondsPerDay);
+        printf(", last ");
+        printDay(image.event(image.eventCount() - 1).timeCode / CivilTime::SecondsPerDay);
+        printf("\n");
+    }
+    return 0;
+}
+
+int dump(const char* imagePath) {
+    std::vector<uint32_t> storage;
+    ScheduleImage image;
+    if (!load(imagePath, storage, image)) return 1;
+
+    for (uint32_t i = 0; i < image.eventCount(); i++) {
+        const ImageEvent& event = image.event(i);
+        printf("event,");
+        printDay(event.timeCode / CivilTime::SecondsPerDay);
+        printf(",");
+        printTime(event.timeCode % CivilTime::SecondsPerDay);
+        printf(",%u,%u,%s\n", event.scenario, event.cycle, image.string(event.description));
+    }
+    static const char* const names[] = {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+    for (uint32_t i = 0; i < image.ruleCount(); i++) {
+        const ImageRule& rule = image.rule(i);
+        printf("rule,");
+        if (rule.weekdayMask == RecurrenceRule::EveryDay) printf("daily");
+        else if (rule.weekdayMask == RecurrenceRule::Weekdays) printf("weekdays");
+        else if (rule.weekdayMask == RecurrenceRule::Weekend) printf("weekend");
+        else {
+            for (int day = 0, first = 1; day < 7; day++) {
+                if (rule.weekdayMask & (1 << day)) {
+                    printf("%s%s", first ? "" : "|", names[day]);
+                    first = 0;
+                }
+            }
+        }
+        printf(",");
+        printTime(rule.secondOfDay);
+        printf(",%u,%u,%s", rule.scenario, rule.cycle, image.string(rule.description));
+        if (rule.firstDay != 0 || rule.lastDay != RecurrenceRule::Unbounded || rule.intervalWeeks != 1) {
+            printf(",");
+            printDay(rule.firstDay);
+            printf(",");
+            printDay(rule.lastDay);
+            printf(",%u", rule.intervalWeeks);
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc == 4 && strcmp(argv[1], "build") == 0) return build(argv[2], argv[3]);
+    if (argc == 3 && strcmp(argv[1], "check") == 0) return check(argv[2]);
+    if (argc == 3 && strcmp(argv[1], "dump") == 0) return dump(argv[2]);
+    fprintf(stderr, "usage: %s build <schedule.csv> <schedule.bin> | check <schedule.bin> | dump <schedule.bin>\n",
+            argv[0]);
+    return 2;
+}